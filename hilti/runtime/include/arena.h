@@ -0,0 +1,159 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hilti::rt {
+
+/**
+ * Region of memory that hands out many small allocations cheaply by bumping
+ * a pointer. Individual allocations are never freed; the arena releases all
+ * its memory at once when it's destroyed.
+ *
+ * Arenas are usually managed through `std::shared_ptr`, with
+ * `arena::Allocator` retaining a reference for each object allocated from
+ * it. That way, the arena's memory remains valid for as long as any of its
+ * objects are still alive.
+ */
+class Arena {
+public:
+    /**
+     * Constructor.
+     *
+     * @param max_size number of bytes after which the arena considers itself
+     * exhausted, meaning that callers should switch to allocating from the
+     * heap instead
+     * @param block_size size of the blocks of memory the arena reserves from the
+     * heap at a time
+     */
+    explicit Arena(size_t max_size, size_t block_size = static_cast<size_t>(64 * 1024))
+        : _max_size(max_size), _block_size(block_size) {}
+
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena(Arena&&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena& operator=(Arena&&) = delete;
+
+    /**
+     * Allocates memory from the arena. This always succeeds, even if the
+     * arena is exhausted.
+     *
+     * @param size number of bytes to allocate
+     * @param alignment alignment the memory must have
+     */
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        auto* p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(_next) + alignment - 1) & ~(alignment - 1));
+
+        if ( ! _next || p + size > _end )
+            return _allocateSlow(size, alignment);
+
+        _next = p + size;
+        _allocated += size;
+        return p;
+    }
+
+    /** Returns true if the arena has handed out at least its maximum size. */
+    bool isExhausted() const { return _allocated >= _max_size; }
+
+    /** Returns the number of bytes handed out so far. */
+    size_t allocated() const { return _allocated; }
+
+    /** Returns the number of bytes reserved from the heap so far. */
+    size_t reserved() const { return _reserved; }
+
+private:
+    void* _allocateSlow(size_t size, size_t alignment);
+
+    size_t _max_size;
+    size_t _block_size;
+    char* _next = nullptr;     // next free byte in current block
+    char* _end = nullptr;      // end of current block
+    std::vector<void*> _blocks; // all blocks reserved from the heap
+    size_t _allocated = 0;
+    size_t _reserved = 0;
+};
+
+namespace arena {
+
+/**
+ * Standard allocator taking memory from an arena. It keeps the arena alive
+ * for as long as any copies of the allocator exist, which `std::shared_ptr`
+ * retains along with objects created through `std::allocate_shared()`.
+ */
+template<typename T>
+class Allocator {
+public:
+    using value_type = T;
+
+    explicit Allocator(std::shared_ptr<Arena> arena) : _arena(std::move(arena)) {}
+
+    template<typename U>
+    Allocator(const Allocator<U>& other) : _arena(other._arena) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T))); }
+
+    void deallocate(T* /* p */, size_t /* n */) noexcept {
+        // Memory is released only with the arena.
+    }
+
+    template<typename U>
+    friend bool operator==(const Allocator& a, const Allocator<U>& b) {
+        return a._arena == b._arena;
+    }
+
+    template<typename U>
+    friend bool operator!=(const Allocator& a, const Allocator<U>& b) {
+        return a._arena != b._arena;
+    }
+
+private:
+    template<typename U>
+    friend class Allocator;
+
+    std::shared_ptr<Arena> _arena;
+};
+
+/**
+ * Activates an arena for the current thread's context during its lifetime.
+ * While active, the runtime allocates new reference-managed values from the
+ * arena as long as it's not exhausted. The previously active arena gets
+ * restored at destruction.
+ */
+class Scope {
+public:
+    /**
+     * Constructor.
+     *
+     * @param arena arena to activate; if null, no arena will be active
+     */
+    explicit Scope(std::shared_ptr<Arena> arena);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope(Scope&&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    Scope& operator=(Scope&&) = delete;
+
+private:
+    std::shared_ptr<Arena> _previous;
+};
+
+namespace detail {
+
+/**
+ * Returns the arena currently active for the calling thread's context, or
+ * null if there's none or it's exhausted.
+ */
+extern const std::shared_ptr<Arena>* current();
+
+} // namespace detail
+
+} // namespace arena
+
+} // namespace hilti::rt
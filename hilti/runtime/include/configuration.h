@@ -29,6 +29,16 @@ struct Configuration {
     /** Max. number of fibers cached for reuse. */
     unsigned int fiber_cache_size = 200;
 
+    /** Max. total size of swap buffers that each thread keeps pooled for reuse. */
+    size_t fiber_swap_buffer_pool_size = static_cast<size_t>(4 * 1024 * 1024);
+
+    /**
+     * Interval in seconds after which fibers return stack memory to the OS
+     * that has not been needed since the previous release. Zero disables
+     * releasing memory automatically.
+     */
+    double fiber_release_interval = 10.0;
+
     /**
      * Minimum stack size that a fiber must have left for use at beginning of a
      * function's execution. This should leave enough headroom for (1) the
@@ -38,6 +48,17 @@ struct Configuration {
      **/
     size_t fiber_min_stack_size = static_cast<size_t>(20 * 1024);
 
+    /**
+     * If true, functions that the code generator marks as not needing to
+     * suspend once their input is complete, such as Spicy's external parsing
+     * functions, execute directly on the caller's stack when called with a
+     * frozen input stream. That saves the overhead of running them inside a
+     * fiber. If such a function attempts to yield nevertheless, it receives
+     * a runtime error. Spicy parsers with filters attached let those run to
+     * completion directly instead of waiting for their output.
+     */
+    bool fiber_bypass_on_frozen_input = false;
+
     /** File where debug output is to be sent. Default is stderr. */
     std::optional<hilti::rt::filesystem::path> debug_out;
 
@@ -57,6 +78,13 @@ struct Configuration {
      **/
     bool enable_profiling = false;
 
+    /**
+     * If set, profiling writes the time spent in each call path of nested
+     * profilers to this file at termination, in the folded stack format
+     * used by flamegraph tools.
+     */
+    std::optional<hilti::rt::filesystem::path> profiling_stacks;
+
     /** Colon-separated list of debug streams to enable. Default comes from HILTI_DEBUG. */
     std::string debug_streams;
 
@@ -3,12 +3,14 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
 
+#include <hilti/rt/arena.h>
 #include <hilti/rt/fiber.h>
 #include <hilti/rt/threading.h>
 
@@ -61,6 +63,12 @@ struct Context {
 
     /** Current indent level for debug messages. */
     uint64_t debug_indent{};
+
+    /** Call tree nodes of currently active profilers, innermost last. */
+    std::vector<size_t> profiler_stack;
+
+    /** Arena to allocate new reference-managed values from, if any; see `arena::Scope`. */
+    std::shared_ptr<Arena> arena;
 };
 
 namespace context {
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 
@@ -21,20 +22,23 @@ public:
     void print(const std::string& stream, const std::string& msg);
     void enable(const std::string& streams);
 
-    bool isEnabled(const std::string& stream) { return _streams.find(stream) != _streams.end(); }
+    bool isEnabled(const std::string& stream) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _streams.find(stream) != _streams.end();
+    }
 
     void indent(const std::string& stream) {
-        if ( isEnabled(stream) )
-            _streams[stream] += 1;
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if ( auto i = _streams.find(stream); i != _streams.end() )
+            i->second += 1;
     }
 
     void dedent(const std::string& stream) {
-        if ( isEnabled(stream) ) {
-            auto& indent = _streams[stream];
+        std::lock_guard<std::mutex> lock(_mutex);
 
-            if ( indent > 0 )
-                indent -= 1;
-        }
+        if ( auto i = _streams.find(stream); i != _streams.end() && i->second > 0 )
+            i->second -= 1;
     }
 
 private:
@@ -42,6 +46,7 @@ private:
     std::ostream* _output = nullptr;
     std::unique_ptr<std::ofstream> _output_file;
     std::map<std::string, integer::safe<uint64_t>> _streams;
+    std::mutex _mutex; // protects `_streams` and serializes output from concurrent threads
 };
 
 } // namespace hilti::rt::detail
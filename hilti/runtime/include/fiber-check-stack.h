@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include <hilti/rt/context.h>
@@ -27,8 +28,23 @@ inline void checkStack() {
     if ( ++cnt % 2 != 0 )
         return;
 
-    if ( context::detail::get()->fiber.current->stackBuffer().liveRemainingSize() <
-         ::hilti::rt::configuration::detail::unsafeGet().fiber_min_stack_size )
+    const auto& fiber = context::detail::get()->fiber;
+    size_t remaining = 0;
+
+    if ( fiber.current->isMain() ) {
+        // On the main stack, we can check only while a resumable executes
+        // there directly (see `resumable::RunDirectly`), which records how
+        // deep it may go.
+        if ( ! fiber.main_stack_limit )
+            return;
+
+        auto sp = reinterpret_cast<const char*>(__builtin_frame_address(0));
+        remaining = (sp > fiber.main_stack_limit ? static_cast<size_t>(sp - fiber.main_stack_limit) : 0);
+    }
+    else
+        remaining = fiber.current->stackBuffer().liveRemainingSize();
+
+    if ( remaining < ::hilti::rt::configuration::detail::unsafeGet().fiber_min_stack_size )
         throw StackSizeExceeded("not enough stack space remaining");
 
     // Do additional book-keeping every 8th time.
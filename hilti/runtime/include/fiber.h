@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <csetjmp>
 #include <functional>
 #include <iostream>
@@ -43,6 +45,37 @@ namespace detail {
 /** Helper recording global stack resource usage. */
 extern void trackStack();
 
+/**
+ * Helper tracking how much of a stack has been touched, so that memory that
+ * is no longer needed can be returned to the OS.
+ */
+struct StackUsage {
+    size_t high_water = 0; /**< deepest usage seen since the last release */
+    size_t resident = 0;   /**< deepest usage seen that has not been released yet */
+
+    /** Records a stack depth that has been reached. */
+    void record(size_t size) {
+        if ( size > high_water )
+            high_water = size;
+
+        if ( size > resident )
+            resident = size;
+    }
+
+    /**
+     * Returns pages of a downwards-growing stack to the OS that are located
+     * deeper than both *keep* and the high-water mark recorded since the last
+     * release. The high-water mark is reset afterwards. Must only be called
+     * for a stack that's not currently executing.
+     *
+     * @param lower lowest address of the stack's memory region
+     * @param size size of the stack's memory region
+     * @param keep minimum number of bytes to retain at the top of the stack
+     * @return number of bytes released
+     */
+    size_t release(char* lower, size_t size, size_t keep);
+};
+
 /** Context-wide state for managing all fibers associated with that context. */
 struct FiberContext {
     FiberContext();
@@ -60,8 +93,32 @@ struct FiberContext {
     /** Fiber holding the shared stack (the fiber itself isn't used, just its stack memory) */
     std::unique_ptr<::Fiber> shared_stack;
 
+    /** Usage of the shared stack by all shared-stack fibers. */
+    StackUsage shared_stack_usage;
+
     /** Cache of previously used fibers available for reuse. */
     std::vector<std::unique_ptr<Fiber>> cache;
+
+    /**
+     * Swap buffers for saved stack content available for reuse, indexed by
+     * size class (i.e., a buffer's size in pages, minus one).
+     */
+    std::vector<std::vector<void*>> swap_buffer_pool;
+
+    /** Total size of all buffers in `swap_buffer_pool`. */
+    size_t swap_buffer_pool_size = 0;
+
+    /** Time when unused stack memory was last returned to the OS. */
+    std::chrono::steady_clock::time_point last_release = std::chrono::steady_clock::now();
+
+    /** True if the next resumable created is to execute directly on the current stack. */
+    bool run_directly = false;
+
+    /**
+     * While a resumable executes directly on the main stack, the lowest
+     * address that the stack may grow down to; null otherwise.
+     */
+    const char* main_stack_limit = nullptr;
 };
 
 /**
@@ -217,6 +274,16 @@ public:
     static void primeCache();
     static void reset();
 
+    /**
+     * Returns memory that the current context's fibers have not needed since
+     * the last call to the OS. That covers stack pages deeper than recent
+     * usage, both of the shared stack and of cached individual-stack fibers,
+     * as well as pooled swap buffers. This is called automatically as fibers
+     * finish, at most once per `Configuration::fiber_release_interval`. Must
+     * not be called from inside a fiber.
+     */
+    static void releaseMemory();
+
     struct Statistics {
         uint64_t total;
         uint64_t current;
@@ -224,6 +291,11 @@ public:
         uint64_t max;
         uint64_t max_stack_size;
         uint64_t initialized;
+        uint64_t cache_hits;   // number of fibers created from the cache
+        uint64_t cache_misses; // number of fibers created from scratch
+        uint64_t swap_size;    // bytes currently allocated for saved stack content, including pooled buffers
+        uint64_t swap_pooled;  // bytes of swap buffers currently pooled for reuse
+        uint64_t released;     // total bytes of stack memory returned to the OS
     };
 
     static Statistics statistics();
@@ -232,6 +304,8 @@ private:
     friend void ::__fiber_run_trampoline(void* argsp);
     friend void ::__fiber_switch_trampoline(void* argsp);
     friend void detail::trackStack();
+    friend struct FiberContext;
+    friend struct StackBuffer;
 
     enum class State { Init, Running, Aborting, Yielded, Idle, Finished };
 
@@ -247,6 +321,18 @@ private:
     /** Low-level switch from one fiber to another. */
     static void _executeSwitch(const char* tag, detail::Fiber* from, detail::Fiber* to);
 
+    /** Returns a swap buffer of a given size, reusing a pooled one if possible. */
+    static void* _allocateSwapBuffer(size_t size);
+
+    /** Returns a swap buffer to the pool for reuse, or frees it if the pool is full. */
+    static void _recycleSwapBuffer(void* buffer, size_t size);
+
+    /** Frees a swap buffer. */
+    static void _freeSwapBuffer(void* buffer, size_t size);
+
+    /** Frees all pooled swap buffers of a context, returning their total size. */
+    static size_t _clearSwapBufferPool(FiberContext* context);
+
     Type _type;
     State _state{State::Init};
     std::optional<Callback> _function;
@@ -262,6 +348,9 @@ private:
     /** Buffer for the fiber's stack when swapped out. */
     StackBuffer _stack_buffer;
 
+    /** Usage of the fiber's individual stack; unused for other types of fibers. */
+    StackUsage _stack_usage;
+
 #ifdef HILTI_HAVE_ASAN
     /** Additional tracking state that ASAN needs. */
     struct {
@@ -271,20 +360,39 @@ private:
     } _asan;
 #endif
 
-    // TODO: Usage of these isn't thread-safe. Should become "atomic" and
-    // move into global state.
-    inline static uint64_t _total_fibers;
-    inline static uint64_t _current_fibers;
-    inline static uint64_t _cached_fibers;
-    inline static uint64_t _max_fibers;
-    inline static uint64_t _max_stack_size;
-    inline static uint64_t _initialized; // number of trampolines run
+    // Statistics shared by all threads.
+    //
+    // TODO: Move into global state.
+    inline static std::atomic<uint64_t> _total_fibers;
+    inline static std::atomic<uint64_t> _current_fibers;
+    inline static std::atomic<uint64_t> _cached_fibers;
+    inline static std::atomic<uint64_t> _max_fibers;
+    inline static std::atomic<uint64_t> _max_stack_size;
+    inline static std::atomic<uint64_t> _initialized; // number of trampolines run
+    inline static std::atomic<uint64_t> _cache_hits;
+    inline static std::atomic<uint64_t> _cache_misses;
+    inline static std::atomic<uint64_t> _swap_size;
+    inline static std::atomic<uint64_t> _swap_pooled;
+    inline static std::atomic<uint64_t> _released;
 };
 
 std::ostream& operator<<(std::ostream& out, const Fiber& fiber);
 
 extern void yield();
 
+/**
+ * Returns true if the currently executing code runs inside a resumable that
+ * can yield. This is false on the main stack, and also for functions that a
+ * resumable executes directly on the caller's stack.
+ */
+extern bool canYield();
+
+/**
+ * Returns true if the next resumable is to execute its function directly on
+ * the current stack, consuming that request.
+ */
+extern bool takeRunDirectly();
+
 } // namespace detail
 
 /**
@@ -301,8 +409,13 @@ public:
      * @param f function to be executed
      */
     template<typename Function, typename = std::enable_if_t<std::is_invocable<Function, resumable::Handle*>::value>>
-    Resumable(Function f) : _fiber(detail::Fiber::create()) {
-        _fiber->init(std::move(f));
+    Resumable(Function f) {
+        if ( detail::takeRunDirectly() )
+            _direct = std::move(f);
+        else {
+            _fiber = detail::Fiber::create();
+            _fiber->init(std::move(f));
+        }
     }
 
     Resumable() = default;
@@ -358,6 +471,18 @@ public:
 
 private:
     void yielded();
+    void runDirectly();
+
+    // Restores the profilers that were active inside the function when it
+    // last yielded onto the context's stack of active profilers. Returns the
+    // size of that stack before doing so, to pass to `_saveProfilers()`.
+    size_t _restoreProfilers();
+
+    // Moves any profilers that the function left active on the context's
+    // stack into our own state, so that other functions running in the same
+    // context don't nest their measurements inside ours while we're
+    // suspended.
+    void _saveProfilers(size_t base);
 
     void checkFiber(const char* location) const {
         if ( ! _fiber )
@@ -365,10 +490,44 @@ private:
     }
 
     std::unique_ptr<detail::Fiber> _fiber;
+    std::optional<detail::Callback> _direct; // function to execute on the current stack instead of a fiber
     bool _done = false;
     std::optional<hilti::rt::any> _result;
+    std::vector<size_t> _profilers; // call tree nodes of profilers active while the function is suspended
 };
 
+namespace resumable {
+
+/**
+ * Directs the next `Resumable` created during the instance's life-time to
+ * execute its function directly on the current stack instead of inside a
+ * fiber. That saves fiber setup and stack switching for functions known to
+ * never suspend, such as parsers operating on input that's complete
+ * already. If the function attempts to yield nevertheless, it receives a
+ * `RuntimeError`. Any further resumables that the function creates itself
+ * use fibers as usual.
+ */
+class RunDirectly {
+public:
+    /**
+     * Constructor.
+     *
+     * @param enable if false, the instance has no effect
+     */
+    explicit RunDirectly(bool enable = true);
+    ~RunDirectly();
+
+    RunDirectly(const RunDirectly&) = delete;
+    RunDirectly(RunDirectly&&) = delete;
+    RunDirectly& operator=(const RunDirectly&) = delete;
+    RunDirectly& operator=(RunDirectly&&) = delete;
+
+private:
+    bool _old;
+};
+
+} // namespace resumable
+
 namespace resumable::detail {
 
 /** Helper to deep-copy `Resumable` arguments in preparation for moving them to the heap. */
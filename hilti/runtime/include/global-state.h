@@ -4,6 +4,7 @@
 #include <sys/resource.h>
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -55,8 +56,11 @@ struct GlobalState {
     /** Resource usage at library initialization time. */
     ResourceUsage resource_usage_init;
 
-    /** Profiler's global measurements. */
-    std::unordered_map<std::string, profiler::detail::MeasurementState> profilers;
+    /** Profiler's global measurements, indexed by profiler ID. */
+    std::vector<profiler::detail::MeasurementState> profilers;
+
+    /** Profiler's call tree, with the root at index 0. */
+    std::vector<profiler::detail::CallPathState> profiler_paths;
 
     /** Debug logger recording runtime diagnostics. */
     std::unique_ptr<hilti::rt::detail::DebugLogger> debug_logger;
@@ -73,8 +77,16 @@ struct GlobalState {
      */
     std::vector<hilti::rt::detail::HiltiModule> hilti_modules;
 
-    /** Cache of already compiled regular expressions. */
+    /**
+     * Cache of already compiled regular expressions. Compiled expressions
+     * aren't safe to share across threads because matching builds their DFAs
+     * on demand, so entries created while a virtual thread's context is
+     * current are kept separate per thread.
+     */
     std::unordered_map<std::string, std::shared_ptr<regexp::detail::CompiledRegExp>> regexp_cache;
+
+    /** Protects access to `regexp_cache`. */
+    std::mutex regexp_cache_mutex;
 };
 
 /**
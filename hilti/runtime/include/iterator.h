@@ -2,7 +2,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <iterator>
+#include <type_traits>
+#include <utility>
 
 #include <hilti/rt/exception.h>
 
@@ -28,7 +32,170 @@ private:
     const T& _t;
 };
 
+/**
+ * Control block shared between a container and the iterators it hands out,
+ * which lets iterators detect when the container has gone away or has been
+ * modified in a way that invalidates them. Modifications bump a generation
+ * counter that iterators compare against the one they were created with, so
+ * invalidating iterators does not require allocating a new block.
+ */
+template<typename T>
+struct Control {
+    explicit Control(T* container) : container(container) {}
+
+    T* container;                         /**< bound container, or null once it has been destroyed */
+    uint64_t generation = 0;              /**< incremented each time existing iterators get invalidated */
+    std::atomic<uint64_t> references = 1; /**< number of references, including the container's own */
+
+    void ref() { references.fetch_add(1, std::memory_order_relaxed); }
+
+    void unref() {
+        if ( references.fetch_sub(1, std::memory_order_acq_rel) == 1 )
+            delete this;
+    }
+};
+
+/**
+ * An iterator's reference to the control block of its container. Checking
+ * validity through it involves only plain reads.
+ */
+template<typename T>
+class ControlRef {
+public:
+    ControlRef() = default;
+
+    ControlRef(Control<T>* control) : _control(control), _generation(control ? control->generation : 0) {
+        if ( _control )
+            _control->ref();
+    }
+
+    ControlRef(const ControlRef& other) : _control(other._control), _generation(other._generation) {
+        if ( _control )
+            _control->ref();
+    }
+
+    ControlRef(ControlRef&& other) noexcept : _control(other._control), _generation(other._generation) {
+        other._control = nullptr;
+    }
+
+    ~ControlRef() {
+        if ( _control )
+            _control->unref();
+    }
+
+    ControlRef& operator=(const ControlRef& other) {
+        if ( &other == this )
+            return *this;
+
+        if ( other._control )
+            other._control->ref();
+
+        if ( _control )
+            _control->unref();
+
+        _control = other._control;
+        _generation = other._generation;
+        return *this;
+    }
+
+    ControlRef& operator=(ControlRef&& other) noexcept {
+        if ( &other == this )
+            return *this;
+
+        if ( _control )
+            _control->unref();
+
+        _control = other._control;
+        _generation = other._generation;
+        other._control = nullptr;
+        return *this;
+    }
+
+    /** Returns the bound container if iterators into it are still valid, or null otherwise. */
+    T* get() const { return _control && _control->generation == _generation ? _control->container : nullptr; }
+
+    /** Returns true if a reference is still valid. */
+    explicit operator bool() const { return get() != nullptr; }
+
+    /** Returns true if both references are valid and bound to the same container, or both are invalid. */
+    friend bool operator==(const ControlRef& a, const ControlRef& b) { return a.get() == b.get(); }
+    friend bool operator!=(const ControlRef& a, const ControlRef& b) { return a.get() != b.get(); }
+
+private:
+    Control<T>* _control = nullptr;
+    uint64_t _generation = 0;
+};
+
+/**
+ * A container's handle to its control block. The block gets allocated
+ * lazily once the container hands out its first iterator, so that
+ * containers never iterated over don't pay for it. Copies of a container
+ * get their own block. Iterators survive in-place modification of the
+ * container, but assigning to the container or moving from it invalidates
+ * them.
+ */
+template<typename T>
+class ControlOwner {
+public:
+    ControlOwner() = default;
+    ControlOwner(const ControlOwner& /* other */) {}
+    ControlOwner(ControlOwner&& other) noexcept { other.invalidate(); }
+
+    ~ControlOwner() {
+        if ( auto* c = _control.load(std::memory_order_acquire) ) {
+            c->container = nullptr;
+            c->unref();
+        }
+    }
+
+    ControlOwner& operator=(const ControlOwner& /* other */) {
+        invalidate();
+        return *this;
+    }
+
+    ControlOwner& operator=(ControlOwner&& other) noexcept {
+        invalidate();
+        other.invalidate();
+        return *this;
+    }
+
+    /**
+     * Returns the control block for iterators, allocating it on first use.
+     *
+     * @param container the container owning this instance
+     */
+    Control<T>* get(const T* container) const {
+        if ( auto* c = _control.load(std::memory_order_acquire) )
+            return c;
+
+        // Another thread may race us here for constants shared across threads.
+        auto* c = new Control<T>(const_cast<T*>(container)); // NOLINT
+        Control<T>* current = nullptr;
+        if ( _control.compare_exchange_strong(current, c, std::memory_order_acq_rel) )
+            return c;
+
+        delete c;
+        return current;
+    }
+
+    /** Invalidates all iterators handed out so far. */
+    void invalidate() {
+        if ( auto* c = _control.load(std::memory_order_acquire) )
+            ++c->generation;
+    }
+
+private:
+    mutable std::atomic<Control<T>*> _control{nullptr};
+};
+
+template<typename T, typename = void>
+struct HasUnchecked : std::false_type {};
+
+template<typename T>
+struct HasUnchecked<T, std::void_t<decltype(std::declval<const T&>().unchecked())>> : std::true_type {};
+
 } // namespace iterator::detail
+
 /**
  * Wrapper that returns an object suitable to operate
  * range-based for loop on to iterator over a sequence.
@@ -37,4 +204,21 @@ template<typename T>
 auto range(const T& t) {
     return iterator::detail::Range(t);
 }
+
+/**
+ * Wrapper that returns an object suitable to operate a range-based for loop
+ * on for iterating over a container without the safety checks of its HILTI
+ * iterators. This must only be used if the container is guaranteed to
+ * neither be modified nor destroyed during the iteration. Debug builds
+ * always keep the checks.
+ */
+template<typename T>
+const auto& range_unchecked(const T& t) {
+#ifdef NDEBUG
+    if constexpr ( iterator::detail::HasUnchecked<T>::value )
+        return t.unchecked();
+    else
+#endif
+        return t;
+}
 } // namespace hilti::rt
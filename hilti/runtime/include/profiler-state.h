@@ -2,10 +2,18 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <unordered_map>
 
 namespace hilti::rt::profiler {
 
+/**
+ * Interned identifier of a block of code to profile. IDs are handed out by
+ * `intern()` and remain valid for the lifetime of the process.
+ */
+using ID = uint32_t;
+
 /**
  * A measurement taken by the profiler.  We use this both for absolute
  * snapshots at a given point of time, as well as as for deltas between two
@@ -45,6 +53,19 @@ struct MeasurementState {
     uint64_t instances = 0;
 };
 
+// Node of the call tree, representing one path of nested profilers. Index 0
+// of the tree is its root, which doesn't correspond to any profiler.
+struct CallPathState {
+    ID id = 0;                               // profiler ending the path
+    size_t parent = 0;                       // index of parent node
+    Measurement m = {};                      // inclusive measurements taken for this path
+    uint64_t children_time = 0;              // time spent inside nested paths
+    std::unordered_map<ID, size_t> children; // indices of nested paths by their profiler ID
+
+    // Returns the time spent in this path excluding nested paths.
+    uint64_t selfTime() const { return m.time > children_time ? m.time - children_time : 0; }
+};
+
 } // namespace detail
 
 } // namespace hilti::rt::profiler
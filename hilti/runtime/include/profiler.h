@@ -4,8 +4,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <optional>
+#include <ostream>
 #include <string>
+#include <string_view>
 
 #include <hilti/rt/configuration.h>
 #include <hilti/rt/global-state.h>
@@ -17,11 +20,26 @@ class Profiler;
 
 namespace profiler {
 
+std::optional<Profiler> start(ID id);
 std::optional<Profiler> start(std::string_view name);
 void stop(std::optional<Profiler>& p);
 
+/**
+ * Returns the ID associated with a block of code's name, assigning a new one
+ * on first use. Looking up an ID is more expensive than starting a profiler
+ * with it, so code that runs frequently should look up its IDs once upfront
+ * and then pass them to `start()`.
+ *
+ * @param name descriptive, unique name of the block of code to profile
+ * @return ID representing the name
+ */
+ID intern(std::string_view name);
+
 namespace detail {
 
+// Marker for an ID representing no profiler.
+inline constexpr ID NoID = std::numeric_limits<ID>::max();
+
 // Internal initialization function, called from library's `init()` when
 // profiling has been requested.
 extern void init();
@@ -52,19 +70,32 @@ public:
     Profiler() = default;
 
     Profiler(const Profiler& other) = delete;
-    Profiler(Profiler&& other) = default;
+    Profiler(Profiler&& other) noexcept : _id(other._id), _node(other._node), _start(other._start) {
+        other._id = profiler::detail::NoID;
+        other._node = 0;
+    }
 
     /** Destructor concluding any pending measurement. */
     ~Profiler() { record(snapshot()); }
 
     Profiler& operator=(const Profiler& other) = delete;
-    Profiler& operator=(Profiler&& other) = default;
+    Profiler& operator=(Profiler&& other) noexcept {
+        if ( &other == this )
+            return *this;
+
+        _id = other._id;
+        _node = other._node;
+        _start = other._start;
+        other._id = profiler::detail::NoID;
+        other._node = 0;
+        return *this;
+    }
 
     /** Take final measurement and record the delta between first and final. */
     void record(const profiler::Measurement& end);
 
     /** Returns true if the profiler is currently taking an active measurement. */
-    operator bool() const { return ! _name.empty(); }
+    operator bool() const { return _id != profiler::detail::NoID; }
 
     /** Take and return a single measurement. */
     static profiler::Measurement snapshot();
@@ -74,18 +105,19 @@ protected:
      * Constructor starting a new measurement. Don't call directly, use
      * `profiler::start()` instead.
      *
-     * @param name descriptive, unique name of the block of code to profile
+     * @param id interned ID of the block of code to profile
      */
-    Profiler(std::string_view name) : _name(name), _start(snapshot()) { _register(); }
+    Profiler(profiler::ID id) : _id(id), _start(snapshot()) { _register(); }
 
 private:
-    friend std::optional<Profiler> profiler::start(std::string_view name);
+    friend std::optional<Profiler> profiler::start(profiler::ID id);
     friend void profiler::detail::done();
 
-    void _register() const;
+    void _register();
 
-    std::string _name;            // Name of block to profile; empty is not active.
-    profiler::Measurement _start; // Initial measurement at construction time.
+    profiler::ID _id = profiler::detail::NoID; // ID of block to profile; `NoID` if not active.
+    size_t _node = 0;                          // Index of call tree node for the active measurement; 0 if none.
+    profiler::Measurement _start;              // Initial measurement at construction time.
 };
 
 namespace profiler {
@@ -94,12 +126,26 @@ namespace profiler {
  * until either `profiler::stop()` is called with it, or until the profiler
  * instances goes out of scope, whatever comes first.
  *
+ * @param id interned ID of the block of code to profile, as returned by `intern()`
+ * @return profiler instance representing the active measurement
+ */
+inline std::optional<Profiler> start(ID id) {
+    if ( ::hilti::rt::detail::unsafeGlobalState()->profiling_enabled )
+        return Profiler(id);
+    else
+        return {};
+}
+
+/**
+ * Start profiling of a code block identified by name. This is a convenience
+ * version of `start(ID)` that interns the name on each call.
+ *
  * @param name descriptive, unique name of the block of code to profile.
  * @return profiler instance representing the active measurement
  */
 inline std::optional<Profiler> start(std::string_view name) {
     if ( ::hilti::rt::detail::unsafeGlobalState()->profiling_enabled )
-        return Profiler(name);
+        return start(intern(name));
     else
         return {};
 }
@@ -124,6 +170,16 @@ inline void stop(std::optional<Profiler>& p) {
  */
 std::optional<Measurement> get(const std::string& name);
 
+/**
+ * Writes out the time spent in each call path of nested profilers, in the
+ * folded stack format that flamegraph tools consume. Each line lists the
+ * names of a path's profilers, separated by semicolons, followed by the
+ * time spent in the innermost one excluding any further nested profilers.
+ *
+ * @param out stream to write to
+ */
+extern void writeFoldedStacks(std::ostream& out);
+
 /** Produce end-of-process summary profiling report. */
 extern void report();
 
@@ -1102,6 +1102,12 @@ public:
             return Value();
     }
 
+    /**
+     * Returns the 1-based index of the union's currently set field, or zero
+     * if there's no field set currently.
+     */
+    std::size_t index(const Value& v) const { return _accessor(v); }
+
     template<typename T>
     static auto accessor() {
         return [](const Value& v) -> std::size_t { return static_cast<const T*>(v.pointer())->index(); };
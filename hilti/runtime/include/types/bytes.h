@@ -48,26 +48,16 @@ class Iterator {
     using B = std::string;
     using difference_type = B::const_iterator::difference_type;
 
-    std::weak_ptr<B*> _control;
+    ::hilti::rt::iterator::detail::ControlRef<Bytes> _control;
     typename integer::safe<std::uint64_t> _index = 0;
 
 public:
     Iterator() = default;
 
-    Iterator(typename B::size_type index, std::weak_ptr<B*> control) : _control(std::move(control)), _index(index) {}
+    Iterator(typename B::size_type index, ::hilti::rt::iterator::detail::Control<Bytes>* control)
+        : _control(control), _index(index) {}
 
-    uint8_t operator*() const {
-        if ( auto&& l = _control.lock() ) {
-            auto&& data = static_cast<B&>(**l);
-
-            if ( _index >= data.size() )
-                throw IndexError(fmt("index %s out of bounds", _index));
-
-            return data[_index];
-        }
-
-        throw InvalidIterator("bound object has expired");
-    }
+    uint8_t operator*() const;
 
     template<typename T>
     auto& operator+=(const hilti::rt::integer::safe<T>& n) {
@@ -89,7 +79,7 @@ public:
         return Iterator{_index + n, _control};
     }
 
-    explicit operator bool() const { return static_cast<bool>(_control.lock()); }
+    explicit operator bool() const { return static_cast<bool>(_control); }
 
     auto& operator++() {
         ++_index;
@@ -103,7 +93,7 @@ public:
     }
 
     friend auto operator==(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different bytes");
         return a._index == b._index;
     }
@@ -111,36 +101,40 @@ public:
     friend bool operator!=(const Iterator& a, const Iterator& b) { return ! (a == b); }
 
     friend auto operator<(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different bytes");
         return a._index < b._index;
     }
 
     friend auto operator<=(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different bytes");
         return a._index <= b._index;
     }
 
     friend auto operator>(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different bytes");
         return a._index > b._index;
     }
 
     friend auto operator>=(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different bytes");
         return a._index >= b._index;
     }
 
     friend difference_type operator-(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot perform arithmetic with iterators into different bytes");
         return a._index - b._index;
     }
 
+private:
     friend class ::hilti::rt::Bytes;
+
+    Iterator(typename B::size_type index, ::hilti::rt::iterator::detail::ControlRef<Bytes> control)
+        : _control(std::move(control)), _index(index) {}
 };
 
 inline std::string to_string(const Iterator& /* i */, rt::detail::adl::tag /*unused*/) { return "<bytes iterator>"; }
@@ -226,11 +220,20 @@ public:
     /** Returns the bytes' data as a string instance. */
     const std::string& str() const& { return *this; }
 
+    /**
+     * Moves the bytes' data out into a string instance, leaving the
+     * instance empty. Any iterators become invalid.
+     */
+    std::string str() && {
+        invalidateIterators();
+        return std::move(static_cast<std::string&>(*this));
+    }
+
     /** Returns an iterator representing the first byte of the instance. */
-    const_iterator begin() const { return const_iterator(0U, _control); }
+    const_iterator begin() const { return const_iterator(0U, _control.get(this)); }
 
     /** Returns an iterator representing the end of the instance. */
-    const_iterator end() const { return const_iterator(size(), _control); }
+    const_iterator end() const { return const_iterator(size(), _control.get(this)); }
 
     /** Returns an iterator referring to the given offset. */
     const_iterator at(Offset o) const { return begin() + o; }
@@ -274,7 +277,7 @@ public:
      * @return a `Bytes` instance for the subrange
      */
     Bytes sub(const const_iterator& from, const const_iterator& to) const {
-        if ( from._control.lock() != to._control.lock() )
+        if ( from._control != to._control )
             throw InvalidArgument("start and end iterator cannot belong to different bytes");
 
         return sub(Offset(from - begin()), to._index);
@@ -537,11 +540,25 @@ public:
 
 private:
     friend bytes::Iterator;
-    std::shared_ptr<Base*> _control = std::make_shared<Base*>(static_cast<Base*>(this));
 
-    void invalidateIterators() { _control = std::make_shared<Base*>(static_cast<Base*>(this)); }
+    ::hilti::rt::iterator::detail::ControlOwner<Bytes> _control;
+
+    void invalidateIterators() { _control.invalidate(); }
 };
 
+inline uint8_t bytes::Iterator::operator*() const {
+    if ( auto* c = _control.get() ) {
+        auto&& data = c->str();
+
+        if ( _index >= data.size() )
+            throw IndexError(fmt("index %s out of bounds", _index));
+
+        return data[_index];
+    }
+
+    throw InvalidIterator("bound object has expired");
+}
+
 inline std::ostream& operator<<(std::ostream& out, const Bytes& x) {
     out << escapeBytes(x.str(), false);
     return out;
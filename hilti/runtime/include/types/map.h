@@ -37,7 +37,7 @@ template<typename K, typename V>
 class Iterator {
     using M = Map<K, V>;
 
-    std::weak_ptr<M*> _control;
+    ::hilti::rt::iterator::detail::ControlRef<M> _control;
     typename M::M::iterator _iterator;
 
 public:
@@ -46,7 +46,7 @@ public:
     friend class Map<K, V>;
 
     friend bool operator==(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different maps");
 
         return a._iterator == b._iterator;
@@ -55,7 +55,7 @@ public:
     friend bool operator!=(const Iterator& a, const Iterator& b) { return ! (a == b); }
 
     Iterator& operator++() {
-        if ( ! _control.lock() ) {
+        if ( ! _control ) {
             throw IndexError("iterator is invalid");
         }
 
@@ -72,9 +72,9 @@ public:
     const typename M::M::value_type* operator->() const { return &operator*(); }
 
     typename M::M::const_reference operator*() const {
-        if ( auto&& l = _control.lock() ) {
+        if ( auto* c = _control.get() ) {
             // Iterators to `end` cannot be dereferenced.
-            if ( _iterator == static_cast<const typename M::M&>(**l).cend() )
+            if ( _iterator == static_cast<const typename M::M&>(*c).cend() )
                 throw IndexError("iterator is invalid");
 
             return *_iterator;
@@ -86,7 +86,7 @@ public:
 private:
     friend class Map<K, V>;
 
-    Iterator(typename M::M::iterator iterator, const typename M::C& control)
+    Iterator(typename M::M::iterator iterator, ::hilti::rt::iterator::detail::Control<M>* control)
         : _control(control), _iterator(std::move(iterator)) {}
 };
 
@@ -94,14 +94,14 @@ template<typename K, typename V>
 class ConstIterator {
     using M = Map<K, V>;
 
-    std::weak_ptr<M*> _control;
+    ::hilti::rt::iterator::detail::ControlRef<M> _control;
     typename M::M::const_iterator _iterator;
 
 public:
     ConstIterator() = default;
 
     friend bool operator==(const ConstIterator& a, const ConstIterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different sets");
 
         return a._iterator == b._iterator;
@@ -110,7 +110,7 @@ public:
     friend bool operator!=(const ConstIterator& a, const ConstIterator& b) { return ! (a == b); }
 
     ConstIterator& operator++() {
-        if ( ! _control.lock() ) {
+        if ( ! _control ) {
             throw IndexError("iterator is invalid");
         }
 
@@ -127,9 +127,9 @@ public:
     const typename M::M::value_type* operator->() const { return &operator*(); }
 
     typename M::M::const_reference operator*() const {
-        if ( auto&& l = _control.lock() ) {
+        if ( auto* c = _control.get() ) {
             // Iterators to `end` cannot be dereferenced.
-            if ( _iterator == static_cast<const typename M::M&>(**l).cend() )
+            if ( _iterator == static_cast<const typename M::M&>(*c).cend() )
                 throw IndexError("iterator is invalid");
 
             return *_iterator;
@@ -141,7 +141,7 @@ public:
 private:
     friend class Map<K, V>;
 
-    ConstIterator(typename M::M::const_iterator iterator, const typename M::C& control)
+    ConstIterator(typename M::M::const_iterator iterator, ::hilti::rt::iterator::detail::Control<M>* control)
         : _control(control), _iterator(std::move(iterator)) {}
 };
 
@@ -172,10 +172,6 @@ template<typename K, typename V>
 class Map : protected std::map<K, V> {
 public:
     using M = std::map<K, V>;
-    using C = std::shared_ptr<Map<K, V>*>;
-
-    C _control = std::make_shared<Map<K, V>*>(this);
-
     using key_type = typename M::key_type;
     using value_type = typename M::value_type;
     using size_type = integer::safe<uint64_t>;
@@ -259,11 +255,17 @@ public:
     auto begin() const { return this->cbegin(); }
     auto end() const { return this->cend(); }
 
-    auto begin() { return iterator(static_cast<M&>(*this).begin(), _control); }
-    auto end() { return iterator(static_cast<M&>(*this).end(), _control); }
+    auto begin() { return iterator(static_cast<M&>(*this).begin(), _control.get(this)); }
+    auto end() { return iterator(static_cast<M&>(*this).end(), _control.get(this)); }
 
-    auto cbegin() const { return const_iterator(static_cast<const M&>(*this).begin(), _control); }
-    auto cend() const { return const_iterator(static_cast<const M&>(*this).end(), _control); }
+    auto cbegin() const { return const_iterator(static_cast<const M&>(*this).begin(), _control.get(this)); }
+    auto cend() const { return const_iterator(static_cast<const M&>(*this).end(), _control.get(this)); }
+
+    /**
+     * Returns the underlying standard container for iterating without
+     * safety checks, see `hilti::rt::range_unchecked()`.
+     */
+    const M& unchecked() const { return *this; }
 
     size_type size() const { return M::size(); }
 
@@ -301,10 +303,9 @@ private:
     friend map::Iterator<K, V>;
     friend map::ConstIterator<K, V>;
 
-    void invalidateIterators() {
-        // Update control block to invalidate all iterators previously created from it.
-        _control = std::make_shared<Map<K, V>*>(this);
-    }
+    void invalidateIterators() { _control.invalidate(); }
+
+    ::hilti::rt::iterator::detail::ControlOwner<Map> _control;
 }; // namespace hilti::rt
 
 namespace map {
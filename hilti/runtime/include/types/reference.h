@@ -9,6 +9,7 @@
 #include <variant>
 
 #include <hilti/rt/any.h>
+#include <hilti/rt/arena.h>
 #include <hilti/rt/extension-points.h>
 #include <hilti/rt/types/bytes.h>
 #include <hilti/rt/types/string.h>
@@ -19,6 +20,18 @@ namespace hilti::rt {
 
 namespace reference::detail {
 void __attribute__((noreturn)) throw_null();
+
+/**
+ * Allocates a new shared instance of `T`, taking its memory from the
+ * currently active arena if there is one.
+ */
+template<typename T, typename... Args>
+std::shared_ptr<T> make_shared(Args&&... args) {
+    if ( auto* arena = ::hilti::rt::arena::detail::current() )
+        return std::allocate_shared<T>(::hilti::rt::arena::Allocator<T>(*arena), std::forward<Args>(args)...);
+
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
 } // namespace reference::detail
 
 /** Base for classes that `ValueReference::self` can receive.  */
@@ -56,7 +69,7 @@ public:
      * Instantiates a reference containing a new value of `T` initialized to
      * its default value.
      */
-    ValueReference() : _ptr(std::make_shared<T>()) {}
+    ValueReference() : _ptr(reference::detail::make_shared<T>()) {}
 
     /**
      * Instantiates a reference containing a new value of `T` initialized to
@@ -64,7 +77,7 @@ public:
      *
      * @param t value to initialize new instance with
      */
-    ValueReference(T t) : _ptr(std::make_shared<T>(std::move(t))) {}
+    ValueReference(T t) : _ptr(reference::detail::make_shared<T>(std::move(t))) {}
 
     /**
      * Instantiates a new reference from an existing `std::shared_ptr` to a
@@ -84,7 +97,7 @@ public:
      */
     ValueReference(const ValueReference& other) {
         if ( auto ptr = other._get() )
-            _ptr = std::make_shared<T>(*ptr);
+            _ptr = reference::detail::make_shared<T>(*ptr);
         else
             _ptr = std::shared_ptr<T>();
     }
@@ -378,7 +391,7 @@ public:
      *
      * @param t initialization value
      */
-    explicit StrongReference(T t) : Base(std::make_shared<T>(std::move(t))) {}
+    explicit StrongReference(T t) : Base(reference::detail::make_shared<T>(std::move(t))) {}
 
     /** Instantiate an unset reference. */
     explicit StrongReference(std::nullptr_t) {}
@@ -459,7 +472,7 @@ public:
      * @param t value to allocate and then refer to
      */
     StrongReference& operator=(T other) {
-        Base::operator=(std::make_shared<T>(std::move(other)));
+        Base::operator=(reference::detail::make_shared<T>(std::move(other)));
         return *this;
     }
 
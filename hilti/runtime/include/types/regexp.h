@@ -3,6 +3,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -29,11 +30,13 @@ struct Flags {
     bool no_sub = false; /**< if true, compile without support for capturing sub-expressions */
     bool use_std =
         false; /**< if true, always use the standard matcher (for testing purposes; ignored if `no_sub` is set) */
+    bool eager = false; /**< if true, compute the complete DFA when compiling the pattern, instead of building it
+                           incrementally on demand while matching */
 
     /** Returns a string uniquely identifying the set of flags. */
     std::string cacheKey() const {
-        char key[2] = {no_sub ? '1' : '0', use_std ? '1' : '0'};
-        return std::string(key, 2);
+        char key[3] = {no_sub ? '1' : '0', use_std ? '1' : '0', eager ? '1' : '0'};
+        return std::string(key, 3);
     }
 };
 
@@ -143,6 +146,14 @@ public:
         return _jrx.get();
     }
 
+    /**
+     * Returns a version of the compiled patterns that's not anchored to the
+     * beginning of the data, and compiled without support for capturing
+     * sub-expressions. This is compiled lazily on first access; that's
+     * safe to do from multiple threads concurrently.
+     */
+    jrx_regex_t* jrxUnanchored() const;
+
 private:
     friend class rt::RegExp;
     friend class regexp::MatchState;
@@ -153,10 +164,13 @@ private:
 
     void _newJrx();
     void _compileOne(std::string pattern, int idx);
+    void _compileUnanchored() const;
 
     regexp::Flags _flags{};
     std::vector<std::string> _patterns;
     std::unique_ptr<jrx_regex_t, RegFree> _jrx;
+    mutable std::unique_ptr<jrx_regex_t, RegFree> _jrx_unanchored; // created on demand
+    mutable std::once_flag _jrx_unanchored_once;
 };
 
 } // namespace detail
@@ -227,9 +241,12 @@ public:
     /**
      * Searches a pattern within a bytes view and returns the matching part.
      * The expression is *not* considered anchored to the beginning of the data,
-     * it will be found at any position.
+     * it will be found at any position. If there are multiple matches, the
+     * left-most one is returned; if there are multiple matches starting at
+     * that position, the longest.
      *
-     * \note This method is currently quadratic in the size of *data*.
+     * Determining whether there's a match at all takes a single linear pass
+     * over *data*. If there is one, a second linear pass locates it.
      *
      * @return A tuple where the 1st element corresponds to the result of
      * `find()`. If that's larger than zero, the 2nd is the matching data.
@@ -257,6 +274,10 @@ private:
     // Backend for the searching and matching methods.
     int16_t _search_pattern(jrx_match_state* ms, const char* data, size_t len, int32_t* so, int32_t* eo) const;
 
+    // Returns true if the expression matches anywhere inside the data. This
+    // scans the data just once, without anchoring the expression.
+    bool _has_match(const char* data, size_t len) const;
+
     std::shared_ptr<regexp::detail::CompiledRegExp> _re;
 };
 
@@ -33,16 +33,16 @@ template<typename T>
 class Iterator {
     using S = Set<T>;
 
-    std::weak_ptr<S*> _control;
+    ::hilti::rt::iterator::detail::ControlRef<S> _control;
     typename S::V::iterator _iterator;
 
 public:
     Iterator() = default;
 
     typename S::reference operator*() const {
-        if ( auto&& l = _control.lock() ) {
+        if ( auto* c = _control.get() ) {
             // Iterators to `end` cannot be dereferenced.
-            if ( _iterator == static_cast<const std::set<T>&>(**l).end() )
+            if ( _iterator == static_cast<const std::set<T>&>(*c).end() )
                 throw IndexError("iterator is invalid");
 
             return *_iterator;
@@ -52,7 +52,7 @@ public:
     }
 
     Iterator& operator++() {
-        if ( ! _control.lock() )
+        if ( ! _control )
             throw IndexError("iterator is invalid");
 
         ++_iterator;
@@ -66,7 +66,7 @@ public:
     }
 
     friend bool operator==(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different sets");
 
         return a._iterator == b._iterator;
@@ -77,7 +77,7 @@ public:
 protected:
     friend class Set<T>;
 
-    Iterator(typename S::V::iterator iterator, const typename S::C& control)
+    Iterator(typename S::V::iterator iterator, ::hilti::rt::iterator::detail::Control<S>* control)
         : _control(control), _iterator(std::move(iterator)) {}
 };
 
@@ -108,10 +108,6 @@ template<typename T>
 class Set : protected std::set<T> {
 public:
     using V = std::set<T>;
-    using C = std::shared_ptr<Set<T>*>;
-
-    C _control = std::make_shared<Set<T>*>(this);
-
     using reference = const T&;
     using const_reference = const T&;
 
@@ -140,8 +136,14 @@ public:
      */
     bool contains(const T& t) const { return this->count(t); }
 
-    auto begin() const { return iterator(static_cast<const V&>(*this).begin(), empty() ? nullptr : _control); }
-    auto end() const { return iterator(static_cast<const V&>(*this).end(), empty() ? nullptr : _control); }
+    auto begin() const { return iterator(static_cast<const V&>(*this).begin(), empty() ? nullptr : _control.get(this)); }
+    auto end() const { return iterator(static_cast<const V&>(*this).end(), empty() ? nullptr : _control.get(this)); }
+
+    /**
+     * Returns the underlying standard container for iterating without
+     * safety checks, see `hilti::rt::range_unchecked()`.
+     */
+    const V& unchecked() const { return *this; }
 
     size_type size() const { return V::size(); }
 
@@ -153,8 +155,7 @@ public:
      * @return 1 if the element was in the set, 0 otherwise
      */
     size_type erase(const key_type& key) {
-        // Update control block to invalidate all iterators previously created from it.
-        _control = std::make_shared<Set<T>*>();
+        _control.invalidate();
 
         return static_cast<V&>(*this).erase(key);
     }
@@ -164,8 +165,7 @@ public:
      * This function invalidates all iterators into the set.
      */
     void clear() {
-        // Update control block to invalidate all iterators previously created from it.
-        _control = std::make_shared<Set<T>*>();
+        _control.invalidate();
 
         return static_cast<V&>(*this).clear();
     }
@@ -178,7 +178,7 @@ public:
      * */
     iterator insert(iterator hint, const T& value) {
         auto it = V::insert(hint._iterator, value);
-        return iterator(it, _control);
+        return iterator(it, _control.get(this));
     }
 
     // Methods of `std::set`. These methods *must not* cause any iterator invalidation.
@@ -189,6 +189,9 @@ public:
     friend bool operator!=(const Set& a, const Set& b) { return ! (a == b); }
 
     friend set::Iterator<T>;
+
+private:
+    ::hilti::rt::iterator::detail::ControlOwner<Set> _control;
 };
 
 namespace set {
@@ -73,6 +73,16 @@ struct Gap {
     size_t size;
 };
 
+// Represents data stored outside of the chunk, which `owner` keeps alive. If
+// `owner` has no control block (i.e., it merely aliases the data), the data
+// is borrowed: it remains valid only for as long as the chain holding the
+// chunk says so, and copies of the chunk copy the data.
+struct External {
+    const Byte* data;
+    size_t size;
+    std::shared_ptr<const void> owner;
+};
+
 /**
  * Represents one block of continuous data inside a stream instance. A
  * stream's *Chain* links multiple of these chunks to represent all of its
@@ -82,12 +92,18 @@ struct Gap {
  * amounts of data, storing it directly inside the instance instead of using
  * heap-allocated memory.
  *
+ * Chunks storing their data themselves may have spare capacity, which the
+ * chain uses to coalesce subsequent small appends into its last chunk. That
+ * never reallocates a chunk's storage, so pointers into its data remain
+ * valid.
+ *
  * All public methods of Chunk are constant. Modifications can be done only
  * be through the owning Chain (so that we can track changes there).
  */
 class Chunk {
 public:
     static const int SmallBufferSize = 32;
+    static const int CoalesceCapacity = 512; // storage reserved for new chunks receiving small appends
     using Array = std::pair<Size, std::array<Byte, SmallBufferSize>>;
     using Vector = std::vector<Byte>;
 
@@ -104,7 +120,19 @@ public:
     // Constructs a gap chunk which signifies empty data.
     Chunk(const Offset& o, size_t len) : _offset(o), _data(Gap{len}) {}
 
-    Chunk(const Chunk& other) : _offset(other._offset), _data(other._data) {}
+    // Constructs a chunk referencing external data without copying it. The
+    // data must remain valid for as long as `owner` is alive.
+    Chunk(const Offset& o, const Byte* d, size_t n, std::shared_ptr<const void> owner)
+        : _offset(o), _data(External{d, n, std::move(owner)}) {}
+
+    Chunk(const Chunk& other) : _offset(other._offset), _data(other._data) {
+        // Borrowed data may go away along with the original, so give the
+        // copy its own.
+        if ( auto* e = std::get_if<External>(&_data); e && e->owner.use_count() == 0 ) {
+            auto copy = Vector(e->data, e->data + e->size);
+            _data = std::move(copy);
+        }
+    }
     Chunk(Chunk&& other) noexcept
         : _offset(other._offset), _data(std::move(other._data)), _next(std::move(other._next)) {}
 
@@ -131,6 +159,8 @@ public:
         else if ( auto a = std::get_if<Vector>(&_data) ) {
             return a->data();
         }
+        else if ( auto a = std::get_if<External>(&_data) )
+            return a->data;
         else if ( std::holds_alternative<Gap>(_data) )
             throw MissingData("data is missing");
 
@@ -148,6 +178,8 @@ public:
         else if ( auto a = std::get_if<Vector>(&_data) ) {
             return a->data() + a->size();
         }
+        else if ( auto a = std::get_if<External>(&_data) )
+            return a->data + a->size;
         else if ( std::holds_alternative<Gap>(_data) )
             throw MissingData("data is missing");
 
@@ -159,6 +191,8 @@ public:
             return a->first;
         else if ( auto a = std::get_if<Vector>(&_data) )
             return a->size();
+        else if ( auto a = std::get_if<External>(&_data) )
+            return a->size;
         else if ( auto a = std::get_if<Gap>(&_data) )
             return a->size;
 
@@ -229,6 +263,30 @@ protected:
 
     void clearNext() { _next = nullptr; }
 
+    // Appends data to the chunk's existing storage if it has enough spare
+    // capacity left, without reallocating. Returns false if the data doesn't
+    // fit, or if the chunk doesn't store its data itself.
+    bool appendInPlace(const Byte* d, size_t n) {
+        if ( auto a = std::get_if<Array>(&_data) ) {
+            if ( a->first + n > SmallBufferSize )
+                return false;
+
+            std::copy(d, d + n, a->second.data() + a->first.Ref());
+            a->first += n;
+            return true;
+        }
+
+        if ( auto v = std::get_if<Vector>(&_data) ) {
+            if ( v->capacity() - v->size() < n )
+                return false;
+
+            v->insert(v->end(), d, d + n);
+            return true;
+        }
+
+        return false;
+    }
+
 private:
     inline Chunk _fromArray(const Offset& o, const char* d, const Size& n) {
         auto ud = reinterpret_cast<const Byte*>(d);
@@ -242,8 +300,8 @@ private:
         return Chunk(o, Chunk::Vector(ud, ud + n.Ref()));
     }
 
-    Offset _offset = 0;                     // global offset of 1st byte
-    std::variant<Array, Vector, Gap> _data; // content of this chunk
+    Offset _offset = 0;                               // global offset of 1st byte
+    std::variant<Array, Vector, External, Gap> _data; // content of this chunk
     const Chain* _chain = nullptr; // chain this chunk is part of, or null if not linked to a chain yet (non-owning;
                                    // will stay valid at least as long as the current chunk does)
     std::unique_ptr<Chunk> _next = nullptr; // next chunk in chain, or null if last
@@ -264,7 +322,10 @@ public:
     Chain() {}
 
     /** Moves a chunk and all its successors into a new chain. */
-    Chain(std::unique_ptr<Chunk> head) : _head(std::move(head)), _tail(_head->last()) { _head->setChain(this); }
+    Chain(std::unique_ptr<Chunk> head) : _head(std::move(head)), _tail(_head->last()) {
+        _head->setChain(this);
+        _index(_head.get());
+    }
 
     Chain(Chain&& other) = delete;
     Chain(const Chain& other) = delete;
@@ -306,6 +367,11 @@ public:
     void append(std::unique_ptr<Chunk> chunk);
     void append(Chain&& other);
 
+    // Appends a copy of raw data. If the last chunk has enough spare
+    // capacity, the data goes there; otherwise we start a new chunk, leaving
+    // room for subsequent small appends.
+    void append(const Byte* data, size_t len);
+
     void trim(const Offset& offset);
     void trim(const SafeConstIterator& i);
     void trim(const UnsafeConstIterator& i);
@@ -317,6 +383,8 @@ public:
         _head.reset();
         _head_offset = 0;
         _tail = nullptr;
+        _chunks.clear();
+        _chunks_begin = 0;
     }
 
     // Turns the chain into a freshly initialized state.
@@ -325,6 +393,8 @@ public:
         _head.reset();
         _head_offset = 0;
         _tail = nullptr;
+        _chunks.clear();
+        _chunks_begin = 0;
     }
 
     void freeze() {
@@ -350,6 +420,28 @@ private:
             throw Frozen("stream object can no longer be modified");
     }
 
+    // Adds a newly linked chunk and all its successors to the chunk index.
+    void _index(Chunk* c) {
+        for ( ; c; c = c->next() )
+            _chunks.push_back(c);
+    }
+
+    // Removes the first chunk from the chunk index. To keep repeated
+    // trimming cheap, we only advance the index's start here and compact
+    // the vector once the unused prefix makes up half of it.
+    void _unindexHead() {
+        assert(_chunks_begin < _chunks.size());
+
+        if ( ++_chunks_begin >= _chunks.size() / 2 ) {
+            _chunks.erase(_chunks.begin(), _chunks.begin() + static_cast<std::ptrdiff_t>(_chunks_begin));
+            _chunks_begin = 0;
+        }
+    }
+
+    // Finds the chunk containing *offset* through a binary search of the
+    // chunk index. Returns null if not found.
+    const Chunk* _lookupChunk(const Offset& offset) const;
+
     enum class State {
         Mutable, // content can be expanded an trimmed
         Frozen,  // content cannot be changed
@@ -371,6 +463,12 @@ private:
     // Always pointing to last chunk reachable from *head*, or null if chain
     // is empty; non-owning
     Chunk* _tail = nullptr;
+
+    // Index of all chunks in chain order, starting at position
+    // `_chunks_begin`, so that we can locate chunks by offset without walking
+    // the list; non-owning.
+    std::vector<Chunk*> _chunks;
+    size_t _chunks_begin = 0;
 };
 
 } // namespace detail
@@ -967,11 +1065,25 @@ inline void Chain::trim(const SafeConstIterator& i) {
 
 inline void Chain::trim(const UnsafeConstIterator& i) { trim(i.offset()); }
 
+inline const Chunk* Chain::_lookupChunk(const Offset& offset) const {
+    auto begin = _chunks.begin() + static_cast<std::ptrdiff_t>(_chunks_begin);
+
+    // Find the last chunk starting at or before the offset. With empty
+    // chunks sharing their start offset with a successor, this picks the
+    // successor.
+    auto i = std::upper_bound(begin, _chunks.end(), offset,
+                              [](const Offset& o, const Chunk* c) { return o < c->offset(); });
+
+    if ( i == begin )
+        return nullptr;
+
+    const auto* c = *(i - 1);
+    return c->inRange(offset) ? c : nullptr;
+}
+
 inline const Chunk* Chain::findChunk(const Offset& offset, const Chunk* hint_prev) const {
     _ensureValid();
 
-    const Chunk* c = _head.get();
-
     // A very common way this function gets called without `hint_prev` is
     // `Stream::unsafeEnd` via `Chain::unsafeEnd` in construction of an
     // `UnsafeConstIterator` from a `SafeConstIterator`; in this case the chunk
@@ -980,37 +1092,28 @@ inline const Chunk* Chain::findChunk(const Offset& offset, const Chunk* hint_pre
     if ( ! hint_prev )
         hint_prev = _tail;
 
-    if ( hint_prev && hint_prev->offset() <= offset )
-        c = hint_prev;
-
-    while ( c && ! c->inRange(offset) )
-        c = c->next();
+    // Sequential access usually stays inside the hinted chunk or moves on
+    // to its immediate successor; check those directly before falling back
+    // to the index.
+    if ( hint_prev && hint_prev->offset() <= offset ) {
+        if ( hint_prev->inRange(offset) )
+            return hint_prev;
 
-    if ( c && ! c->inRange(offset) )
-        return nullptr;
+        if ( const auto* next = hint_prev->next(); next && next->inRange(offset) )
+            return next;
+    }
 
-    return c;
+    return _lookupChunk(offset);
 }
 
 inline Chunk* Chain::findChunk(const Offset& offset, Chunk* hint_prev) {
     _ensureValid();
 
-    Chunk* c = _head.get();
-
-    // See comment above.
-    if ( ! hint_prev )
-        hint_prev = _tail;
-
-    if ( hint_prev && hint_prev->offset() <= offset )
-        c = hint_prev;
-
-    while ( c && ! c->inRange(offset) )
-        c = c->next();
-
     if ( _tail && offset > _tail->endOffset() )
         return _tail;
 
-    return c;
+    // The index holds non-const pointers, so this is safe.
+    return const_cast<Chunk*>(std::as_const(*this).findChunk(offset, static_cast<const Chunk*>(hint_prev)));
 }
 
 inline const Byte* Chain::data(const Offset& offset, Chunk* hint_prev) const {
@@ -1447,7 +1550,15 @@ private:
     std::tuple<bool, UnsafeConstIterator> _findBackward(const Bytes& needle, UnsafeConstIterator i) const;
 
     // Common backend for forward searching.
-    std::tuple<bool, UnsafeConstIterator> _findForward(const Bytes& v, UnsafeConstIterator n) const;
+    std::tuple<bool, UnsafeConstIterator> _findForward(const Bytes& v, UnsafeConstIterator n) const {
+        return _findForward(reinterpret_cast<const Byte*>(v.data()), v.size().Ref(), n);
+    }
+
+    // Common backend for forward searching of a needle in contiguous memory.
+    // This searches block-wise over the underlying chunks, handling needles
+    // straddling chunk boundaries.
+    std::tuple<bool, UnsafeConstIterator> _findForward(const Byte* needle, uint64_t needle_size,
+                                                       UnsafeConstIterator n) const;
 
     SafeConstIterator _begin;
     std::optional<SafeConstIterator> _end;
@@ -1597,13 +1708,17 @@ public:
     bool isEmpty() const { return _chain->size() == 0; }
 
     /**
-     * Appends the content of a bytes instance. This function does not invalidate iterators.
+     * Appends the content of a bytes instance, copying the data. Small
+     * amounts of data get coalesced into the stream's last chunk where
+     * possible. This function does not invalidate iterators.
      * @param data `Bytes` to append
      */
     void append(const Bytes& data);
 
     /**
-     * Appends the content of a bytes instance. This function does not invalidate iterators.
+     * Appends the content of a bytes instance, taking over its memory
+     * instead of copying the data where possible. The data always starts a
+     * new chunk. This function does not invalidate iterators.
      * @param data `Bytes` to append
      */
     void append(Bytes&& data);
@@ -1614,12 +1729,30 @@ public:
      */
     void append(std::unique_ptr<const Byte*> data);
 
-    /** Appends the content of a raw memory area, copying the data. This function does not invalidate iterators.
+    /**
+     * Appends the content of a raw memory area, copying the data. Small
+     * amounts of data get coalesced into the stream's last chunk where
+     * possible. This function does not invalidate iterators.
      * @param data pointer to the data to append. If this is nullptr and gap will be appended instead.
      * @param len length of the data to append
      */
     void append(const char* data, size_t len);
 
+    /**
+     * Appends the content of a raw memory area without copying it. The
+     * stream references the memory directly, keeping *owner* alive for as
+     * long as it does so. Very small amounts of data, or data without an
+     * owner, get copied instead. This function does not invalidate
+     * iterators.
+     *
+     * @param data pointer to the data to append. If this is nullptr and gap will be appended instead.
+     * @param len length of the data to append
+     * @param owner reference to whatever owns *data*; the data must remain valid and unchanged for as long as this is
+     * alive. If *owner* has no control block, the data is borrowed instead: the caller must `reset()` the stream
+     * before the data goes away, and copies of the stream get their own copy of it.
+     */
+    void append(const char* data, size_t len, std::shared_ptr<const void> owner);
+
     /**
      * Cuts off the beginning of the data up to, but excluding, a given
      * iterator. All existing iterators pointing beyond that point will
@@ -1630,6 +1763,15 @@ public:
      */
     void trim(const SafeConstIterator& i) { _chain->trim(i); }
 
+    /**
+     * Removes all data, returning the instance into the state of a newly
+     * created, empty stream. This invalidates all existing iterators.
+     */
+    void reset() {
+        _chain->invalidate();
+        _chain = make_intrusive<Chain>();
+    }
+
     /** Freezes the instance. When frozen, no further data can be appended. */
     void freeze() { _chain->freeze(); }
 
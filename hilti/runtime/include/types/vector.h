@@ -90,7 +90,7 @@ class Iterator {
     using V = Vector<T, Allocator>;
     friend V;
 
-    std::weak_ptr<V*> _control;
+    ::hilti::rt::iterator::detail::ControlRef<V> _control;
     typename V::size_type _index = 0;
 
 public:
@@ -102,7 +102,7 @@ public:
     using iterator_category = typename V::V::iterator::iterator_category;
 
     Iterator() = default;
-    Iterator(typename V::size_type&& index, const typename V::C& control)
+    Iterator(typename V::size_type&& index, ::hilti::rt::iterator::detail::Control<V>* control)
         : _control(control), _index(std::move(index)) {}
 
     reference operator*();
@@ -120,7 +120,7 @@ public:
     }
 
     friend bool operator==(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index == b._index;
     }
@@ -128,31 +128,31 @@ public:
     friend bool operator!=(const Iterator& a, const Iterator& b) { return ! (a == b); }
 
     friend auto operator<(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index < b._index;
     }
 
     friend auto operator<=(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index <= b._index;
     }
 
     friend auto operator>(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index > b._index;
     }
 
     friend auto operator>=(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index >= b._index;
     }
 
     friend difference_type operator-(const Iterator& a, const Iterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot perform arithmetic with iterators into different vectors");
         return a._index - b._index;
     }
@@ -167,7 +167,7 @@ template<typename T, typename Allocator>
 class ConstIterator {
     using V = Vector<T, Allocator>;
 
-    std::weak_ptr<Vector<T, Allocator>*> _control;
+    ::hilti::rt::iterator::detail::ControlRef<V> _control;
     typename V::size_type _index = 0;
 
 public:
@@ -179,7 +179,7 @@ public:
     using iterator_category = typename V::V::const_iterator::iterator_category;
 
     ConstIterator() = default;
-    ConstIterator(typename V::size_type&& index, const typename V::C& control)
+    ConstIterator(typename V::size_type&& index, ::hilti::rt::iterator::detail::Control<V>* control)
         : _control(control), _index(std::move(index)) {}
 
     const_reference operator*() const;
@@ -196,7 +196,7 @@ public:
     }
 
     friend bool operator==(const ConstIterator& a, const ConstIterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index == b._index;
     }
@@ -204,31 +204,31 @@ public:
     friend bool operator!=(const ConstIterator& a, const ConstIterator& b) { return ! (a == b); }
 
     friend auto operator<(const ConstIterator& a, const ConstIterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index < b._index;
     }
 
     friend auto operator<=(const ConstIterator& a, const ConstIterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index <= b._index;
     }
 
     friend auto operator>(const ConstIterator& a, const ConstIterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index > b._index;
     }
 
     friend auto operator>=(const ConstIterator& a, const ConstIterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot compare iterators into different vectors");
         return a._index >= b._index;
     }
 
     friend difference_type operator-(const ConstIterator& a, const ConstIterator& b) {
-        if ( a._control.lock() != b._control.lock() )
+        if ( a._control != b._control )
             throw InvalidArgument("cannot perform arithmetic with iterators into different vectors");
         return a._index - b._index;
     }
@@ -266,9 +266,6 @@ public:
     using iterator = vector::Iterator<T, Allocator>;
     using const_iterator = vector::ConstIterator<T, Allocator>;
 
-    using C = std::shared_ptr<Vector*>;
-    C _control = std::make_shared<Vector<T, Allocator>*>(this);
-
     Vector() = default;
 
     // Constructing from other `Vector` updates the data, but keeps the control block alive.
@@ -325,7 +322,7 @@ public:
         if ( i >= V::size() )
             throw IndexError(fmt("vector index %" PRIu64 " out of range", i));
 
-        return const_iterator(static_cast<size_type>(i), _control);
+        return const_iterator(static_cast<size_type>(i), _control.get(this));
     }
 
     /**
@@ -481,14 +478,20 @@ public:
         return pos;
     }
 
-    auto begin() { return iterator(0U, _control); }
-    auto end() { return iterator(size(), _control); }
+    auto begin() { return iterator(0U, _control.get(this)); }
+    auto end() { return iterator(size(), _control.get(this)); }
+
+    auto begin() const { return const_iterator(0U, _control.get(this)); }
+    auto end() const { return const_iterator(size(), _control.get(this)); }
 
-    auto begin() const { return const_iterator(0U, _control); }
-    auto end() const { return const_iterator(size(), _control); }
+    auto cbegin() const { return const_iterator(0U, _control.get(this)); }
+    auto cend() const { return const_iterator(size(), _control.get(this)); }
 
-    auto cbegin() const { return const_iterator(0U, _control); }
-    auto cend() const { return const_iterator(size(), _control); }
+    /**
+     * Returns the underlying standard container for iterating without
+     * safety checks, see `hilti::rt::range_unchecked()`.
+     */
+    const V& unchecked() const { return *this; }
 
     size_type size() const { return V::size(); }
 
@@ -506,6 +509,14 @@ public:
     friend bool operator==(const Vector& a, const Vector& b) {
         return static_cast<const V&>(a) == static_cast<const V&>(b);
     }
+
+private:
+    // Iterators survive in-place modification of the vector, so we never
+    // invalidate them explicitly. `ControlOwner` itself invalidates them on
+    // assignment and move, but our copy and move operations deliberately
+    // leave `_control` alone so that iterators also survive those, as
+    // documented above; they expire only when the vector goes away.
+    ::hilti::rt::iterator::detail::ControlOwner<Vector> _control;
 };
 
 namespace vector {
@@ -637,8 +648,8 @@ inline std::ostream& operator<<(std::ostream& out, const vector::ConstIterator<T
 
 template<typename T, typename Allocator>
 std::optional<std::reference_wrapper<Vector<T, Allocator>>> vector::Iterator<T, Allocator>::_container() const {
-    if ( auto l = _control.lock() ) {
-        return {std::ref(**l)};
+    if ( auto* c = _control.get() ) {
+        return {std::ref(*c)};
     }
 
     return std::nullopt;
@@ -661,8 +672,8 @@ typename vector::ConstIterator<T, Allocator>::const_reference vector::ConstItera
 
 template<typename T, typename Allocator>
 std::optional<std::reference_wrapper<Vector<T, Allocator>>> vector::ConstIterator<T, Allocator>::_container() const {
-    if ( auto l = _control.lock() ) {
-        return {std::ref(**l)};
+    if ( auto* c = _control.get() ) {
+        return {std::ref(*c)};
     }
 
     return std::nullopt;
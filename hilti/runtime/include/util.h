@@ -107,6 +107,11 @@ struct ResourceUsage {
     uint64_t max_fibers;           //< high-water mark for number of fibers in use
     uint64_t max_fiber_stack_size; //< global high-water mark for fiber stack size
     uint64_t cached_fibers;        //< number of fibers currently cached for reuse
+    uint64_t fiber_cache_hits;     //< number of fibers taken from the cache
+    uint64_t fiber_cache_misses;   //< number of fibers that had to be newly allocated
+    uint64_t fiber_swap_size;      //< bytes currently allocated for swapped out fiber stacks
+    uint64_t fiber_swap_pooled;    //< bytes of swap buffers currently pooled for reuse
+    uint64_t fiber_released;       //< total bytes of fiber stack memory returned to the OS
 };
 
 /** Returns statistics about the current resource uage. */
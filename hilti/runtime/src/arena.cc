@@ -0,0 +1,50 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <new>
+
+#include <hilti/rt/arena.h>
+#include <hilti/rt/context.h>
+
+using namespace hilti::rt;
+
+Arena::~Arena() {
+    for ( auto* b : _blocks )
+        ::operator delete(b);
+}
+
+void* Arena::_allocateSlow(size_t size, size_t alignment) {
+    // Requests that would waste a good part of a regular block get their
+    // own, leaving the current block in place for further use.
+    auto dedicated = (size > _block_size / 4);
+    auto block_size = (dedicated ? size : _block_size) + alignment;
+
+    auto* block = static_cast<char*>(::operator new(block_size));
+    _blocks.push_back(block);
+    _reserved += block_size;
+
+    auto* p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(block) + alignment - 1) & ~(alignment - 1));
+    _allocated += size;
+
+    if ( ! dedicated ) {
+        _next = p + size;
+        _end = block + block_size;
+    }
+
+    return p;
+}
+
+arena::Scope::Scope(std::shared_ptr<Arena> arena) {
+    auto& current = context::detail::get()->arena;
+    _previous = std::move(current);
+    current = std::move(arena);
+}
+
+arena::Scope::~Scope() { context::detail::get()->arena = std::move(_previous); }
+
+const std::shared_ptr<Arena>* arena::detail::current() {
+    auto* ctx = context::detail::get(true);
+    if ( ! ctx || ! ctx->arena || ctx->arena->isExhausted() )
+        return nullptr;
+
+    return &ctx->arena;
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <hilti/rt/init.h>
+#include <hilti/rt/types/bytes.h>
+
+using namespace hilti::rt;
+
+static void construct(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto data = std::string(state.range(0), 'x');
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto b = Bytes(data.data(), data.size());
+        benchmark::DoNotOptimize(b);
+    }
+
+    hilti::rt::done();
+}
+
+static void copy(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto b = Bytes(std::string(state.range(0), 'x'));
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto c = b;
+        benchmark::DoNotOptimize(c);
+    }
+
+    hilti::rt::done();
+}
+
+static void iterate(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto b = Bytes(std::string(state.range(0), 'x'));
+
+    for ( auto _ : state ) {
+        (void)_;
+        uint64_t sum = 0;
+        for ( auto i = b.begin(); i != b.end(); ++i )
+            sum += *i;
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    hilti::rt::done();
+}
+
+static void concatenate(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto b = Bytes(std::string(state.range(0), 'x'));
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto c = b + b;
+        benchmark::DoNotOptimize(c);
+    }
+
+    hilti::rt::done();
+}
+
+// Builds up bytes from many small pieces.
+static void append(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto b = Bytes(std::string(state.range(0), 'x'));
+
+    for ( auto _ : state ) {
+        (void)_;
+        Bytes c;
+
+        for ( int i = 0; i < 64; i++ )
+            c.append(b);
+
+        benchmark::DoNotOptimize(c);
+    }
+
+    state.SetBytesProcessed(state.iterations() * 64 * state.range(0));
+    hilti::rt::done();
+}
+
+// Mimics parsers extracting many small fields, most of which are never iterated over.
+static void extract_fields(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto b = Bytes(std::string(1024, 'x'));
+
+    for ( auto _ : state ) {
+        (void)_;
+        for ( uint64_t i = 0; i + 16 <= b.size(); i += 16 ) {
+            auto field = b.sub(i, i + 16);
+            benchmark::DoNotOptimize(field);
+        }
+    }
+
+    hilti::rt::done();
+}
+
+BENCHMARK(construct)->ArgName("size")->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(copy)->ArgName("size")->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(concatenate)->ArgName("size")->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(append)->ArgName("size")->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(iterate)->ArgName("size")->Arg(64)->Arg(1024);
+BENCHMARK(extract_fields);
+
+BENCHMARK_MAIN();
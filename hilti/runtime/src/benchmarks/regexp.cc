@@ -0,0 +1,99 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <hilti/rt/init.h>
+#include <hilti/rt/types/bytes.h>
+#include <hilti/rt/types/regexp.h>
+
+using namespace hilti::rt;
+
+// Returns input of the given size that contains many partial matches of
+// `23.*09`, but the only complete one at its very end.
+static Bytes make_input(int64_t size) {
+    std::string data;
+    data.reserve(size);
+
+    while ( static_cast<int64_t>(data.size()) < size - 4 )
+        data.append("x23y");
+
+    data.resize(size - 4, 'z');
+    data.append("2309");
+    return Bytes(std::move(data));
+}
+
+static void find_match_at_end(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto re = RegExp("23.*09", regexp::Flags{.no_sub = true});
+    auto data = make_input(state.range(0));
+
+    for ( auto _ : state ) {
+        (void)_;
+        benchmark::DoNotOptimize(re.find(data));
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    state.SetComplexityN(state.range(0));
+    hilti::rt::done();
+}
+
+static void find_no_match(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto re = RegExp("23.*ABC", regexp::Flags{.no_sub = true});
+    auto data = make_input(state.range(0));
+
+    for ( auto _ : state ) {
+        (void)_;
+        benchmark::DoNotOptimize(re.find(data));
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    state.SetComplexityN(state.range(0));
+    hilti::rt::done();
+}
+
+// Matches a short token anchored at the beginning of the data, the way
+// parsers extract regular expression fields.
+static void match_token(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto re = RegExp("[^ \\t\\r\\n]+", regexp::Flags{.no_sub = true});
+    auto data = Bytes("/index.html HTTP/1.1\r\n");
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto ms = re.tokenMatcher();
+        benchmark::DoNotOptimize(ms.advance(data, true));
+    }
+
+    hilti::rt::done();
+}
+
+// Matches one out of a set of alternative tokens, returning the ID of the
+// one that matched.
+static void match_token_set(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto re = RegExp({"GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "[A-Z]+"}, regexp::Flags{.no_sub = true});
+    auto data = Bytes("OPTIONS * HTTP/1.1\r\n");
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto ms = re.tokenMatcher();
+        benchmark::DoNotOptimize(ms.advance(data, true));
+    }
+
+    hilti::rt::done();
+}
+
+// Both searches take time linear in the size of the input.
+BENCHMARK(find_match_at_end)->ArgName("size")->RangeMultiplier(4)->Range(1024, 1024 * 1024)->Complexity(benchmark::oN);
+BENCHMARK(find_no_match)->ArgName("size")->RangeMultiplier(4)->Range(1024, 1024 * 1024)->Complexity(benchmark::oN);
+BENCHMARK(match_token);
+BENCHMARK(match_token_set);
+
+BENCHMARK_MAIN();
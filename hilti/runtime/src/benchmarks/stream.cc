@@ -0,0 +1,171 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <hilti/rt/init.h>
+#include <hilti/rt/types/bytes.h>
+#include <hilti/rt/types/stream.h>
+
+using namespace hilti::rt;
+
+// Returns a stream made up of the given number of chunks of the given size.
+// The last byte of the stream is a `!`, all others are `x`.
+static Stream make_stream(int64_t chunks, int64_t chunk_size) {
+    Stream s;
+
+    for ( int64_t i = 0; i < chunks; i++ ) {
+        auto data = std::string(chunk_size, 'x');
+        if ( i == chunks - 1 )
+            data.back() = '!';
+
+        // Moved data keeps its own chunk.
+        s.append(Bytes(std::move(data)));
+    }
+
+    return s;
+}
+
+static void append_small_chunks(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto data = std::string(state.range(0), 'x');
+
+    for ( auto _ : state ) {
+        (void)_;
+        Stream s;
+
+        for ( int i = 0; i < 1024; i++ )
+            s.append(data.data(), data.size());
+
+        benchmark::DoNotOptimize(s);
+    }
+
+    state.SetBytesProcessed(state.iterations() * 1024 * state.range(0));
+    hilti::rt::done();
+}
+
+static void append_bytes(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto data = Bytes(std::string(state.range(0), 'x'));
+
+    for ( auto _ : state ) {
+        (void)_;
+        Stream s;
+
+        for ( int i = 0; i < 1024; i++ )
+            s.append(data);
+
+        benchmark::DoNotOptimize(s);
+    }
+
+    state.SetBytesProcessed(state.iterations() * 1024 * state.range(0));
+    hilti::rt::done();
+}
+
+static void view_find_byte(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto s = make_stream(state.range(0), 64);
+    auto v = s.view();
+
+    for ( auto _ : state ) {
+        (void)_;
+        benchmark::DoNotOptimize(v.find('!'));
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 64);
+    hilti::rt::done();
+}
+
+static void view_find_bytes(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto s = make_stream(state.range(0), 64);
+    auto v = s.view();
+    auto needle = Bytes("xx!");
+
+    for ( auto _ : state ) {
+        (void)_;
+        benchmark::DoNotOptimize(v.find(needle));
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 64);
+    hilti::rt::done();
+}
+
+// Searches backwards through a stream for a pattern it doesn't contain,
+// locating each chunk on the way.
+static void view_find_bytes_backward(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto s = make_stream(state.range(0), 64);
+    auto v = s.view();
+    auto needle = Bytes("!xx");
+
+    for ( auto _ : state ) {
+        (void)_;
+        benchmark::DoNotOptimize(v.find(needle, stream::Direction::Backward));
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 64);
+    hilti::rt::done();
+}
+
+// Mimics parsers extracting consecutive small fields from a stream.
+static void view_sub_advance(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto s = make_stream(state.range(0), 64);
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto v = s.view();
+
+        while ( v.size() >= 16 ) {
+            auto field = v.sub(16);
+            benchmark::DoNotOptimize(field);
+            v = v.advance(16);
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 64);
+    hilti::rt::done();
+}
+
+// Random access to positions of a stream with many chunks, requiring a
+// search for the containing chunk each time.
+static void find_chunk(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto chunks = state.range(0);
+    auto s = make_stream(chunks, 64);
+
+    std::mt19937_64 rng(42); // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::vector<uint64_t> offsets;
+    for ( int i = 0; i < 1024; i++ )
+        offsets.push_back(rng() % (chunks * 64));
+
+    for ( auto _ : state ) {
+        (void)_;
+        for ( auto o : offsets )
+            benchmark::DoNotOptimize(*s.at(o));
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(offsets.size()));
+    hilti::rt::done();
+}
+
+BENCHMARK(append_small_chunks)->ArgName("size")->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(append_bytes)->ArgName("size")->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(view_find_byte)->ArgName("chunks")->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK(view_find_bytes)->ArgName("chunks")->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK(view_find_bytes_backward)->ArgName("chunks")->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(view_sub_advance)->ArgName("chunks")->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK(find_chunk)->ArgName("chunks")->RangeMultiplier(8)->Range(8, 32768);
+
+BENCHMARK_MAIN();
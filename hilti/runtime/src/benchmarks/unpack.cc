@@ -0,0 +1,81 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <hilti/rt/init.h>
+#include <hilti/rt/types/bytes.h>
+#include <hilti/rt/types/integer.h>
+#include <hilti/rt/types/stream.h>
+
+using namespace hilti::rt;
+
+static constexpr int64_t InputSize = 4096;
+
+// Unpacks integers from a stream view back to back, the way parsers do.
+template<typename T>
+static void unpack_view(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto order = ByteOrder(state.range(0));
+
+    auto s = Stream(Bytes(std::string(InputSize, '\x01')));
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto v = s.view();
+
+        while ( v.size() >= sizeof(T) ) {
+            auto [x, rest] = *integer::unpack<T>(v, order);
+            benchmark::DoNotOptimize(x);
+            v = rest;
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * InputSize);
+    hilti::rt::done();
+}
+
+// Unpacks integers from bytes back to back.
+template<typename T>
+static void unpack_bytes(benchmark::State& state) {
+    hilti::rt::init();
+
+    auto order = ByteOrder(state.range(0));
+
+    auto b = Bytes(std::string(InputSize, '\x01'));
+
+    for ( auto _ : state ) {
+        (void)_;
+        auto data = b;
+
+        while ( data.size() >= sizeof(T) ) {
+            auto [x, rest] = *integer::unpack<T>(std::move(data), order);
+            benchmark::DoNotOptimize(x);
+            data = std::move(rest);
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * InputSize);
+    hilti::rt::done();
+}
+
+// Byte orders are passed as the benchmarks' argument.
+#define UNPACK_BENCHMARK(func, type)                                                                                   \
+    BENCHMARK_TEMPLATE(func, type)->ArgName("order")->Arg(ByteOrder::Big)->Arg(ByteOrder::Little)
+
+UNPACK_BENCHMARK(unpack_view, uint8_t);
+UNPACK_BENCHMARK(unpack_view, int16_t);
+UNPACK_BENCHMARK(unpack_view, uint16_t);
+UNPACK_BENCHMARK(unpack_view, int32_t);
+UNPACK_BENCHMARK(unpack_view, uint32_t);
+UNPACK_BENCHMARK(unpack_view, int64_t);
+UNPACK_BENCHMARK(unpack_view, uint64_t);
+
+UNPACK_BENCHMARK(unpack_bytes, uint8_t);
+UNPACK_BENCHMARK(unpack_bytes, uint16_t);
+UNPACK_BENCHMARK(unpack_bytes, uint32_t);
+UNPACK_BENCHMARK(unpack_bytes, uint64_t);
+
+BENCHMARK_MAIN();
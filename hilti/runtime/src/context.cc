@@ -34,10 +34,16 @@ Context::Context(vthread::ID vid) : vid(vid) {
         return;
     }
 
+    // The modules' initialization code stores globals into the current
+    // context, so make ourselves current while it's running.
+    auto old = context::detail::set(this);
+
     for ( const auto& m : globalState()->hilti_modules ) {
         if ( m.init_globals )
             (*m.init_globals)(this);
     }
+
+    context::detail::set(old);
 }
 
 Context::~Context() {
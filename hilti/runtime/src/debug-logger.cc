@@ -16,6 +16,8 @@ using namespace hilti::rt;
 detail::DebugLogger::DebugLogger(hilti::rt::filesystem::path output) : _path(std::move(output)) {}
 
 void detail::DebugLogger::enable(const std::string& streams) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
     for ( auto s : split(streams, ":") )
         _streams[std::string(trim(s))] = 0;
 }
@@ -24,6 +26,8 @@ void detail::DebugLogger::print(const std::string& stream, const std::string& ms
     if ( _path.empty() )
         return;
 
+    std::lock_guard<std::mutex> lock(_mutex);
+
     auto i = _streams.find(stream);
     if ( i == _streams.end() )
         return;
@@ -1,7 +1,10 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
 #include <fiber/fiber.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <memory>
 
 #include <hilti/rt/autogen/config.h>
@@ -47,6 +50,25 @@ static const auto FiberGuardFlags = 0; // leak sanitizer may abort with "Tracer
 
 #endif
 
+// Swap buffers larger than this many pages are not pooled for reuse.
+static const size_t MaxPooledSwapBufferPages = 64;
+
+// Returns the system's page size.
+static size_t pageSize() {
+    static const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+// Rounds a size up to the next multiple of the page size.
+static size_t roundUpToPage(size_t size) { return (size + pageSize() - 1) / pageSize() * pageSize(); }
+
+// Raises a statistics maximum shared across threads to at least `value`.
+static void updateMaximum(std::atomic<uint64_t>* max, uint64_t value) {
+    auto current = max->load(std::memory_order_relaxed);
+    while ( value > current && ! max->compare_exchange_weak(current, value, std::memory_order_relaxed) )
+        ; // `current` has been reloaded, try again
+}
+
 // Pre-allocate this so that we don't need to create a std::string on the fly
 // when HILTI_RT_FIBER_DEBUG executes. That avoids a false positive with
 // ASAN during fiber switching when using GCC/libc++.
@@ -151,7 +173,33 @@ detail::FiberContext::FiberContext() {
         throw RuntimeError("could not allocate shared stack");
 }
 
-detail::FiberContext::~FiberContext() { ::fiber_destroy(shared_stack.get()); }
+detail::FiberContext::~FiberContext() {
+    detail::Fiber::_clearSwapBufferPool(this);
+    ::fiber_destroy(shared_stack.get());
+}
+
+size_t detail::StackUsage::release(char* lower, size_t size, size_t keep) {
+    keep = roundUpToPage(std::max(keep, high_water));
+    high_water = 0;
+
+    if ( resident <= keep || keep >= size )
+        return 0;
+
+    // The stack grows downwards, so the pages we no longer need are located
+    // between its lower end and the part we keep at the top.
+    auto* upper = lower + size;
+    auto page_mask = ~(static_cast<uintptr_t>(pageSize()) - 1);
+    auto* from = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(upper - std::min(resident, size)) & page_mask);
+    auto* to = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(upper - keep) & page_mask);
+    from = std::max(from, reinterpret_cast<char*>(roundUpToPage(reinterpret_cast<uintptr_t>(lower))));
+
+    resident = keep;
+
+    if ( from >= to || ::madvise(from, static_cast<size_t>(to - from), MADV_DONTNEED) != 0 )
+        return 0;
+
+    return static_cast<size_t>(to - from);
+}
 
 detail::Fiber::Fiber(Type type) : _type(type), _fiber(std::make_unique<::Fiber>()), _stack_buffer(_fiber.get()) {
 #ifndef NDEBUG
@@ -212,10 +260,8 @@ detail::Fiber::Fiber(Type type) : _type(type), _fiber(std::make_unique<::Fiber>(
         case Type::IndividualStack: {
             // We do bookkeeping only for the "real" fibers with payload.
             ++_total_fibers;
-            ++_current_fibers;
 
-            if ( _current_fibers > _max_fibers )
-                _max_fibers = _current_fibers;
+            updateMaximum(&_max_fibers, ++_current_fibers);
         }
 
         case Type::SwitchTrampoline:
@@ -248,7 +294,10 @@ detail::Fiber::~Fiber() {
         --_current_fibers;
 }
 
-detail::StackBuffer::~StackBuffer() { free(_buffer); }
+detail::StackBuffer::~StackBuffer() {
+    if ( _buffer )
+        detail::Fiber::_freeSwapBuffer(_buffer, _buffer_size);
+}
 
 std::pair<char*, char*> detail::StackBuffer::activeRegion() const {
     // The direction in which the stack grows is platform-specific. It's
@@ -292,22 +341,21 @@ size_t detail::StackBuffer::liveRemainingSize() const {
 size_t detail::StackBuffer::activeSize() const { return static_cast<size_t>(::fiber_stack_used_size(_fiber)); }
 
 void detail::StackBuffer::save() {
-    auto want_buffer_size = std::max(activeSize(), configuration::get().fiber_shared_stack_swap_size_min);
+    auto active_size = activeSize();
+    context::detail::get()->fiber.shared_stack_usage.record(active_size);
 
-    // Round to KB boundary to avoid frequent reallocations.
-    want_buffer_size = ((want_buffer_size >> 10) + 1) << 10;
+    // Round to page boundary, which gives us size classes for pooling buffers.
+    auto want_buffer_size =
+        roundUpToPage(std::max(active_size, configuration::get().fiber_shared_stack_swap_size_min));
 
     if ( want_buffer_size != _buffer_size ) {
         HILTI_RT_FIBER_DEBUG("stack-switcher", fmt("%sallocating %zu bytes of swap space for stack %s",
                                                    (_buffer ? "re" : ""), want_buffer_size, *this));
 
         if ( _buffer )
-            free(_buffer);
-
-        _buffer = ::malloc(want_buffer_size);
-        if ( ! _buffer )
-            throw RuntimeError("out of memory when saving fiber stack");
+            detail::Fiber::_recycleSwapBuffer(_buffer, _buffer_size);
 
+        _buffer = detail::Fiber::_allocateSwapBuffer(want_buffer_size);
         _buffer_size = want_buffer_size;
     }
 
@@ -374,6 +422,70 @@ void detail::Fiber::_executeSwitch(const char* tag, detail::Fiber* from, detail:
     HILTI_RT_FIBER_DEBUG(tag, fmt("resuming after fiber switch returns back to %s", *from));
 }
 
+void* detail::Fiber::_allocateSwapBuffer(size_t size) {
+    auto& fiber = context::detail::get()->fiber;
+    auto& pool = fiber.swap_buffer_pool;
+
+    if ( auto idx = size / pageSize() - 1; idx < pool.size() && ! pool[idx].empty() ) {
+        auto* buffer = pool[idx].back();
+        pool[idx].pop_back();
+        fiber.swap_buffer_pool_size -= size;
+        _swap_pooled -= size;
+        return buffer;
+    }
+
+    auto* buffer = ::malloc(size);
+    if ( ! buffer )
+        throw RuntimeError("out of memory when saving fiber stack");
+
+    _swap_size += size;
+    return buffer;
+}
+
+void detail::Fiber::_recycleSwapBuffer(void* buffer, size_t size) {
+    auto& fiber = context::detail::get()->fiber;
+    auto& pool = fiber.swap_buffer_pool;
+
+    // Bound the pool by total size so that it cannot hold on to more than a
+    // fixed amount of memory between calls to `releaseMemory()`.
+    if ( auto idx = size / pageSize() - 1; idx < MaxPooledSwapBufferPages &&
+                                           fiber.swap_buffer_pool_size + size <=
+                                               configuration::detail::unsafeGet().fiber_swap_buffer_pool_size ) {
+        if ( idx >= pool.size() )
+            pool.resize(idx + 1);
+
+        pool[idx].push_back(buffer);
+        fiber.swap_buffer_pool_size += size;
+        _swap_pooled += size;
+        return;
+    }
+
+    _freeSwapBuffer(buffer, size);
+}
+
+void detail::Fiber::_freeSwapBuffer(void* buffer, size_t size) {
+    ::free(buffer);
+    _swap_size -= size;
+}
+
+size_t detail::Fiber::_clearSwapBufferPool(FiberContext* context) {
+    size_t released = 0;
+
+    for ( size_t idx = 0; idx < context->swap_buffer_pool.size(); idx++ ) {
+        auto size = (idx + 1) * pageSize();
+
+        for ( auto* buffer : context->swap_buffer_pool[idx] ) {
+            _freeSwapBuffer(buffer, size);
+            released += size;
+        }
+    }
+
+    context->swap_buffer_pool.clear();
+    context->swap_buffer_pool_size = 0;
+    _swap_pooled -= released;
+    return released;
+}
+
 void detail::Fiber::_activate(const char* tag) {
     auto* context = context::detail::get();
     auto* current = context->fiber.current;
@@ -516,10 +628,12 @@ std::unique_ptr<detail::Fiber> detail::Fiber::create() {
         auto f = std::move(cache.back());
         cache.pop_back();
         --_cached_fibers;
+        ++_cache_hits;
         HILTI_RT_FIBER_DEBUG("create", fmt("reusing fiber %s from cache", *f.get()));
         return f;
     }
 
+    ++_cache_misses;
     return std::make_unique<Fiber>(DefaultFiberType);
 }
 
@@ -535,15 +649,58 @@ void detail::Fiber::destroy(std::unique_ptr<detail::Fiber> f) {
     if ( ! context )
         return;
 
+    const auto& config = configuration::detail::unsafeGet();
+
     auto& cache = context->fiber.cache;
-    if ( cache.size() < configuration::detail::unsafeGet().fiber_cache_size ) {
+    if ( cache.size() < config.fiber_cache_size ) {
         HILTI_RT_FIBER_DEBUG("destroy", fmt("putting fiber %s back into cache", *f.get()));
         cache.push_back(std::move(f));
         ++_cached_fibers;
-        return;
     }
+    else {
+        HILTI_RT_FIBER_DEBUG("destroy", fmt("cache size exceeded, deleting finished fiber %s", *f.get()));
+        f.reset();
+    }
+
+    // Once we're back at the top-level, periodically return memory that has
+    // not been needed recently.
+    if ( config.fiber_release_interval > 0 && context->fiber.current == context->fiber.main.get() ) {
+        auto now = std::chrono::steady_clock::now();
+        if ( now - context->fiber.last_release >= std::chrono::duration<double>(config.fiber_release_interval) )
+            releaseMemory();
+    }
+}
+
+void detail::Fiber::releaseMemory() {
+    auto* context = context::detail::get();
+    assert(context->fiber.current == context->fiber.main.get());
+
+    auto keep = configuration::get().fiber_shared_stack_swap_size_min;
+    size_t released = 0;
+
+    // With control being back at the main fiber, nothing is executing on
+    // the shared stack anymore; all its content has been saved.
+    auto* shared_stack = context->fiber.shared_stack.get();
+    released += context->fiber.shared_stack_usage.release(reinterpret_cast<char*>(::fiber_stack(shared_stack)),
+                                                          ::fiber_stack_size(shared_stack), keep);
+
+    // Idle fibers in the cache still need the top of their stack for their
+    // trampoline, but nothing below.
+    for ( auto& f : context->fiber.cache ) {
+        if ( f->_type != Type::IndividualStack )
+            continue;
+
+        released += f->_stack_usage.release(reinterpret_cast<char*>(::fiber_stack(f->_fiber.get())),
+                                            ::fiber_stack_size(f->_fiber.get()),
+                                            std::max(keep, f->_stack_buffer.activeSize()));
+    }
+
+    released += _clearSwapBufferPool(&context->fiber);
 
-    HILTI_RT_FIBER_DEBUG("destroy", fmt("cache size exceeded, deleting finished fiber %s", *f.get()));
+    HILTI_RT_FIBER_DEBUG("release", fmt("returned %zu bytes of stack memory", released));
+
+    _released += released;
+    context->fiber.last_release = std::chrono::steady_clock::now();
 }
 
 void detail::Fiber::primeCache() {
@@ -560,21 +717,37 @@ void detail::Fiber::primeCache() {
 }
 
 void detail::Fiber::reset() {
-    context::detail::get()->fiber.cache.clear();
+    auto* context = context::detail::get();
+    context->fiber.cache.clear();
+
+    _clearSwapBufferPool(&context->fiber);
+    context->fiber.shared_stack_usage = {};
+    context->fiber.last_release = std::chrono::steady_clock::now();
+
     _total_fibers = 0;
     _current_fibers = 0;
     _cached_fibers = 0;
     _max_fibers = 0;
     _max_stack_size = 0;
     _initialized = 0;
+    _cache_hits = 0;
+    _cache_misses = 0;
+    _released = 0;
 }
 
 void Resumable::run() {
+    if ( _direct ) {
+        runDirectly();
+        return;
+    }
+
     checkFiber("run");
 
     auto old = context::detail::get()->resumable;
     context::detail::get()->resumable = handle();
+    auto profilers = _restoreProfilers();
     _fiber->run();
+    _saveProfilers(profilers);
     context::detail::get()->resumable = old;
 
     yielded();
@@ -585,7 +758,9 @@ void Resumable::resume() {
 
     auto old = context::detail::get()->resumable;
     context::detail::get()->resumable = handle();
+    auto profilers = _restoreProfilers();
     _fiber->resume();
+    _saveProfilers(profilers);
     context::detail::get()->resumable = old;
 
     yielded();
@@ -597,7 +772,9 @@ void Resumable::abort() {
 
     auto old = context::detail::get()->resumable;
     context::detail::get()->resumable = handle();
+    auto profilers = _restoreProfilers();
     _fiber->abort();
+    _saveProfilers(profilers);
     context::detail::get()->resumable = old;
 
     _result.reset();
@@ -625,6 +802,69 @@ void Resumable::yielded() {
     }
 }
 
+size_t Resumable::_restoreProfilers() {
+    auto& stack = context::detail::get()->profiler_stack;
+    auto base = stack.size();
+    stack.insert(stack.end(), _profilers.begin(), _profilers.end());
+    _profilers.clear();
+    return base;
+}
+
+void Resumable::_saveProfilers(size_t base) {
+    auto& stack = context::detail::get()->profiler_stack;
+    if ( stack.size() <= base )
+        return;
+
+    _profilers.assign(stack.begin() + static_cast<std::ptrdiff_t>(base), stack.end());
+    stack.resize(base);
+}
+
+void Resumable::runDirectly() {
+    auto f = std::move(*_direct);
+    _direct.reset();
+
+    auto& fiber = context::detail::get()->fiber;
+    auto old_limit = fiber.main_stack_limit;
+
+    if ( fiber.current->isMain() && ! old_limit )
+        // Grant the function as much stack as it would have on an individual fiber.
+        fiber.main_stack_limit = reinterpret_cast<const char*>(__builtin_frame_address(0)) -
+                                 configuration::detail::unsafeGet().fiber_individual_stack_size;
+
+    // There's nothing to yield to, so make that an error.
+    auto _ = context::detail::ResumableSetter(nullptr);
+
+    try {
+        _result = f(nullptr);
+    } catch ( ... ) {
+        fiber.main_stack_limit = old_limit;
+        _done = true;
+        throw;
+    }
+
+    fiber.main_stack_limit = old_limit;
+    _done = true;
+}
+
+resumable::RunDirectly::RunDirectly(bool enable) {
+    auto& fiber = context::detail::get()->fiber;
+    _old = fiber.run_directly;
+    fiber.run_directly = (_old || enable);
+}
+
+resumable::RunDirectly::~RunDirectly() { context::detail::get()->fiber.run_directly = _old; }
+
+bool detail::takeRunDirectly() {
+    auto& fiber = context::detail::get()->fiber;
+    if ( ! fiber.run_directly )
+        return false;
+
+    fiber.run_directly = false;
+    return true;
+}
+
+bool detail::canYield() { return context::detail::get()->resumable != nullptr; }
+
 void detail::yield() {
     auto r = context::detail::get()->resumable;
 
@@ -642,8 +882,15 @@ void detail::trackStack() {
         return;
 
     if ( fiber->type() == Fiber::Type::IndividualStack || fiber->type() == Fiber::Type::SharedStack ) {
-        if ( auto size = fiber->stackBuffer().activeSize(); size > detail::Fiber::_max_stack_size )
-            detail::Fiber::_max_stack_size = size;
+        updateMaximum(&detail::Fiber::_max_stack_size, fiber->stackBuffer().activeSize());
+
+        // Record how deep the stack currently is for releasing unused pages later.
+        auto live_size = fiber->stackBuffer().allocatedSize() - fiber->stackBuffer().liveRemainingSize();
+
+        if ( fiber->type() == Fiber::Type::SharedStack )
+            context::detail::get()->fiber.shared_stack_usage.record(live_size);
+        else
+            fiber->_stack_usage.record(live_size);
     }
 }
 
@@ -655,6 +902,11 @@ detail::Fiber::Statistics detail::Fiber::statistics() {
         .max = _max_fibers,
         .max_stack_size = _max_stack_size,
         .initialized = _initialized,
+        .cache_hits = _cache_hits,
+        .cache_misses = _cache_misses,
+        .swap_size = _swap_size,
+        .swap_pooled = _swap_pooled,
+        .released = _released,
     };
 
     return stats;
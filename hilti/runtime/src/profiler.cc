@@ -1,9 +1,16 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
+#include <algorithm>
 #include <cinttypes>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <hilti/rt/configuration.h>
+#include <hilti/rt/context.h>
 #include <hilti/rt/logging.h>
 #include <hilti/rt/profiler.h>
 #include <hilti/rt/util.h>
@@ -28,7 +35,90 @@ inline uint64_t _getClock() {
 #endif
 }
 
-void Profiler::_register() const { ++detail::globalState()->profilers[_name].instances; }
+namespace {
+
+// Process-wide table of interned profiler names. Unlike the measurements,
+// this isn't part of the global state because IDs get cached by code across
+// runtime restarts.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, ID> ids;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+// Returns the ID of a name if it has been interned already.
+std::optional<ID> lookup(const std::string& name) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    if ( auto i = r.ids.find(name); i != r.ids.end() )
+        return i->second;
+    else
+        return {};
+}
+
+// Returns the measurement state for an ID, creating it if necessary.
+profiler::detail::MeasurementState& state(ID id) {
+    auto& profilers = hilti::rt::detail::globalState()->profilers;
+    if ( id >= profilers.size() )
+        profilers.resize(id + 1);
+
+    return profilers[id];
+}
+
+// Returns the index of the call tree node for a profiler nested directly
+// inside the one at `parent`, creating the node if necessary.
+size_t callPath(size_t parent, ID id) {
+    auto& paths = hilti::rt::detail::globalState()->profiler_paths;
+    if ( paths.empty() )
+        paths.emplace_back(); // root
+
+    if ( auto i = paths[parent].children.find(id); i != paths[parent].children.end() )
+        return i->second;
+
+    auto index = paths.size();
+    paths.push_back(profiler::detail::CallPathState{.id = id, .parent = parent});
+    paths[parent].children.emplace(id, index);
+    return index;
+}
+
+// Returns the names of all interned IDs.
+std::vector<std::string> internedNames() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.names;
+}
+
+} // namespace
+
+ID profiler::intern(std::string_view name) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    if ( auto i = r.ids.find(std::string(name)); i != r.ids.end() )
+        return i->second;
+
+    auto id = static_cast<ID>(r.names.size());
+    r.names.emplace_back(name);
+    r.ids.emplace(name, id);
+    return id;
+}
+
+void Profiler::_register() {
+    ++state(_id).instances;
+
+    // Profilers started outside of any context don't become part of the call tree.
+    if ( auto* ctx = context::detail::get(true) ) {
+        auto& stack = ctx->profiler_stack;
+        _node = callPath(stack.empty() ? 0 : stack.back(), _id);
+        stack.push_back(_node);
+    }
+}
 
 profiler::Measurement Profiler::snapshot() {
     if ( ! detail::globalState()->profiling_enabled )
@@ -46,16 +136,36 @@ void Profiler::record(const Measurement& end) {
     if ( ! *this )
         return; // already recorded
 
-    auto& p = detail::globalState()->profilers[_name];
+    auto& p = state(_id);
     assert(p.instances > 0);
 
     ++p.m.count;
 
+    auto delta = (end - _start);
+
     // With recursive calls, we only time the top-level.
     if ( p.instances-- == 1 )
-        p.m += (end - _start);
+        p.m += delta;
+
+    if ( _node ) {
+        auto& paths = detail::globalState()->profiler_paths;
+        auto& n = paths[_node];
+        ++n.m.count;
+        n.m += delta;
+        paths[n.parent].children_time += delta.time;
+
+        // Normally we're the innermost profiler, but fibers may interleave
+        // their measurements.
+        if ( auto* ctx = context::detail::get(true) ) {
+            auto& stack = ctx->profiler_stack;
+            if ( auto i = std::find(stack.rbegin(), stack.rend(), _node); i != stack.rend() )
+                stack.erase(std::next(i).base());
+        }
+
+        _node = 0;
+    }
 
-    _name.clear();
+    _id = profiler::detail::NoID;
 }
 
 void profiler::detail::init() {
@@ -64,7 +174,7 @@ void profiler::detail::init() {
 
     rt::detail::globalState()->profiling_enabled = true;
 
-    auto& p = rt::detail::globalState()->profilers["hilti/total"];
+    auto& p = state(intern("hilti/total"));
     p.m = Profiler::snapshot();
 }
 
@@ -72,43 +182,97 @@ void profiler::detail::done() {
     if ( ! rt::detail::globalState()->profiling_enabled )
         return;
 
-    auto& p = rt::detail::globalState()->profilers["hilti/total"];
+    auto& p = state(intern("hilti/total"));
     p.m = (Profiler::snapshot() - p.m);
     ++p.m.count;
 
     report();
+
+    if ( const auto& path = configuration::get().profiling_stacks ) {
+        std::ofstream out(*path);
+        if ( out.is_open() )
+            writeFoldedStacks(out);
+        else
+            warning(fmt("cannot write profiling stacks to %s", path->native()));
+    }
 }
 
 std::optional<Measurement> profiler::get(const std::string& name) {
     const auto& profilers = rt::detail::globalState()->profilers;
-    if ( auto i = profilers.find(name); i != profilers.end() )
-        return i->second.m;
+    if ( auto id = lookup(name); id && *id < profilers.size() )
+        return profilers[*id].m;
     else
         return {};
 }
 
 void profiler::report() {
-    static const auto fmt_header = "#%-49s %10s %10s %10s %10s\n";
-    static const auto fmt_data = "%-50s %10" PRIu64 " %10" PRIu64 " %10.2f %10.2f \n";
+    static const auto fmt_header = "#%-49s %10s %10s %10s %10s %10s\n";
+    static const auto fmt_data = "%-50s %10" PRIu64 " %10" PRIu64 " %10.2f %10.2f %10.2f \n";
 
     const auto& profilers = rt::detail::globalState()->profilers;
 
     std::cerr << "#\n# Profiling results\n#\n";
-    std::cerr << fmt(fmt_header, "name", "count", "time", "avg-%", "total-%");
+    std::cerr << fmt(fmt_header, "name", "count", "time", "avg-%", "total-%", "self-%");
 
-    std::set<std::string> names;
-    for ( const auto& [name, _] : profilers )
-        names.insert(name);
+    std::vector<std::pair<std::string, ID>> names;
+
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        for ( ID id = 0; id < profilers.size(); id++ )
+            names.emplace_back(r.names[id], id);
+    }
 
-    auto total_time = static_cast<double>(profilers.at("hilti/total").m.time);
+    std::sort(names.begin(), names.end());
 
-    for ( const auto& name : names ) {
-        const auto& p = profilers.at(name).m;
+    auto total_time = static_cast<double>(state(intern("hilti/total")).m.time);
+
+    // Aggregate exclusive time across all call paths ending in a profiler.
+    // For profilers not tracked by the call tree (such as the total), we
+    // fall back to their inclusive time.
+    std::vector<uint64_t> self_times(profilers.size());
+    std::vector<bool> have_self_time(profilers.size());
+    const auto& paths = rt::detail::globalState()->profiler_paths;
+    for ( size_t i = 1; i < paths.size(); i++ ) {
+        self_times[paths[i].id] += paths[i].selfTime();
+        have_self_time[paths[i].id] = true;
+    }
+
+    for ( const auto& [name, id] : names ) {
+        const auto& p = profilers[id].m;
 
         if ( p.count == 0 )
             continue;
 
         auto percent = static_cast<double>(p.time) * 100.0 / total_time;
-        std::cerr << fmt(fmt_data, name, p.count, p.time, percent / static_cast<double>(p.count), percent);
+        auto self_time = (have_self_time[id] ? self_times[id] : p.time);
+        auto self_percent = static_cast<double>(self_time) * 100.0 / total_time;
+        std::cerr << fmt(fmt_data, name, p.count, p.time, percent / static_cast<double>(p.count), percent,
+                         self_percent);
     }
 }
+
+void profiler::writeFoldedStacks(std::ostream& out) {
+    const auto& paths = rt::detail::globalState()->profiler_paths;
+    const auto names = internedNames();
+
+    std::vector<std::string> stacks(paths.size());
+    std::vector<std::string> lines;
+
+    // Parents always come before their children, so we can build each
+    // path's stack from its parent's.
+    for ( size_t i = 1; i < paths.size(); i++ ) {
+        const auto& n = paths[i];
+        const auto& name = names[n.id];
+        stacks[i] = (n.parent ? stacks[n.parent] + ";" + name : name);
+
+        if ( n.m.count )
+            lines.emplace_back(fmt("%s %" PRIu64, stacks[i], n.selfTime()));
+    }
+
+    std::sort(lines.begin(), lines.end());
+
+    for ( const auto& l : lines )
+        out << l << '\n';
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <hilti/rt/arena.h>
+#include <hilti/rt/doctest.h>
+#include <hilti/rt/types/reference.h>
+
+using namespace hilti::rt;
+
+TEST_SUITE_BEGIN("Arena");
+
+TEST_CASE("allocate") {
+    Arena arena(1024, 256);
+    CHECK_EQ(arena.allocated(), 0);
+    CHECK_EQ(arena.reserved(), 0);
+
+    SUBCASE("alignment") {
+        auto* p1 = arena.allocate(1, 1);
+        auto* p2 = arena.allocate(8, 8);
+        auto* p3 = arena.allocate(16, 16);
+        CHECK_EQ(reinterpret_cast<uintptr_t>(p2) % 8, 0);
+        CHECK_EQ(reinterpret_cast<uintptr_t>(p3) % 16, 0);
+        CHECK_NE(p1, p2);
+        CHECK_NE(p2, p3);
+        CHECK_EQ(arena.allocated(), 25);
+    }
+
+    SUBCASE("new blocks") {
+        for ( int i = 0; i < 10; i++ )
+            arena.allocate(48);
+
+        CHECK_EQ(arena.allocated(), 480);
+        CHECK_GE(arena.reserved(), 480);
+    }
+
+    SUBCASE("large") {
+        arena.allocate(8);
+        auto reserved = arena.reserved();
+        arena.allocate(1000);
+        CHECK_GE(arena.reserved(), reserved + 1000);
+
+        // The current block remains in use.
+        arena.allocate(8);
+        CHECK_EQ(arena.reserved(), reserved + 1000 + alignof(std::max_align_t));
+    }
+
+    SUBCASE("exhausted") {
+        CHECK_FALSE(arena.isExhausted());
+        arena.allocate(1024);
+        CHECK(arena.isExhausted());
+        CHECK(arena.allocate(16)); // still succeeds
+    }
+}
+
+TEST_CASE("scope") {
+    auto arena = std::make_shared<Arena>(1024);
+
+    CHECK_EQ(arena::detail::current(), nullptr);
+
+    {
+        arena::Scope scope(arena);
+        REQUIRE(arena::detail::current());
+        CHECK_EQ(*arena::detail::current(), arena);
+
+        {
+            arena::Scope inner(nullptr);
+            CHECK_EQ(arena::detail::current(), nullptr);
+        }
+
+        CHECK_EQ(*arena::detail::current(), arena);
+
+        ValueReference<std::string> x("abc");
+        CHECK_GT(arena->allocated(), 0);
+
+        // Allocations fall back to the heap once exhausted.
+        arena->allocate(1024);
+        CHECK_EQ(arena::detail::current(), nullptr);
+
+        auto allocated = arena->allocated();
+        ValueReference<std::string> y("def");
+        CHECK_EQ(arena->allocated(), allocated);
+    }
+
+    CHECK_EQ(arena::detail::current(), nullptr);
+}
+
+TEST_CASE("lifetime") {
+    std::optional<ValueReference<std::string>> x;
+
+    {
+        auto arena = std::make_shared<Arena>(1024);
+        arena::Scope scope(arena);
+        x = ValueReference<std::string>("abc");
+    }
+
+    // The value keeps its arena alive.
+    CHECK_EQ(**x, "abc");
+    x.reset();
+}
+
+TEST_SUITE_END();
@@ -501,6 +501,29 @@ TEST_CASE("Iterator") {
         CHECK_THROWS_WITH_AS(*it, "bound object has expired", const InvalidIterator&);
     }
 
+    SUBCASE("copies have own iterators") {
+        auto it = Bytes::const_iterator();
+
+        {
+            auto copy = b;
+            it = copy.begin();
+            CHECK_THROWS_WITH_AS(operator==(it, b.begin()), "cannot compare iterators into different bytes",
+                                 const InvalidArgument&);
+        }
+
+        CHECK_THROWS_WITH_AS(*it, "bound object has expired", const InvalidIterator&);
+        CHECK_EQ(*b.begin(), '1');
+    }
+
+    SUBCASE("copied and moved iterators") {
+        auto it1 = b.begin() + 1;
+        auto it2 = it1;
+        auto it3 = std::move(it1);
+        CHECK_EQ(*it2, '2');
+        CHECK_EQ(*it3, '2');
+        CHECK_EQ(it2, it3);
+    }
+
     SUBCASE("increment") {
         auto it = b.begin();
         CHECK_EQ(*(it++), '1');
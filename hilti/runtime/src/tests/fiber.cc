@@ -285,6 +285,52 @@ TEST_CASE("prime-cache") {
     REQUIRE(stats.cached == hilti::rt::configuration::get().fiber_cache_size);
 }
 
+TEST_CASE("cache-hits") {
+    hilti::rt::init();
+    hilti::rt::detail::Fiber::reset(); // reset cache and counters
+
+    auto f = [&](hilti::rt::resumable::Handle* r) { return hilti::rt::Nothing(); };
+
+    hilti::rt::fiber::execute(f);
+    hilti::rt::fiber::execute(f);
+
+    auto stats = hilti::rt::detail::Fiber::statistics();
+    CHECK_EQ(stats.cache_misses, 1);
+    CHECK_EQ(stats.cache_hits, 1);
+}
+
+TEST_CASE("release-memory") {
+    hilti::rt::init();
+    hilti::rt::detail::Fiber::reset(); // reset cache and counters
+
+    // Use a good amount of stack before yielding so that there's something to release.
+    auto f = [&](hilti::rt::resumable::Handle* r) {
+        volatile char buffer[128 * 1024];
+        buffer[0] = buffer[sizeof(buffer) - 1] = 1;
+        hilti::rt::detail::trackStack();
+        r->yield();
+        return hilti::rt::Nothing();
+    };
+
+    auto r = hilti::rt::fiber::execute(f);
+    r.resume();
+    REQUIRE(r);
+
+    // The first release retains what has been used since the previous one,
+    // the second then finds the deep stack pages unused.
+    hilti::rt::detail::Fiber::releaseMemory();
+    auto released = hilti::rt::detail::Fiber::statistics().released;
+
+    hilti::rt::detail::Fiber::releaseMemory();
+    CHECK_GE(hilti::rt::detail::Fiber::statistics().released - released, 64 * 1024);
+    released = hilti::rt::detail::Fiber::statistics().released;
+
+    // Nothing left to release now.
+    hilti::rt::detail::Fiber::releaseMemory();
+    CHECK_EQ(hilti::rt::detail::Fiber::statistics().released, released);
+    CHECK_EQ(hilti::rt::detail::Fiber::statistics().swap_pooled, 0);
+}
+
 TEST_CASE("copy-arg") {
     hilti::rt::init();
 
@@ -336,4 +382,102 @@ TEST_CASE("stack-size-check") {
     CHECK_THROWS_AS(hilti::rt::fiber::execute(f), hilti::rt::StackSizeExceeded);
 }
 
+TEST_CASE("run-directly") {
+    hilti::rt::init();
+    hilti::rt::detail::Fiber::reset(); // reset cache and counters
+
+    SUBCASE("result") {
+        auto f = [&](hilti::rt::resumable::Handle* r) { return 42; };
+
+        hilti::rt::resumable::RunDirectly run_directly;
+        auto r = hilti::rt::fiber::execute(f);
+        REQUIRE(r);
+        CHECK_EQ(r.get<int>(), 42);
+        CHECK_EQ(hilti::rt::detail::Fiber::statistics().total, 0);
+    }
+
+    SUBCASE("only next resumable") {
+        auto f = [&](hilti::rt::resumable::Handle* r) { return hilti::rt::Nothing(); };
+
+        hilti::rt::resumable::RunDirectly run_directly;
+        hilti::rt::fiber::execute(f);
+        CHECK_EQ(hilti::rt::detail::Fiber::statistics().total, 0);
+
+        hilti::rt::fiber::execute(f);
+        CHECK_EQ(hilti::rt::detail::Fiber::statistics().total, 1);
+    }
+
+    SUBCASE("disabled") {
+        auto f = [&](hilti::rt::resumable::Handle* r) { return hilti::rt::Nothing(); };
+
+        hilti::rt::resumable::RunDirectly run_directly(false);
+        hilti::rt::fiber::execute(f);
+        CHECK_EQ(hilti::rt::detail::Fiber::statistics().total, 1);
+    }
+
+    SUBCASE("yield") {
+        auto f = [&](hilti::rt::resumable::Handle* r) {
+            hilti::rt::detail::yield();
+            return hilti::rt::Nothing();
+        };
+
+        hilti::rt::resumable::RunDirectly run_directly;
+        CHECK_THROWS_WITH_AS(hilti::rt::fiber::execute(f), "'yield' in non-suspendable context",
+                             const hilti::rt::RuntimeError&);
+    }
+
+    SUBCASE("can yield") {
+        bool f_can_yield = true;
+        bool g_can_yield = false;
+
+        auto g = [&](hilti::rt::resumable::Handle* r) {
+            g_can_yield = hilti::rt::detail::canYield();
+            return hilti::rt::Nothing();
+        };
+
+        auto f = [&](hilti::rt::resumable::Handle* r) {
+            f_can_yield = hilti::rt::detail::canYield();
+            hilti::rt::fiber::execute(g);
+            return hilti::rt::Nothing();
+        };
+
+        CHECK_FALSE(hilti::rt::detail::canYield());
+
+        hilti::rt::resumable::RunDirectly run_directly;
+        hilti::rt::fiber::execute(f);
+        CHECK_FALSE(f_can_yield);
+        CHECK(g_can_yield);
+    }
+
+    SUBCASE("nested fiber") {
+        auto g = [&](hilti::rt::resumable::Handle* r) {
+            r->yield();
+            return hilti::rt::Nothing();
+        };
+
+        auto f = [&](hilti::rt::resumable::Handle* r) {
+            auto s = hilti::rt::fiber::execute(g);
+            CHECK(! s);
+            s.resume();
+            CHECK(s);
+            return hilti::rt::Nothing();
+        };
+
+        hilti::rt::resumable::RunDirectly run_directly;
+        auto r = hilti::rt::fiber::execute(f);
+        CHECK(r);
+        CHECK_EQ(hilti::rt::detail::Fiber::statistics().total, 1);
+    }
+
+    SUBCASE("stack size check") {
+        auto f = [&](hilti::rt::resumable::Handle* r) {
+            fibo(1000000000); // stack won't suffice
+            return hilti::rt::Nothing();
+        };
+
+        hilti::rt::resumable::RunDirectly run_directly;
+        CHECK_THROWS_AS(hilti::rt::fiber::execute(f), hilti::rt::StackSizeExceeded);
+    }
+}
+
 TEST_SUITE_END();
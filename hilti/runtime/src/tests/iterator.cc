@@ -1,9 +1,14 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <hilti/rt/doctest.h>
 #include <hilti/rt/iterator.h>
+#include <hilti/rt/types/map.h>
+#include <hilti/rt/types/set.h>
+#include <hilti/rt/types/vector.h>
 
 using namespace hilti::rt;
 
@@ -24,4 +29,26 @@ TEST_CASE("range") {
     CHECK_EQ(unroll(range(arr)), std::vector{1, 2, 3});
 }
 
+TEST_CASE("range_unchecked") {
+    auto unroll = [](auto&& xs) {
+        std::vector<std::remove_const_t<std::remove_reference_t<decltype(*std::begin(xs))>>> result;
+        for ( auto&& x : xs )
+            result.push_back(x);
+        return result;
+    };
+
+    const auto v = Vector<int>({1, 2, 3});
+    CHECK_EQ(unroll(range_unchecked(v)), std::vector{1, 2, 3});
+
+    const auto s = Set<int>({1, 2, 3});
+    CHECK_EQ(unroll(range_unchecked(s)), std::vector{1, 2, 3});
+
+    const auto m = Map<int, int>({{1, 11}, {2, 22}});
+    CHECK_EQ(unroll(range_unchecked(m)), std::vector<std::pair<const int, int>>{{1, 11}, {2, 22}});
+
+    // Types without unchecked iteration are passed through.
+    const auto xs = std::vector{1, 2, 3};
+    CHECK_EQ(&range_unchecked(xs), &xs);
+}
+
 TEST_SUITE_END();
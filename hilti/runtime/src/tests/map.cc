@@ -113,6 +113,27 @@ TEST_CASE("Iterator") {
         CHECK_THROWS_WITH_AS(*it2, "iterator is invalid", const IndexError&);
     }
 
+    SUBCASE("assign") {
+        Map<int, std::string> m({{1, "1"}});
+
+        auto begin = m.begin();
+        REQUIRE_EQ(begin->first, 1);
+
+        // Assigning invalidates all iterators.
+        m = Map<int, std::string>({{2, "2"}});
+        CHECK_THROWS_WITH_AS(*begin, "iterator is invalid", const IndexError&);
+        CHECK_EQ(m.begin()->first, 2);
+    }
+
+    SUBCASE("copy") {
+        Map<int, std::string> m1({{1, "1"}});
+        auto m2 = m1;
+
+        // Copies hand out their own iterators.
+        CHECK_THROWS_WITH_AS(operator==(m1.begin(), m2.begin()), "cannot compare iterators into different maps",
+                             const InvalidArgument&);
+    }
+
     SUBCASE("increment") {
         Map<int, std::string> m({{1, "1"}, {2, "2"}});
 
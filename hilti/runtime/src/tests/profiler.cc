@@ -2,15 +2,23 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <hilti/rt/configuration.h>
+#include <hilti/rt/context.h>
 #include <hilti/rt/doctest.h>
+#include <hilti/rt/fiber.h>
 #include <hilti/rt/global-state.h>
 #include <hilti/rt/init.h>
 #include <hilti/rt/profiler.h>
+#include <hilti/rt/test/utils.h>
 
 using namespace hilti::rt;
+using namespace hilti::rt::test;
 
 TEST_SUITE_BEGIN("Profiler");
 
@@ -42,4 +50,156 @@ TEST_CASE("measurement") {
     detail::globalState()->profiling_enabled = old_profiling;
 }
 
+TEST_CASE("intern") {
+    auto id = profiler::intern("abc");
+    CHECK_EQ(profiler::intern("abc"), id);
+    CHECK_NE(profiler::intern("abcd"), id);
+    CHECK_NE(id, profiler::detail::NoID);
+}
+
+TEST_CASE("measurement by ID") {
+    auto old_profiling = hilti::rt::detail::globalState()->profiling_enabled;
+    detail::globalState()->profiling_enabled = true;
+
+    const auto id = profiler::intern("xyz-by-id");
+
+    for ( int i = 1; i <= 3; i++ ) {
+        auto p = profiler::start(id);
+        REQUIRE(p);
+        CHECK(*p);
+
+        profiler::stop(p);
+        CHECK_FALSE(*p);
+
+        // Starting by name must find the same slot.
+        auto q = profiler::start("xyz-by-id");
+        profiler::stop(q);
+
+        auto m = profiler::get("xyz-by-id");
+        REQUIRE(m);
+        CHECK_EQ(m->count, 2 * i);
+    }
+
+    {
+        // Moving transfers the active measurement.
+        auto p = profiler::start(id);
+        auto q = std::move(*p);
+        CHECK_FALSE(*p); // NOLINT(bugprone-use-after-move)
+        CHECK(q);
+    }
+
+    detail::globalState()->profiling_enabled = old_profiling;
+}
+
+TEST_CASE("call tree") {
+    auto old_profiling = hilti::rt::detail::globalState()->profiling_enabled;
+    detail::globalState()->profiling_enabled = true;
+
+    Context context(vthread::Master);
+    TestContext _(&context);
+
+    {
+        auto outer = profiler::start("tree/outer");
+        ::usleep(10);
+
+        for ( int i = 0; i < 2; i++ ) {
+            auto inner = profiler::start("tree/inner");
+            ::usleep(10);
+            profiler::stop(inner);
+        }
+
+        {
+            auto other = profiler::start("tree/other");
+            auto inner = profiler::start("tree/inner");
+            ::usleep(10);
+        } // stopped in reverse order by destructors
+
+        CHECK_EQ(context.profiler_stack.size(), 1);
+        profiler::stop(outer);
+        CHECK(context.profiler_stack.empty());
+    }
+
+    std::stringstream out;
+    profiler::writeFoldedStacks(out);
+
+    std::string line;
+    std::vector<std::string> lines;
+    while ( std::getline(out, line) ) {
+        if ( line.rfind("tree/", 0) == 0 )
+            lines.push_back(line.substr(0, line.rfind(' ')));
+    }
+
+    CHECK_EQ(lines, std::vector<std::string>{"tree/outer", "tree/outer;tree/inner", "tree/outer;tree/other",
+                                             "tree/outer;tree/other;tree/inner"});
+
+    // Inclusive time of the outer block covers all nested ones, while its
+    // self time doesn't.
+    const auto& paths = detail::globalState()->profiler_paths;
+    uint64_t outer_time = 0;
+    uint64_t outer_self = 0;
+    uint64_t nested_time = 0;
+    for ( size_t i = 1; i < paths.size(); i++ ) {
+        const auto& p = paths[i];
+        if ( p.parent == 0 && p.id == profiler::intern("tree/outer") ) {
+            outer_time = p.m.time;
+            outer_self = p.selfTime();
+            nested_time = p.children_time;
+            CHECK_EQ(p.m.count, 1);
+        }
+    }
+
+    CHECK_GT(nested_time, 0);
+    CHECK_EQ(outer_self + nested_time, outer_time);
+
+    detail::globalState()->profiling_enabled = old_profiling;
+}
+
+TEST_CASE("call tree with interleaving fibers") {
+    hilti::rt::init();
+
+    auto old_profiling = hilti::rt::detail::globalState()->profiling_enabled;
+    detail::globalState()->profiling_enabled = true;
+
+    auto f = [](const char* outer, const char* inner) {
+        return [=](resumable::Handle* r) {
+            auto p = profiler::start(outer);
+            r->yield();
+            auto q = profiler::start(inner);
+            profiler::stop(q);
+            profiler::stop(p);
+            return Nothing();
+        };
+    };
+
+    auto a = fiber::execute(f("interleave/a", "interleave/a-inner"));
+    auto b = fiber::execute(f("interleave/b", "interleave/b-inner"));
+    REQUIRE(! a);
+    REQUIRE(! b);
+
+    // Suspended fibers take their active profilers with them.
+    CHECK(context::detail::get()->profiler_stack.empty());
+
+    a.resume();
+    b.resume();
+    REQUIRE(a);
+    REQUIRE(b);
+    CHECK(context::detail::get()->profiler_stack.empty());
+
+    std::stringstream out;
+    profiler::writeFoldedStacks(out);
+
+    std::string line;
+    std::vector<std::string> lines;
+    while ( std::getline(out, line) ) {
+        if ( line.rfind("interleave/", 0) == 0 )
+            lines.push_back(line.substr(0, line.rfind(' ')));
+    }
+
+    std::sort(lines.begin(), lines.end());
+    CHECK_EQ(lines, std::vector<std::string>{"interleave/a", "interleave/a;interleave/a-inner", "interleave/b",
+                                             "interleave/b;interleave/b-inner"});
+
+    detail::globalState()->profiling_enabled = old_profiling;
+}
+
 TEST_SUITE_END();
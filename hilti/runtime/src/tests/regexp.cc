@@ -1,5 +1,6 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
+#include <string>
 #include <tuple>
 
 #include <hilti/rt/doctest.h>
@@ -118,6 +119,19 @@ TEST_CASE("find") {
                  std::make_tuple(1, "23X0912Bxx23YY09"_b));
         CHECK_EQ(RegExp("23.*09", regexp::Flags{.no_sub = 1}).find("xxA123X2309YY09xx"_b),
                  std::make_tuple(1, "23X2309YY09"_b));
+
+        // Left-most match wins over longer ones starting later.
+        CHECK_EQ(RegExp("a|bbb", regexp::Flags{.no_sub = 1}).find("xxabbbxx"_b), std::make_tuple(1, "a"_b));
+        CHECK_EQ(RegExp(std::vector<std::string>({"abc", "123"}), regexp::Flags{.no_sub = 1}).find(" 123 abc "_b),
+                 std::make_tuple(2, "123"_b));
+
+        // Left-most match wins even if another one ends earlier.
+        CHECK_EQ(RegExp("abcd|b", regexp::Flags{.no_sub = 1}).find("xabcdx"_b), std::make_tuple(1, "abcd"_b));
+
+        // Many attempts running into the same DFA state, with the only match at the very end.
+        CHECK_EQ(RegExp("a.*b|c", regexp::Flags{.no_sub = 1}).find(Bytes(std::string(1000, 'a') + "c")),
+                 std::make_tuple(1, "c"_b));
+        CHECK_EQ(RegExp("a.*b|c", regexp::Flags{.no_sub = 1}).find("xxaaaxbxx"_b), std::make_tuple(1, "aaaxb"_b));
     }
 
     SUBCASE("std-matcher") {
@@ -161,6 +175,11 @@ TEST_CASE("find") {
                  std::make_tuple(1, "23X0912Bxx23YY09"_b));
         CHECK_EQ(RegExp("23.*09", regexp::Flags{.use_std = 1}).find("xxA123X2309YY09xx"_b),
                  std::make_tuple(1, "23X2309YY09"_b));
+
+        // Left-most match wins over longer ones starting later.
+        CHECK_EQ(RegExp("a|bbb", regexp::Flags{.use_std = 1}).find("xxabbbxx"_b), std::make_tuple(1, "a"_b));
+        CHECK_EQ(RegExp(std::vector<std::string>({"abc", "123"}), regexp::Flags{.use_std = 1}).find(" 123 abc "_b),
+                 std::make_tuple(2, "123"_b));
     }
 }
 
@@ -457,10 +476,27 @@ TEST_CASE("caching") {
     const auto re2b = RegExp(std::vector<std::string>{"123", "456"}, {.no_sub = true});
     const auto re3 = RegExp("123", {.no_sub = true});
     const auto re4 = RegExp(std::vector<std::string>{"123", "456"}, {.no_sub = false});
+    const auto re5 = RegExp("123", {.no_sub = true, .eager = true});
 
     CHECK_EQ(emptya.jrx(), emptyb.jrx());
     CHECK_EQ(re1a.jrx(), re1b.jrx());
     CHECK_EQ(re2a.jrx(), re2b.jrx());
     CHECK_NE(re1a.jrx(), re3.jrx());
     CHECK_NE(re1a.jrx(), re4.jrx());
+    CHECK_NE(re3.jrx(), re5.jrx());
+}
+
+TEST_CASE("eager") {
+    const auto flags = regexp::Flags{.no_sub = true, .eager = true};
+
+    CHECK_EQ(RegExp("ab+c", flags).match("abbbcdef"_b), 1);
+    CHECK_EQ(RegExp("ab+c", flags).match("012abbbc345"_b), 0);
+    CHECK_EQ(RegExp(std::vector<std::string>({".*abc", ".*123"}), flags).match(" 123 "_b), 2);
+    CHECK_EQ(RegExp("23.*09", flags).find("xxA1234X5678Y0912Bxx"_b), std::make_tuple(1, "234X5678Y09"_b));
+
+    auto ms = RegExp("1234ABCDEF*", flags).tokenMatcher();
+    CHECK_EQ(ms.advance("1234"_b, false), std::make_tuple(-1, 4));
+    CHECK_EQ(ms.advance("ABCDEFFF"_b, true), std::make_tuple(1, 8));
+
+    CHECK_EQ(to_string(RegExp("abc", flags)), "/abc/ &nosub &eager");
 }
@@ -1,7 +1,9 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
 #include <exception>
+#include <memory>
 #include <sstream>
+#include <string>
 
 #include <hilti/rt/doctest.h>
 #include <hilti/rt/exception.h>
@@ -17,10 +19,11 @@ using hilti::rt::to_string;
 
 TEST_SUITE_BEGIN("Stream");
 
+// Returns a stream with one chunk per element of `xs`.
 auto make_stream(std::initializer_list<Bytes> xs) {
     Stream s;
     for ( auto&& x : xs )
-        s.append(x);
+        s.append(Bytes(x));
 
     return s;
 }
@@ -231,7 +234,7 @@ TEST_CASE("append") {
         s.append(xs);
         CHECK_EQ(s, "123456"_b);
         CHECK_EQ(s.size(), 6);
-        CHECK_EQ(s.numberOfChunks(), 2);
+        CHECK_EQ(s.numberOfChunks(), 1); // Coalesced into existing chunk.
 
         s.freeze();
         CHECK_NOTHROW(s.append(empty));
@@ -244,7 +247,7 @@ TEST_CASE("append") {
         CHECK_EQ(s.size(), 3);
         CHECK_EQ(s.numberOfChunks(), 1);
 
-        s.append(xs);
+        s.append(Bytes(xs));
         CHECK_EQ(s, "123456"_b);
         CHECK_EQ(s.size(), 6);
         CHECK_EQ(s.numberOfChunks(), 2);
@@ -265,12 +268,86 @@ TEST_CASE("append") {
         s.append(data, strlen(data));
         CHECK_EQ(s, "123456"_b);
         CHECK_EQ(s.size(), 6);
-        CHECK_EQ(s.numberOfChunks(), 2);
+        CHECK_EQ(s.numberOfChunks(), 1); // Coalesced into existing chunk.
 
         s.freeze();
         CHECK_NOTHROW(s.append(data, 0));
         CHECK_THROWS_WITH_AS(s.append(data, strlen(data)), "stream object can no longer be modified", const Frozen&);
     }
+
+    SUBCASE("raw memory with owner") {
+        auto data = std::make_shared<std::string>(64, 'x');
+        std::weak_ptr<std::string> owner = data;
+
+        {
+            auto t = Stream("123"_b);
+            t.append(data->data(), data->size(), data);
+            data.reset();
+
+            CHECK_EQ(t.size(), 67);
+            CHECK_EQ(t.numberOfChunks(), 2);
+            CHECK_EQ(t, Bytes("123" + std::string(64, 'x')));
+            CHECK_FALSE(owner.expired());
+        }
+
+        CHECK(owner.expired());
+
+        auto small = std::make_shared<std::string>("456");
+        owner = small;
+        s.append(small->data(), small->size(), small);
+        small.reset();
+
+        CHECK(owner.expired());
+        CHECK_EQ(s, "123456"_b);
+    }
+
+    SUBCASE("borrowed raw memory") {
+        auto data = std::string(64, 'x');
+
+        auto t = Stream("123"_b);
+        t.append(data.data(), data.size(), std::shared_ptr<const void>(std::shared_ptr<const void>(), data.data()));
+        CHECK_EQ(t.numberOfChunks(), 2);
+
+        // Copies do not reference the borrowed memory.
+        auto copy = t;
+        t.reset();
+        data.assign(64, 'y');
+        CHECK_EQ(copy, Bytes("123" + std::string(64, 'x')));
+    }
+
+    SUBCASE("coalescing") {
+        const auto CoalesceCapacity = stream::detail::Chunk::CoalesceCapacity;
+        const auto z = "z"_b;
+        const auto* start = s.view().firstBlock()->start;
+
+        // Fills up the first chunk's inline storage.
+        for ( int i = 0; i < 29; i++ )
+            s.append("x", 1);
+
+        CHECK_EQ(s.size(), 32);
+        CHECK_EQ(s.numberOfChunks(), 1);
+        CHECK_EQ(s.view().firstBlock()->start, start);
+
+        // Starts a new chunk with room to spare.
+        s.append("y", 1);
+        CHECK_EQ(s.numberOfChunks(), 2);
+
+        for ( int i = 0; i < CoalesceCapacity - 1; i++ )
+            s.append(z);
+
+        CHECK_EQ(s.numberOfChunks(), 2);
+        CHECK_EQ(s.size(), 32 + CoalesceCapacity);
+
+        s.append(z);
+        CHECK_EQ(s.numberOfChunks(), 3);
+
+        // Data not fitting in stays separate.
+        const auto large = std::string(CoalesceCapacity, 'l');
+        s.append(large.data(), large.size());
+        CHECK_EQ(s.numberOfChunks(), 4);
+        CHECK_EQ(s.view().sub(s.at(32), s.at(33)), "y"_b);
+        CHECK_EQ(s.view().sub(s.at(32 + CoalesceCapacity), s.end()), Bytes("z" + large));
+    }
 }
 
 TEST_CASE("iteration") {
@@ -627,6 +704,26 @@ TEST_CASE("freezing") {
     CHECK_FALSE(i.isFrozen());
 }
 
+TEST_CASE("reset") {
+    auto x = Stream("12345"_b);
+    x.append("67890"_b);
+    x.freeze();
+
+    auto i = x.begin() + 3;
+    auto v = x.view();
+
+    x.reset();
+    CHECK(x.isEmpty());
+    CHECK_FALSE(x.isFrozen());
+    CHECK_EQ(x.begin().offset(), 0);
+    CHECK(i.isExpired());
+    CHECK_THROWS_AS(*i, const InvalidIterator&);
+    CHECK(v.begin().isExpired());
+
+    x.append("abc"_b);
+    CHECK_EQ(x, "abc"_b);
+}
+
 TEST_CASE("convert view to stream") {
     auto x = Stream("12345"_b);
     auto v = stream::View(x.begin() + 1, x.begin() + 3);
@@ -765,6 +862,49 @@ TEST_CASE("Trim empty") {
     CHECK_EQ(x.numberOfChunks(), 0);
 }
 
+TEST_CASE("Chunk lookup in long chains") {
+    // Each chunk holds the digit of its index modulo 10, three times.
+    auto x = Stream();
+    for ( int i = 0; i < 1000; i++ ) {
+        x.append(Bytes(3, static_cast<char>('0' + i % 10)));
+    }
+
+    REQUIRE_EQ(x.numberOfChunks(), 1000);
+
+    auto digit = [](uint64_t o) { return static_cast<Byte>('0' + (o / 3) % 10); };
+
+    SUBCASE("random access") {
+        for ( uint64_t o : {0, 1, 2, 3, 299, 1500, 2997, 2999} )
+            CHECK_EQ(*x.at(o), digit(o));
+
+        CHECK_EQ(x.at(3000), x.end());
+        CHECK_THROWS_WITH_AS(*x.at(3000), "stream iterator outside of valid range", const InvalidIterator&);
+    }
+
+    SUBCASE("backwards") {
+        auto i = x.end();
+        for ( uint64_t o = 3000; o >= 7; o -= 7 ) {
+            CHECK_EQ(*(i - 1), digit(o - 1));
+            i -= 7;
+        }
+    }
+
+    SUBCASE("after trimming") {
+        for ( uint64_t o = 0; o < 2400; o += 6 ) {
+            x.trim(x.at(o));
+            CHECK_EQ(*x.at(o), digit(o));
+            CHECK_EQ(*x.at(2999), '9');
+        }
+
+        CHECK_EQ(x.numberOfChunks(), 202);
+        CHECK_EQ(*x.at(2400), '0');
+        CHECK_EQ(x.view().find("888999"_b, Direction::Backward), std::make_tuple(true, x.at(2994)));
+
+        x.append("abc");
+        CHECK_EQ(*x.at(3001), 'b');
+    }
+}
+
 TEST_CASE("Block iteration") {
     auto content = [](auto b, auto s) -> bool { return memcmp(b->start, s, strlen(s)) == 0; };
 
@@ -1357,6 +1497,54 @@ TEST_CASE("View") {
             CHECK_EQ(std::get<1>(x), v.at(21));
         }
     }
+
+    SUBCASE("find - across chunks") {
+        // Needles straddling chunk boundaries, including chunks shorter than the needle.
+        auto s = make_stream({"0123"_b, "4"_b, "56"_b, "7"_b, "89ABCD"_b, "EF"_b, "0"_b, "1234567890"_b, "AB"_b});
+        auto v = s.view().sub(s.at(1), s.at(s.size() - 1));
+
+        CHECK_EQ(v.find(Byte('7')), v.at(7));
+        CHECK_EQ(v.find(Byte('7'), v.at(8)), v.at(23));
+        CHECK_EQ(v.find(Byte('B')), v.at(11));
+        CHECK_EQ(v.find(Byte('X')), v.end());
+
+        auto x = v.find("3456789A"_b);
+        CHECK_EQ(std::get<0>(x), true);
+        CHECK_EQ(std::get<1>(x), v.at(3));
+
+        x = v.find("F01"_b);
+        CHECK_EQ(std::get<0>(x), true);
+        CHECK_EQ(std::get<1>(x), v.at(15));
+
+        x = v.find("90A"_b);
+        CHECK_EQ(std::get<0>(x), true);
+        CHECK_EQ(std::get<1>(x), v.at(25));
+
+        x = v.find("0AX"_b);
+        CHECK_EQ(std::get<0>(x), false);
+        CHECK_EQ(std::get<1>(x), v.at(26));
+
+        x = v.find("XYZ"_b);
+        CHECK_EQ(std::get<0>(x), false);
+        CHECK_EQ(std::get<1>(x), v.at(28));
+
+        x = v.find("CDEF"_b, Direction::Backward);
+        CHECK_EQ(std::get<0>(x), true);
+        CHECK_EQ(std::get<1>(x), v.at(12));
+
+        x = v.find("567"_b, Direction::Backward);
+        CHECK_EQ(std::get<0>(x), true);
+        CHECK_EQ(std::get<1>(x), v.at(21));
+
+        x = v.find("567"_b, v.at(20), Direction::Backward);
+        CHECK_EQ(std::get<0>(x), true);
+        CHECK_EQ(std::get<1>(x), v.at(5));
+
+        auto needle = Stream("9ABC"_b);
+        auto y = v.find(needle.view());
+        CHECK_EQ(std::get<0>(y), true);
+        CHECK_EQ(std::get<1>(y), v.at(9));
+    }
 }
 
 TEST_SUITE_END();
@@ -3,7 +3,12 @@
 // Note: We don't run clang-tidy on this file. The use of the JRX's C
 // interface triggers all kinds of warnings.
 
+#include <cinttypes>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <hilti/rt/global-state.h>
 #include <hilti/rt/types/regexp.h>
@@ -239,10 +244,43 @@ regexp::detail::CompiledRegExp::CompiledRegExp(const std::vector<std::string>& p
     jrx_regset_finalize(jrx());
 }
 
+jrx_regex_t* regexp::detail::CompiledRegExp::jrxUnanchored() const {
+    // Different threads may be searching with the same compiled instance
+    // concurrently, so make sure only one of them compiles.
+    std::call_once(_jrx_unanchored_once, [this]() { _compileUnanchored(); });
+    return _jrx_unanchored.get();
+}
+
+void regexp::detail::CompiledRegExp::_compileUnanchored() const {
+    // Compiling the patterns without `REG_ANCHOR` makes JRX prefix them with
+    // an implicit loop, so that matches can start at any position. Since we
+    // always use the minimal matcher with this one, we never need
+    // sub-expression support.
+    int cflags = (REG_EXTENDED | REG_NOSUB);
+
+    if ( ! _flags.eager )
+        cflags |= REG_LAZY;
+
+    _jrx_unanchored = std::unique_ptr<jrx_regex_t, RegFree>(new jrx_regex_t);
+    jrx_regset_init(_jrx_unanchored.get(), -1, cflags);
+
+    for ( const auto& p : _patterns ) {
+        // Patterns have already been validated by the anchored compilation.
+        [[maybe_unused]] auto rc = jrx_regset_add(_jrx_unanchored.get(), p.c_str(), p.size());
+        assert(rc == REG_OK);
+    }
+
+    jrx_regset_finalize(_jrx_unanchored.get());
+}
+
 void regexp::detail::CompiledRegExp::_newJrx() {
     assert(! _jrx && "regexp already compiled");
 
-    int cflags = (REG_EXTENDED | REG_ANCHOR | REG_LAZY); // | REG_DEBUG;
+    int cflags = (REG_EXTENDED | REG_ANCHOR); // | REG_DEBUG;
+
+    if ( ! _flags.eager )
+        // Build DFA states only once matching reaches them.
+        cflags |= REG_LAZY;
 
     if ( _flags.no_sub )
         cflags |= REG_NOSUB;
@@ -266,6 +304,11 @@ void regexp::detail::CompiledRegExp::_compileOne(std::string pattern, int idx) {
 
 RegExp::RegExp(const std::vector<std::string>& patterns, regexp::Flags flags) {
     auto key = (patterns.empty() ? std::string() : join(patterns, "|") + "|" + flags.cacheKey());
+
+    if ( auto* ctx = context::detail::get(true); ctx && ctx->vid != vthread::Master )
+        key += fmt("|%" PRId64, ctx->vid);
+
+    std::lock_guard<std::mutex> lock(detail::globalState()->regexp_cache_mutex);
     auto& ptr = detail::globalState()->regexp_cache[key];
 
     if ( ! ptr )
@@ -327,49 +370,158 @@ Vector<Bytes> RegExp::matchGroups(const Bytes& data) const {
     return groups;
 }
 
+namespace {
+
+// A single attempt of `RegExp::find()` to match the anchored expression from
+// a given start offset.
+struct FindAttempt {
+    size_t start = 0;        // offset where the attempt started
+    jrx_match_state ms{};    // state of the anchored DFA
+    jrx_accept_id acc = 0;   // ID of the longest match seen so far, or <= 0 if none
+    size_t end = 0;          // offset one past the end of that match
+};
+
+} // namespace
+
 std::tuple<int32_t, Bytes> RegExp::find(const Bytes& data) const {
     const auto startp = data.data();
-    const auto endp = startp + data.size().Ref();
+    const auto len = data.size().Ref();
+
+    // Determine with a single linear pass of the unanchored expression if
+    // there's any match at all. If not, we are done.
+    if ( ! _has_match(startp, len) )
+        return std::make_tuple(-1, ""_b); // for this method, adding more data may always help
+
+    // Now locate the left-most match in a second pass that runs the anchored
+    // expression from all start offsets at the same time, feeding each byte
+    // to all attempts still alive. Attempts that end up in the same DFA state
+    // will behave the same from there on, so we only keep the left-most of
+    // them. That bounds the number of attempts by the number of DFA states,
+    // keeping the search linear in the size of the data.
+    using StateID = decltype(jrx_match_state::state);
+
+    std::vector<FindAttempt> attempts;
+    std::vector<FindAttempt> next;
+    std::unordered_map<StateID, size_t> states;
+    std::optional<FindAttempt> best; // left-most match found so far, with its match state already released
+
+    auto record = [&](FindAttempt& a) {
+        if ( a.acc > 0 && (! best || a.start < best->start) ) {
+            best = a;
+            best->ms = {};
+        }
 
-    int cur_rc = 0;
-    jrx_offset cur_so = -1;
-    jrx_offset cur_eo = -1;
+        jrx_match_state_done(&a.ms);
+    };
 
-    for ( auto cur = startp; cur < endp; cur++ ) {
-        jrx_offset so = -1; // just initialize with something, will be set by search_pattern to >=0 on match
-        jrx_offset eo = -1; // likewise
-        jrx_match_state ms;
-        auto rc = _search_pattern(&ms, cur, endp - cur, &so, &eo);
+    for ( size_t i = 0; i < len; i++ ) {
+        // Start a new attempt here unless one further left already matched.
+        if ( ! best && (attempts.empty() || attempts.back().acc <= 0) ) {
+            auto& a = attempts.emplace_back();
+            a.start = i;
+            jrx_match_state_init(jrx(), 0, &a.ms);
+        }
 
-        if ( rc > 0 ) {
-            assert(so >= 0 && eo >= 0);
-            auto nlen = (eo - so);
-            auto olen = (cur_eo - cur_so);
-            so += static_cast<jrx_offset>(cur - startp);
-            eo += static_cast<jrx_offset>(cur - startp);
-
-            // Pick longest match, or left-most if same length.
-            if ( nlen >= olen && (nlen > olen || so < cur_so || cur_so < 0) ) {
-#ifdef _DEBUG_MATCHING
-                std::cerr << fmt("=> better match rc=%d so=%d eo=%d\n", rc, so, eo);
-#endif
+        const auto is_final = (i == len - 1);
+        const jrx_assertion last = (is_final ? JRX_ASSERTION_EOL | JRX_ASSERTION_EOD : 0);
+
+        next.clear();
+        states.clear();
+
+        for ( auto& a : attempts ) {
+            const jrx_assertion first = (a.start == i ? JRX_ASSERTION_BOL | JRX_ASSERTION_BOD : 0);
+            auto rc = jrx_regexec_partial_min(jrx(), startp + i, 1, first, last, &a.ms, is_final);
+
+            if ( rc > 0 ) {
+                // Longest match from this start found.
+                a.acc = rc;
+                a.end = a.start + (a.ms.match_eo - 1); // 1-based
+                record(a);
+                continue;
+            }
+
+            if ( rc == 0 ) {
+                // No further match possible; any earlier one stands.
+                record(a);
+                continue;
+            }
+
+            if ( auto acc = jrx_current_accept(&a.ms); acc > 0 ) {
+                a.acc = acc;
+                a.end = i + 1;
+            }
 
-                cur_rc = rc;
-                cur_so = so;
-                cur_eo = eo;
+            if ( is_final ) {
+                record(a);
+                continue;
             }
+
+            if ( ! states.emplace(a.ms.state, next.size()).second ) {
+                // An attempt further left is in the same state already.
+                record(a);
+                continue;
+            }
+
+            next.push_back(a);
         }
 
-        jrx_match_state_done(&ms);
+        // Attempts to the right of one that has matched already cannot
+        // lead to the left-most match anymore.
+        auto keep = next.size();
+        for ( size_t j = 0; j < next.size(); j++ ) {
+            if ( best && next[j].start > best->start ) {
+                keep = j;
+                break;
+            }
+
+            if ( next[j].acc > 0 ) {
+                keep = j + 1;
+                break;
+            }
+        }
+
+        for ( auto j = keep; j < next.size(); j++ )
+            jrx_match_state_done(&next[j].ms);
+
+        next.resize(keep);
+        std::swap(attempts, next);
+
+        if ( attempts.empty() && best )
+            break;
     }
 
-    if ( cur_rc > 0 )
-        return std::make_tuple(cur_rc, _subslice(data, cur_so, cur_eo));
+    assert(attempts.empty());
 
-    if ( cur_rc == 0 )
-        cur_rc = -1; // for this method, adding more data may always help
+    if ( ! best )
+        return std::make_tuple(-1, ""_b);
 
-    return std::make_tuple(cur_rc, ""_b);
+#ifdef _DEBUG_MATCHING
+    std::cerr << fmt("=> match rc=%d so=%d eo=%d\n", best->acc, best->start, best->end);
+#endif
+
+    return std::make_tuple(best->acc,
+                           _subslice(data, static_cast<jrx_offset>(best->start), static_cast<jrx_offset>(best->end)));
+}
+
+bool RegExp::_has_match(const char* data, size_t len) const {
+    if ( len == 0 )
+        return false;
+
+    auto* jrx = _re->jrxUnanchored();
+
+    jrx_match_state ms;
+    jrx_match_state_init(jrx, 0, &ms);
+
+    // The unanchored DFA never dies, so this consumes all of the data in one
+    // go. Being told it's the final chunk, JRX reports any accept it has
+    // passed on the way.
+    const jrx_assertion first = JRX_ASSERTION_BOL | JRX_ASSERTION_BOD;
+    const jrx_assertion last = JRX_ASSERTION_EOL | JRX_ASSERTION_EOD;
+    auto rc = jrx_regexec_partial_min(jrx, data, len, first, last, &ms, true);
+    auto found = (rc > 0 || jrx_current_accept(&ms) > 0);
+
+    jrx_match_state_done(&ms);
+    return found;
 }
 
 regexp::MatchState RegExp::tokenMatcher() const { return regexp::MatchState(*this); }
@@ -442,6 +594,9 @@ std::string hilti::rt::detail::adl::to_string(const RegExp& x, adl::tag /*unused
     if ( x.flags().no_sub )
         f.emplace_back("&nosub");
 
+    if ( x.flags().eager )
+        f.emplace_back("&eager");
+
     if ( f.empty() )
         return p;
 
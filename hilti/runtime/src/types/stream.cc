@@ -51,6 +51,8 @@ void Chain::append(std::unique_ptr<Chunk> chunk) {
     _ensureValid();
     _ensureMutable();
 
+    auto* first = chunk.get();
+
     if ( _tail ) {
         _tail->setNext(std::move(chunk));
         _tail = _tail->last();
@@ -62,6 +64,29 @@ void Chain::append(std::unique_ptr<Chunk> chunk) {
         _head = std::move(chunk);
         _tail = _head->last();
     }
+
+    _index(first);
+}
+
+void Chain::append(const Byte* data, size_t len) {
+    _ensureValid();
+    _ensureMutable();
+
+    if ( _tail && _tail->appendInPlace(data, len) )
+        return;
+
+    if ( ! _tail && len <= Chunk::SmallBufferSize ) {
+        // Keep the data inline; most streams starting out small stay that way.
+        append(std::make_unique<Chunk>(0, reinterpret_cast<const char*>(data), len));
+        return;
+    }
+
+    Chunk::Vector v;
+    if ( len < Chunk::CoalesceCapacity )
+        v.reserve(Chunk::CoalesceCapacity);
+
+    v.insert(v.end(), data, data + len);
+    append(std::make_unique<Chunk>(0, std::move(v)));
 }
 
 void Chain::append(Chain&& other) {
@@ -72,8 +97,10 @@ void Chain::append(Chain&& other) {
     if ( ! other._head )
         return;
 
+    auto* first = other._head.get();
     _tail->setNext(std::move(other._head));
     _tail = other._tail;
+    _index(first);
     other.reset();
 }
 
@@ -94,6 +121,7 @@ void Chain::trim(const Offset& offset) {
             assert(! _head->next() || _head->offset() < _head->next()->offset());
 
             // Delete chunk.
+            _unindexHead();
             _head = std::move(_head->_next);
             if ( ! _head || _head->isLast() )
                 _tail = _head.get();
@@ -174,80 +202,132 @@ View View::advanceToNextData() const {
     return advance(1U);
 }
 
-UnsafeConstIterator View::find(Byte b, UnsafeConstIterator n) const {
-    if ( ! n )
-        n = unsafeBegin();
-
-    for ( auto i = n; i != unsafeEnd(); ++i ) {
-        if ( *i == b )
-            return i;
+namespace {
+// Result of comparing a needle against stream data at a given position.
+enum class Match {
+    No,      // data differs from needle
+    Yes,     // data matches needle completely
+    Partial, // available data matches needle, but ends before the needle does
+};
+
+// Compares a needle against the data starting at a given offset, following
+// the chunks of the chain across their boundaries but not going beyond
+// `end`. `chunk` must be the chunk containing `offset`.
+Match matchAt(const Chunk* chunk, Offset offset, const Offset& end, const Byte* needle, uint64_t needle_size) {
+    while ( needle_size ) {
+        if ( ! chunk || offset >= end )
+            return Match::Partial;
+
+        auto len = std::min(needle_size, (std::min(chunk->endOffset(), end) - offset).Ref());
+        if ( memcmp(chunk->data(offset), needle, len) != 0 )
+            return Match::No;
+
+        offset += len;
+        needle += len;
+        needle_size -= len;
+        chunk = chunk->next();
     }
 
-    return unsafeEnd();
+    return Match::Yes;
 }
+} // namespace
 
-std::tuple<bool, UnsafeConstIterator> View::find(const View& v, UnsafeConstIterator n) const {
+UnsafeConstIterator View::find(Byte b, UnsafeConstIterator n) const {
     if ( ! n )
-        n = UnsafeConstIterator(_begin);
+        n = unsafeBegin();
 
-    if ( v.isEmpty() )
-        return std::make_tuple(true, n);
+    const auto* chain = n.chain();
+    if ( ! chain )
+        return unsafeEnd();
 
-    auto first = *v.begin();
+    // We search block-wise through the chunks covered by the view, leaving
+    // the byte-level search to the (vectorized) libc implementation.
+    const auto end = std::min(unsafeEnd().offset(), chain->endOffset());
+    auto offset = n.offset();
+    const auto* chunk = (offset < end ? chain->findChunk(offset, n.chunk()) : nullptr);
 
-    for ( auto i = n; true; ++i ) {
-        if ( i == unsafeEnd() )
-            return std::make_tuple(false, i);
+    for ( ; chunk && offset < end; chunk = chunk->next() ) {
+        const auto* data = chunk->data(offset);
+        const auto len = (std::min(chunk->endOffset(), end) - offset).Ref();
 
-        if ( *i != first )
-            continue;
+        if ( const auto* p = static_cast<const Byte*>(memchr(data, b, len)) )
+            return UnsafeConstIterator(chain, offset + static_cast<uint64_t>(p - data), chunk);
 
-        auto x = i;
-        auto y = v.unsafeBegin();
+        offset += len;
+    }
 
-        for ( ;; ) {
-            if ( x == unsafeEnd() )
-                return std::make_tuple(false, i);
+    return unsafeEnd();
+}
 
-            if ( *x++ != *y++ )
-                break;
+std::tuple<bool, UnsafeConstIterator> View::find(const View& v, UnsafeConstIterator n) const {
+    if ( v.isEmpty() )
+        return std::make_tuple(true, n ? n : UnsafeConstIterator(_begin));
 
-            if ( y == v.unsafeEnd() )
-                return std::make_tuple(true, i);
-        }
-    }
+    // The search kernel needs the needle in contiguous memory. If it's
+    // spanning multiple chunks we need to copy it first.
+    if ( auto block = v.firstBlock(); block && block->is_last && block->size == v.size() )
+        return _findForward(block->start, block->size, n);
+
+    auto needle = v.data();
+    return _findForward(reinterpret_cast<const Byte*>(needle.data()), needle.size().Ref(), n);
 }
 
-std::tuple<bool, UnsafeConstIterator> View::_findForward(const Bytes& v, UnsafeConstIterator n) const {
+std::tuple<bool, UnsafeConstIterator> View::_findForward(const Byte* needle, uint64_t needle_size,
+                                                         UnsafeConstIterator n) const {
     if ( ! n )
         n = UnsafeConstIterator(_begin);
 
-    if ( v.isEmpty() )
+    if ( needle_size == 0 )
         return std::make_tuple(true, n);
 
-    auto first = *v.begin();
+    const auto* chain = n.chain();
+    if ( ! chain )
+        return std::make_tuple(false, n);
+
+    const auto end = std::min(unsafeEnd().offset(), chain->endOffset());
+    auto offset = n.offset();
 
-    for ( auto i = n; true; ++i ) {
-        if ( i == unsafeEnd() )
-            return std::make_tuple(false, i);
+    if ( offset >= end )
+        return std::make_tuple(false, n);
 
-        if ( *i != first )
-            continue;
+    for ( const auto* chunk = chain->findChunk(offset, n.chunk()); chunk && offset < end; chunk = chunk->next() ) {
+        const auto* data = chunk->data(offset);
+        const auto len = (std::min(chunk->endOffset(), end) - offset).Ref();
 
-        auto x = i;
-        auto y = v.begin();
+        // First look for a match residing completely inside the current
+        // block. Any such match precedes matches straddling the block's end.
+        uint64_t straddle = 0;
 
-        for ( ;; ) {
-            if ( x == unsafeEnd() )
-                return std::make_tuple(false, i);
+        if ( len >= needle_size ) {
+            if ( const auto* p = static_cast<const Byte*>(memmem(data, len, needle, needle_size)) )
+                return std::make_tuple(true, UnsafeConstIterator(chain, offset + static_cast<uint64_t>(p - data), chunk));
 
-            if ( *x++ != *y++ )
+            straddle = len - needle_size + 1;
+        }
+
+        // Now check the remaining candidate positions, which need data from
+        // subsequent chunks to match.
+        for ( auto i = straddle; i < len; ++i ) {
+            const auto* p = static_cast<const Byte*>(memchr(data + i, needle[0], len - i));
+            if ( ! p )
                 break;
 
-            if ( y == v.end() )
-                return std::make_tuple(true, i);
+            i = static_cast<uint64_t>(p - data);
+
+            switch ( matchAt(chunk, offset + i, end, needle, needle_size) ) {
+                case Match::No: break;
+                case Match::Yes: return std::make_tuple(true, UnsafeConstIterator(chain, offset + i, chunk));
+                case Match::Partial:
+                    // We ran out of data, so this is the first position that
+                    // may still match once more data arrives.
+                    return std::make_tuple(false, UnsafeConstIterator(chain, offset + i, chunk));
+            }
         }
+
+        offset += len;
     }
+
+    return std::make_tuple(false, UnsafeConstIterator(chain, offset, nullptr));
 }
 
 std::tuple<bool, UnsafeConstIterator> View::_findBackward(const Bytes& needle, UnsafeConstIterator i) const {
@@ -274,29 +354,41 @@ std::tuple<bool, UnsafeConstIterator> View::_findBackward(const Bytes& needle, U
     if ( needle.size() > (i.offset() - offset()) )
         return std::make_tuple(false, UnsafeConstIterator());
 
-    i -= (needle.size() - 1).Ref(); // this is safe now, get us 1st position where initial character may match
+    const auto* chain = i.chain();
+    const auto* data = reinterpret_cast<const Byte*>(needle.data());
+    const auto size = needle.size().Ref();
+    const auto first = data[0];
+    const auto begin = offset();
 
-    auto first = *needle.begin();
+    // 1st position where initial character may match; this is safe now.
+    auto j = std::min(i.offset() - (size - 1), chain->endOffset() - 1);
 
-    // The following is not the most efficient way to search backwards, but
-    // it'll do for now.
-    for ( auto j = i; true; --j ) {
-        if ( *j == first ) {
-            auto x = j;
-            auto y = needle.begin();
+    // The chain is singly linked, so we locate the chunk for each block
+    // separately but then scan the block's raw memory backwards.
+    for ( ;; ) {
+        const auto* chunk = chain->findChunk(j);
+        if ( ! chunk )
+            break;
 
-            for ( ;; ) {
-                if ( *x++ != *y++ )
-                    break;
+        const auto* p = chunk->data(j);
+        const auto n = (j - std::max(chunk->offset(), begin)).Ref();
 
-                if ( y == needle.end() )
-                    return std::make_tuple(true, j);
-            }
+        for ( uint64_t k = 0; k <= n; ++k ) {
+            if ( *(p - k) != first )
+                continue;
+
+            auto pos = j - k;
+            if ( matchAt(chunk, pos, chain->endOffset(), data, size) == Match::Yes )
+                return std::make_tuple(true, UnsafeConstIterator(chain, pos, chunk));
         }
 
-        if ( j == unsafeBegin() )
-            return std::make_tuple(false, j);
+        if ( chunk->offset() <= begin )
+            break;
+
+        j = chunk->offset() - 1;
     }
+
+    return std::make_tuple(false, unsafeBegin());
 }
 
 void View::_force_vtable() {}
@@ -394,14 +486,22 @@ void Stream::append(Bytes&& data) {
     if ( data.isEmpty() )
         return;
 
-    _chain->append(std::make_unique<Chunk>(0, data.str()));
+    if ( data.size() <= Chunk::SmallBufferSize ) {
+        _chain->append(std::make_unique<Chunk>(0, data.data(), data.size()));
+        return;
+    }
+
+    // Take over the data's memory instead of copying it.
+    auto owner = std::make_shared<const std::string>(std::move(data).str());
+    _chain->append(
+        std::make_unique<Chunk>(0, reinterpret_cast<const Byte*>(owner->data()), owner->size(), std::move(owner)));
 }
 
 void Stream::append(const Bytes& data) {
     if ( data.isEmpty() )
         return;
 
-    _chain->append(std::make_unique<Chunk>(0, data.str()));
+    _chain->append(reinterpret_cast<const Byte*>(data.data()), data.size());
 }
 
 void Stream::append(const char* data, size_t len) {
@@ -409,11 +509,20 @@ void Stream::append(const char* data, size_t len) {
         return;
 
     if ( data )
-        _chain->append(std::make_unique<Chunk>(0, std::string(data, len)));
+        _chain->append(reinterpret_cast<const Byte*>(data), len);
     else
         _chain->append(std::make_unique<Chunk>(0, len));
 }
 
+void Stream::append(const char* data, size_t len, std::shared_ptr<const void> owner) {
+    if ( ! data || ! owner || len <= Chunk::SmallBufferSize ) {
+        append(data, len);
+        return;
+    }
+
+    _chain->append(std::make_unique<Chunk>(0, reinterpret_cast<const Byte*>(data), len, std::move(owner)));
+}
+
 std::string stream::View::dataForPrint() const {
     std::string data;
 
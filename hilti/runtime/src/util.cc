@@ -61,6 +61,11 @@ hilti::rt::ResourceUsage hilti::rt::resource_usage() {
     stats.max_fibers = fibers.max;
     stats.max_fiber_stack_size = fibers.max_stack_size;
     stats.cached_fibers = fibers.cached;
+    stats.fiber_cache_hits = fibers.cache_hits;
+    stats.fiber_cache_misses = fibers.cache_misses;
+    stats.fiber_swap_size = fibers.swap_size;
+    stats.fiber_swap_pooled = fibers.swap_pooled;
+    stats.fiber_released = fibers.released;
 
     return stats;
 }
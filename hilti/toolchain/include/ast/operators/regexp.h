@@ -47,9 +47,8 @@ Different from ``match``, this does not anchor the expression to the beginning
 of the data: it will find matches at arbitrary starting positions. Returns a
 2-tuple with (1) an integer match indicator with the same semantics as that
 returned by ``find``; and (2) if a match has been found, the data that matches
-the regular expression. (Note: Currently this function has a runtime that's
-quadratic in the size of *data*; consider using `match` if performance is an
-issue.)
+the regular expression. If there are multiple matches, the left-most one is
+returned; among matches starting at the same position, the longest.
 )"};
         return _signature;
     }
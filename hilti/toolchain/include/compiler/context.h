@@ -4,6 +4,7 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -50,6 +51,11 @@ struct Options {
     std::vector<std::string> cxx_link; /**< additional static archives or shared libraries to link during JIT */
     bool cxx_enable_dynamic_globals =
         false; /**< if true, allocate globals dynamically at runtime for (future) thread safety */
+    bool regexp_eager_dfa = false; /**< if true, generate code that computes the complete DFA of constant regular
+                                      expressions at initialization time, instead of lazily while matching */
+    std::optional<hilti::rt::filesystem::path>
+        jit_cache; /**< directory to cache compiled objects and libraries in across JIT runs; if unset, the
+                      `HILTI_JIT_CACHE` environment variable may provide one */
 
     /**
      * Retrieves the value for an auxiliary option.
@@ -6,6 +6,7 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <string_view>
@@ -58,6 +59,8 @@ struct Options {
     bool dump_code = false;             /**< Record all final HILTI and C++ code to disk for debugging. */
     bool global_optimizations = true;   /**< whether to run global HILTI optimizations on the generated code. */
     bool enable_profiling = false;      /**< Insert profiling instrumentation into generated C++ code */
+    std::optional<hilti::rt::filesystem::path>
+        profiling_stacks; /**< file to write profiled call paths to in folded stack format */
     std::vector<hilti::rt::filesystem::path>
         inputs; /**< files to compile; these will be automatically pulled in by ``Driver::run()`` */
     hilti::rt::filesystem::path output_path; /**< file to store output in (default if empty is printing to stdout) */
@@ -361,6 +364,14 @@ protected:
      */
     virtual std::string hookAddCommandLineOptions() { return ""; }
 
+    /**
+     * Hook for derived classes to add long versions of options they add
+     * through `hookAddCommandLineOptions()`. Each entry maps the name of a
+     * long option to its short option. Only options that do not take an
+     * argument are supported.
+     */
+    virtual std::vector<std::pair<std::string, int>> hookAddLongCommandLineOptions() { return {}; }
+
     /** Hook for derived classes for parsing additional options. */
     virtual bool hookProcessCommandLineOption(int opt, const char* optarg) { return false; }
 
@@ -466,6 +477,9 @@ private:
     void _saveIterationAST(const std::shared_ptr<Unit>& unit, const Plugin& plugin, const std::string& prefix,
                            const std::string& tag);
 
+    // Returns the number of nodes in a unit's AST.
+    uint64_t _countNodes(const std::shared_ptr<Unit>& unit);
+
     /**
      * Look up a symbol in the global namespace.
      *
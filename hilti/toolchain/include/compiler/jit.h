@@ -6,6 +6,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -171,6 +172,13 @@ public:
     /** Returns the compiler options in use. */
     auto options() const { return context()->options(); }
 
+    /**
+     * Returns the maximum number of jobs to run in parallel. This honors
+     * `HILTI_JIT_SEQUENTIAL` and `HILTI_JIT_PARALLELISM`, and otherwise
+     * defaults to the number of available CPUs.
+     */
+    static uint64_t parallelism();
+
 private:
     // Check if we have a working compiler.
     hilti::Result<Nothing> _checkCompiler();
@@ -184,12 +192,35 @@ private:
     // Clean up after compilation.
     void _finish();
 
+    // Returns the arguments for compiling C++ code, excluding input and output.
+    std::vector<std::string> _compileArgs() const;
+
+    // Returns the arguments for linking object files, excluding inputs and output.
+    std::vector<std::string> _linkArgs() const;
+
+    // Determines the cache directory, if any, and computes cache keys for all inputs.
+    void _initCache();
+
+    // Returns the location of a cache entry, or nothing if not caching.
+    std::optional<hilti::rt::filesystem::path> _cachePath(std::optional<std::size_t> key, const char* extension) const;
+
+    // Copies a file into the cache at the given location.
+    void _storeInCache(const hilti::rt::filesystem::path& path, const hilti::rt::filesystem::path& cached) const;
+
+    // Returns the library from the cache if it has been built before.
+    std::shared_ptr<const Library> _cachedLibrary() const;
+
     std::weak_ptr<Context> _context; // global context for options
     bool _dump_code;                 // save all C++ code for debugging
 
     std::vector<hilti::rt::filesystem::path> _files; // all added source files
     std::vector<CxxCode> _codes;                     // all C++ code units to be compiled
-    std::vector<hilti::rt::filesystem::path> _objects;
+    std::vector<hilti::rt::filesystem::path> _objects;        // object files compiled by us
+    std::vector<hilti::rt::filesystem::path> _cached_objects; // object files taken from the cache
+
+    std::optional<hilti::rt::filesystem::path> _cache_directory; // directory to cache results in, if enabled
+    std::vector<std::optional<std::size_t>> _object_keys; // cache keys for the objects of `_files`, then `_codes`
+    std::optional<std::size_t> _library_key;              // cache key for the linked library, if all inputs have one
 
     struct Job {
         std::unique_ptr<reproc::process> process;
@@ -154,9 +154,26 @@ public:
     /**
      * Triggers generation of C++ code from the compiled AST.
      *
+     * @param finalize if false, stops short of rendering the final C++ code;
+     * `finalizeCxx()` must then be called once before the code can be used
      * @returns success if no error occurred, and an appropriate error otherwise
      */
-    Result<Nothing> codegen();
+    Result<Nothing> codegen(bool finalize = true);
+
+    /**
+     * Renders the final C++ code after `codegen(false)`. This touches only
+     * the unit's own state, so different units may run it concurrently.
+     *
+     * @returns success if no error occurred, and an appropriate error otherwise
+     */
+    Result<Nothing> finalizeCxx();
+
+    /**
+     * Discards any C++ code derived from the unit's AST so far, so that it
+     * will be generated anew when next needed. This must be called when the
+     * AST changes after code generation.
+     */
+    void clearCxx() { _cxx_declarations.reset(); }
 
     /**
      *
@@ -402,6 +419,10 @@ private:
     // Recursively destroys the module's AST.
     void _destroyModule();
 
+    // Returns the C++ declarations that other units importing this one need,
+    // generating them on first use.
+    const detail::cxx::Unit& _cxxDeclarations();
+
     // Helper for dependencies() to recurse.
     void _recursiveDependencies(std::vector<std::weak_ptr<Unit>>* dst, std::unordered_set<const Unit*>* seen) const;
 
@@ -409,15 +430,16 @@ private:
     static Result<hilti::Module> _parse(const std::shared_ptr<Context>& context,
                                         const hilti::rt::filesystem::path& path);
 
-    context::CacheIndex _index;                     // index for the context's module cache
-    ID _unique_id;                                  // globally unique ID for this module
-    hilti::rt::filesystem::path _extension;         // AST extension, which may differ from source file
-    std::optional<Node> _module;                    // root node for AST (always a `Module`), if available
-    std::vector<std::weak_ptr<Unit>> _dependencies; // recorded dependencies
-    std::weak_ptr<Context> _context;                // global context
-    std::optional<detail::cxx::Unit> _cxx_unit;     // compiled C++ code for this unit, once available
-    bool _resolved = false;                         // state of resolving the AST
-    bool _requires_compilation = false;             // mark explicitly as requiring compilation to C++
+    context::CacheIndex _index;                         // index for the context's module cache
+    ID _unique_id;                                      // globally unique ID for this module
+    hilti::rt::filesystem::path _extension;             // AST extension, which may differ from source file
+    std::optional<Node> _module;                        // root node for AST (always a `Module`), if available
+    std::vector<std::weak_ptr<Unit>> _dependencies;     // recorded dependencies
+    std::weak_ptr<Context> _context;                    // global context
+    std::optional<detail::cxx::Unit> _cxx_unit;         // compiled C++ code for this unit, once available
+    std::optional<detail::cxx::Unit> _cxx_declarations; // declarations for importing units, once generated
+    bool _resolved = false;                             // state of resolving the AST
+    bool _requires_compilation = false;                 // mark explicitly as requiring compilation to C++
 
     static std::unordered_map<ID, unsigned int> _uid_cache; // cache storing state for generating globally unique IDs
 };
@@ -572,6 +572,18 @@ struct Visitor : hilti::visitor::PreOrder<void, Visitor> {
             }
 
             body.addLambda("cb", "[args_on_heap](hilti::rt::resumable::Handle* r) -> hilti::rt::any", std::move(cb));
+
+            if ( auto attr = AttributeSet::find(f.attributes(), "&run-directly-if-frozen") ) {
+                // With its input frozen, the function cannot need to wait
+                // for more, so we may skip the fiber if so configured.
+                auto input = cxx::ID(*attr->valueAsString());
+                auto enable = fmt(
+                    "::hilti::rt::configuration::detail::unsafeGet().fiber_bypass_on_frozen_input && %s->isFrozen()",
+                    input);
+
+                body.addLocal({"run_directly", "auto", {}, fmt("::hilti::rt::resumable::RunDirectly(%s)", enable)});
+            }
+
             body.addLocal({"r", "auto", {}, "std::make_unique<hilti::rt::Resumable>(std::move(cb))"});
             body.addStatement("r->run()");
             body.addReturn("std::move(*r)");
@@ -819,7 +831,15 @@ cxx::Expression CodeGen::startProfiler(const std::string& name, cxx::Block* bloc
     assert(block);
     pushCxxBlock(block);
     auto id = addTmp("profiler", cxx::Type("std::optional<hilti::rt::Profiler>"));
-    auto stmt = cxx::Expression(fmt("%s = hilti::rt::profiler::start(\"%s\")", id, name));
+
+    // Intern the name just once, on first execution, so that starting the
+    // profiler doesn't need to look it up.
+    auto profiler_id = cxx::ID(fmt("%s_id", id));
+    cxxBlock()->addTmp(cxx::declaration::Local(profiler_id, cxx::Type("hilti::rt::profiler::ID"), {},
+                                               cxx::Expression(fmt("hilti::rt::profiler::intern(\"%s\")", name)),
+                                               "static const"));
+
+    auto stmt = cxx::Expression(fmt("%s = hilti::rt::profiler::start(%s)", id, profiler_id));
 
     if ( insert_at_front )
         cxxBlock()->addStatementAtFront(stmt);
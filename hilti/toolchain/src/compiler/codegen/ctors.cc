@@ -149,6 +149,9 @@ struct Visitor : hilti::visitor::PreOrder<cxx::Expression, Visitor> {
         if ( n.isNoSub() )
             flags.emplace_back(".no_sub = true");
 
+        if ( cg->options().regexp_eager_dfa )
+            flags.emplace_back(".eager = true");
+
         auto t = (n.value().size() == 1 ? "std::string" : "std::vector<std::string>");
         return fmt("::hilti::rt::RegExp(%s{%s}, {%s})", t,
                    util::join(util::transform(n.value(),
@@ -189,7 +189,11 @@ struct Visitor : hilti::visitor::PreOrder<void, Visitor> {
             cxx::Block b;
             b.setEnsureBracesforBlock();
             b.addTmp(cxx::declaration::Local{"__seq", "auto", {}, seq});
-            b.addForRange(true, id, fmt("::hilti::rt::range(__seq)"), body);
+
+            // Nothing can access the temporary besides the loop itself, so
+            // it cannot change during iteration and we can skip checking
+            // the iterators.
+            b.addForRange(true, id, fmt("::hilti::rt::range_unchecked(__seq)"), body);
             block->addBlock(std::move(b));
         }
     }
@@ -55,6 +55,8 @@ void Options::print(std::ostream& out) const {
     print_one("cxx_namespace_extern", cxx_namespace_extern);
     print_one("cxx_namespace_intern", cxx_namespace_intern);
     print_list("addl cxx_include_paths", cxx_include_paths);
+    print_one("regexp_eager_dfa", regexp_eager_dfa);
+    print_one("jit_cache", (jit_cache ? jit_cache->native() : std::string("<none>")));
 
     out << "\n";
 }
@@ -3,10 +3,14 @@
 #include <dlfcn.h>
 #include <getopt.h>
 
+#include <atomic>
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <hilti/rt/json.h>
 #include <hilti/rt/libhilti.h>
@@ -30,6 +34,7 @@ inline const DebugStream AstFinal("ast-final");
 inline const DebugStream AstOrig("ast-orig");
 inline const DebugStream AstPrintTransformed("ast-print-transformed");
 inline const DebugStream AstResolved("ast-resolved");
+inline const DebugStream AstStats("ast-stats");
 inline const DebugStream AstTransformed("ast-transformed");
 inline const DebugStream Compiler("compiler");
 inline const DebugStream Driver("driver");
@@ -37,6 +42,9 @@ inline const DebugStream Driver("driver");
 
 constexpr int OPT_CXX_LINK = 1000;
 constexpr int OPT_CXX_ENABLE_DYNAMIC_GLOBALS = 1001;
+constexpr int OPT_REGEXP_EAGER_DFA = 1002;
+constexpr int OPT_PROFILING_STACKS = 1003;
+constexpr int OPT_JIT_CACHE = 1004;
 
 static struct option long_driver_options[] = {{"abort-on-exceptions", required_argument, nullptr, 'A'},
                                               {"show-backtraces", no_argument, nullptr, 'B'},
@@ -50,6 +58,7 @@ static struct option long_driver_options[] = {{"abort-on-exceptions", required_a
                                               {"enable-profiling", no_argument, nullptr, 'Z'},
                                               {"dump-code", no_argument, nullptr, 'C'},
                                               {"help", no_argument, nullptr, 'h'},
+                                              {"jit-cache", required_argument, nullptr, OPT_JIT_CACHE},
                                               {"keep-tmps", no_argument, nullptr, 'T'},
                                               {"library-path", required_argument, nullptr, 'L'},
                                               {"output", required_argument, nullptr, 'o'},
@@ -61,6 +70,8 @@ static struct option long_driver_options[] = {{"abort-on-exceptions", required_a
                                               {"output-prototypes", no_argument, nullptr, 'P'},
                                               {"output-all-dependencies", no_argument, nullptr, 'e'},
                                               {"output-code-dependencies", no_argument, nullptr, 'E'},
+                                              {"profiling-stacks", required_argument, nullptr, OPT_PROFILING_STACKS},
+                                              {"regexp-eager-dfa", no_argument, nullptr, OPT_REGEXP_EAGER_DFA},
                                               {"report-times", required_argument, nullptr, 'R'},
                                               {"skip-validation", no_argument, nullptr, 'V'},
                                               {"skip-dependencies", no_argument, nullptr, 'S'},
@@ -136,6 +147,11 @@ void Driver::usage() {
            "  -Z | --enable-profiling          Report profiling statistics after execution.\n"
            "       --cxx-link <lib>            Link specified static archive or shared library during JIT or to "
            "produced HLTO file. Can be given multiple times.\n"
+           "       --jit-cache <dir>           Reuse compiled code across JIT runs by caching it in <dir>.\n"
+           "       --profiling-stacks <file>   Implies -Z and writes profiled call paths to <file> in the folded "
+           "stack format used by flamegraph tools.\n"
+           "       --regexp-eager-dfa          Compute complete DFAs for constant regular expressions at startup "
+           "instead of on demand while matching.\n"
         << addl_usage
         << "\n"
            "Inputs can be "
@@ -264,8 +280,17 @@ Result<Nothing> Driver::parseOptions(int argc, char** argv) {
     opterr = 0; // don't print errors
     std::string option_string = "ABlL:cCpPvjhvx:VdX:o:D:TUEeSRgZ" + hookAddCommandLineOptions();
 
+    // Add any long options of derived classes in front of the terminating entry.
+    auto addl_long_options = hookAddLongCommandLineOptions();
+    std::vector<struct option> long_options(std::begin(long_driver_options), std::end(long_driver_options) - 1);
+
+    for ( const auto& [name, opt] : addl_long_options )
+        long_options.push_back({name.c_str(), no_argument, nullptr, opt});
+
+    long_options.push_back({nullptr, 0, nullptr, 0});
+
     while ( true ) {
-        int c = getopt_long(argc, argv, option_string.c_str(), long_driver_options, nullptr);
+        int c = getopt_long(argc, argv, option_string.c_str(), long_options.data(), nullptr);
 
         if ( c < 0 )
             break;
@@ -411,6 +436,16 @@ Result<Nothing> Driver::parseOptions(int argc, char** argv) {
 
             case OPT_CXX_ENABLE_DYNAMIC_GLOBALS: _compiler_options.cxx_enable_dynamic_globals = true; break;
 
+            case OPT_REGEXP_EAGER_DFA: _compiler_options.regexp_eager_dfa = true; break;
+
+            case OPT_JIT_CACHE: _compiler_options.jit_cache = optarg; break;
+
+            case OPT_PROFILING_STACKS:
+                _compiler_options.enable_profiling = true;
+                _driver_options.enable_profiling = true;
+                _driver_options.profiling_stacks = optarg;
+                break;
+
             case 'h': usage(); return Nothing();
 
             case '?': usage(); return error("unknown option");
@@ -642,23 +677,56 @@ Result<Nothing> Driver::_resolveUnitsWithPlugin(const Plugin& plugin, std::vecto
 
     int extra_rounds = 0; // set to >0 for debugging
 
+    // Incremental rounds are cheap, so we bound them separately from full
+    // rounds; otherwise grammars that took many full rounds before could now
+    // run into the limit.
+    const int max_rounds = 50;
+    int full_rounds = 0;
+    int incremental_rounds = 0;
+
+    // Units to process in the current round. After the first round, we only
+    // revisit units that changed in the previous round, or that depend on
+    // one that did. Once nothing changes anymore, we run one more round
+    // across all units to confirm that the ASTs have indeed stabilized.
+    auto dirty = std::unordered_set<const Unit*>();
+    for ( const auto& u : units )
+        dirty.insert(u.get());
+
     while ( true ) {
         HILTI_DEBUG(logging::debug::Compiler, fmt("processing ASTs, round %d", round));
         logging::DebugPushIndent _(logging::debug::Compiler);
 
-        bool modified = false;
+        auto round_units = std::vector<std::shared_ptr<Unit>>();
+        for ( const auto& u : units ) {
+            if ( dirty.count(u.get()) )
+                round_units.push_back(u);
+        }
+
+        auto full_round = (round_units.size() == units.size());
+
+        if ( logger().isEnabled(logging::debug::AstStats) ) {
+            uint64_t nodes = 0;
+            for ( const auto& u : round_units )
+                nodes += _countNodes(u);
+
+            HILTI_DEBUG(logging::debug::AstStats,
+                        fmt("round %d: processing %zu of %zu units with %" PRIu64 " nodes%s", round,
+                            round_units.size(), units.size(), nodes, (full_round ? " (full)" : "")));
+        }
+
+        auto modified = std::unordered_set<const Unit*>();
         std::vector<std::shared_ptr<Unit>> dependencies;
 
-        for ( auto&& u : units )
+        for ( auto&& u : round_units )
             u->resetAST();
 
-        for ( auto&& u : units ) {
+        for ( auto&& u : round_units ) {
             auto rc = u->buildASTScopes(plugin);
             if ( ! rc )
                 return rc.error();
         }
 
-        for ( auto&& u : units ) {
+        for ( auto&& u : round_units ) {
             auto rc = u->resolveAST(plugin);
             if ( ! rc )
                 return rc.error();
@@ -670,7 +738,9 @@ Result<Nothing> Driver::_resolveUnitsWithPlugin(const Plugin& plugin, std::vecto
 
             _dumpAST(u, logging::debug::AstResolved, plugin, "AST after resolving", round);
             _saveIterationAST(u, plugin, "AST after resolving", round);
-            modified = modified || (*rc == Unit::Modified);
+
+            if ( *rc == Unit::Modified )
+                modified.insert(u.get());
         }
 
         // Check for newly encountered dependencies that we need to compile as well.
@@ -682,14 +752,46 @@ Result<Nothing> Driver::_resolveUnitsWithPlugin(const Plugin& plugin, std::vecto
                 HILTI_DEBUG(logging::debug::Compiler,
                             fmt("new dependency to process: %s (%s)", d->uniqueID(), d->extension()));
                 units.push_back(d);
-                modified = true;
+                modified.insert(d.get());
             }
         }
 
-        if ( ! modified && extra_rounds-- == 0 )
-            break;
+        if ( modified.empty() ) {
+            if ( full_round && extra_rounds-- == 0 )
+                break;
+
+            // Confirm with a full round.
+            for ( const auto& u : units )
+                dirty.insert(u.get());
+        }
+        else {
+            dirty.clear();
+
+            for ( const auto& u : units ) {
+                if ( modified.count(u.get()) ) {
+                    dirty.insert(u.get());
+                    continue;
+                }
 
-        if ( ++round >= 50 )
+                for ( const auto& d : u->dependencies(true) ) {
+                    if ( modified.count(d.lock().get()) ) {
+                        dirty.insert(u.get());
+                        break;
+                    }
+                }
+            }
+        }
+
+        ++round;
+
+        if ( full_round ) {
+            ++full_rounds;
+            incremental_rounds = 0;
+        }
+        else
+            ++incremental_rounds;
+
+        if ( full_rounds >= max_rounds || incremental_rounds >= max_rounds )
             logger().internalError("hilti::Unit::compile() didn't terminate, AST keeps changing");
     }
 
@@ -868,11 +970,46 @@ Result<Nothing> Driver::_codegenUnits() {
 
     logging::DebugPushIndent _(logging::debug::Compiler);
 
+    for ( auto& unit : _hlts )
+        unit->clearCxx();
+
     for ( auto& unit : _hlts ) {
         HILTI_DEBUG(logging::debug::Driver, fmt("codegen for input unit %s", unit->uniqueID()));
 
-        if ( auto rc = unit->codegen(); ! rc )
+        if ( auto rc = unit->codegen(false); ! rc )
             return augmentError(rc.error());
+    }
+
+    // Generating code walks ASTs that units share with their dependencies,
+    // so the loop above needs to run sequentially. Rendering the resulting
+    // C++ code, however, touches only each unit's own state; we spread that
+    // across threads.
+    auto threads = std::min(JIT::parallelism(), static_cast<uint64_t>(_hlts.size()));
+    HILTI_DEBUG(logging::debug::Driver, fmt("rendering C++ code for %zu units using %" PRIu64 " thread(s)",
+                                            _hlts.size(), threads));
+
+    std::vector<Result<Nothing>> results(_hlts.size());
+    std::atomic<size_t> next_unit = 0;
+
+    auto render = [&]() {
+        for ( auto i = next_unit++; i < _hlts.size(); i = next_unit++ )
+            results[i] = _hlts[i]->finalizeCxx();
+    };
+
+    std::vector<std::thread> workers;
+    for ( uint64_t i = 1; i < threads; i++ )
+        workers.emplace_back(render);
+
+    render();
+
+    for ( auto& w : workers )
+        w.join();
+
+    for ( size_t i = 0; i < _hlts.size(); i++ ) {
+        const auto& unit = _hlts[i];
+
+        if ( ! results[i] )
+            return augmentError(results[i].error());
 
         if ( auto md = unit->linkerMetaData() )
             _mds.push_back(*md);
@@ -1194,6 +1331,7 @@ Result<Nothing> Driver::initRuntime() {
     config.show_backtraces = _driver_options.show_backtraces;
     config.report_resource_usage = _driver_options.report_resource_usage;
     config.enable_profiling = _driver_options.enable_profiling;
+    config.profiling_stacks = _driver_options.profiling_stacks;
     hilti::rt::configuration::set(config);
 
     try {
@@ -1332,3 +1470,16 @@ void Driver::_saveIterationAST(const std::shared_ptr<Unit>& unit, const Plugin&
     std::ofstream out(fmt("ast-%s-%s.tmp", plugin.component, tag));
     _dumpAST(unit, out, plugin, prefix, 0);
 }
+
+uint64_t Driver::_countNodes(const std::shared_ptr<Unit>& unit) {
+    if ( ! unit->isCompiledHILTI() )
+        return 0;
+
+    uint64_t n = 0;
+
+    auto v = hilti::visitor::PreOrder<>();
+    for ( [[maybe_unused]] auto&& i : v.walk(&unit->module()) )
+        ++n;
+
+    return n;
+}
@@ -189,6 +189,13 @@ JIT::~JIT() { _finish(); }
 hilti::Result<std::shared_ptr<const Library>> JIT::build() {
     util::timing::Collector _("hilti/jit");
 
+    _initCache();
+
+    if ( auto library = _cachedLibrary() ) {
+        _finish();
+        return library;
+    }
+
     if ( auto rc = _checkCompiler(); ! rc )
         return rc.error();
 
@@ -247,24 +254,208 @@ void JIT::_finish() {
         }
 
     _objects.clear();
+    _cached_objects.clear();
 
     _runner.finish();
 }
 
+std::vector<std::string> JIT::_compileArgs() const {
+    std::vector<std::string> args = {"-c"};
+
+    if ( options().debug )
+        args = hilti::util::concat(args, hilti::configuration().hlto_cxx_flags_debug);
+    else
+        args = hilti::util::concat(args, hilti::configuration().hlto_cxx_flags_release);
+
+    // For debug output on compilation:
+    // args.push_back("-v");
+    // args.push_back("-###");
+
+    for ( const auto& i : options().cxx_include_paths ) {
+        args.emplace_back("-I");
+        args.push_back(i);
+    }
+
+    if ( auto path = hilti::rt::getenv("HILTI_CXX_INCLUDE_DIRS") ) {
+        for ( auto&& dir : hilti::rt::split(*path, ":") ) {
+            if ( ! dir.empty() ) {
+                args.insert(args.begin(), {"-I", std::string(dir)});
+            }
+        }
+    }
+
+    if ( auto flags = hilti::rt::getenv("HILTI_CXX_FLAGS") )
+        args.push_back(*flags);
+
+    return args;
+}
+
+std::vector<std::string> JIT::_linkArgs() const {
+    if ( options().debug )
+        return hilti::configuration().hlto_ld_flags_debug;
+    else
+        return hilti::configuration().hlto_ld_flags_release;
+}
+
+void JIT::_initCache() {
+    _cache_directory = options().jit_cache;
+    _object_keys.clear();
+    _library_key.reset();
+
+    if ( ! _cache_directory ) {
+        if ( auto dir = hilti::rt::getenv("HILTI_JIT_CACHE"); dir && ! dir->empty() )
+            _cache_directory = *dir;
+        else
+            return;
+    }
+
+    std::error_code ec;
+    hilti::rt::filesystem::create_directories(*_cache_directory, ec);
+    if ( ec ) {
+        logger().warning(util::fmt("cannot use JIT cache directory %s: %s", *_cache_directory, ec.message()));
+        _cache_directory.reset();
+        return;
+    }
+
+    // The key of an object file covers the source code along with everything
+    // else that affects compilation. Note that it does not cover the content
+    // of any headers included by the code beyond what the version captures.
+    const auto version = hilti::configuration().version_string_long;
+    const auto cxx = hilti::configuration().cxx.native();
+    const auto compile_hash =
+        std::hash<std::string>{}(util::fmt("%s|%s|%s", version, cxx, util::join(_compileArgs(), " ")));
+
+    for ( const auto& path : _files ) {
+        std::ifstream in(path, std::ios::binary);
+        std::string code{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+        if ( in.fail() && ! in.eof() )
+            _object_keys.emplace_back(); // cannot cache this one
+        else
+            _object_keys.emplace_back(hilti::rt::hashCombine(std::hash<std::string>{}(code), compile_hash));
+    }
+
+    for ( const auto& code : _codes )
+        _object_keys.emplace_back(hilti::rt::hashCombine(code.hash(), compile_hash));
+
+    // The key of the library covers all of its objects, plus what affects linking.
+    auto library_key =
+        std::hash<std::string>{}(util::fmt("%s|%s|%s", util::join(_linkArgs(), " "), util::join(options().cxx_link, " "),
+                                           _object_keys.size()));
+
+    for ( const auto& key : _object_keys ) {
+        if ( ! key )
+            return;
+
+        library_key = hilti::rt::hashCombine(library_key, *key);
+    }
+
+    _library_key = library_key;
+}
+
+std::optional<hilti::rt::filesystem::path> JIT::_cachePath(std::optional<std::size_t> key,
+                                                           const char* extension) const {
+    if ( ! (_cache_directory && key) )
+        return {};
+
+    return *_cache_directory / util::fmt("%016" PRIx64 "%s", *key, extension);
+}
+
+void JIT::_storeInCache(const hilti::rt::filesystem::path& path, const hilti::rt::filesystem::path& cached) const {
+    // Copy into a temporary file first, then move it into place atomically
+    // so that concurrent processes never see partial content.
+    std::string tmp = cached.native() + ".XXXXXXXXXXXX";
+    if ( auto fd = ::mkstemp(tmp.data()); fd == -1 ) {
+        HILTI_DEBUG(logging::debug::Jit, util::fmt("could not create temporary file in cache: %s", strerror(errno)));
+        return;
+    }
+    else
+        ::close(fd);
+
+    std::error_code ec;
+    hilti::rt::filesystem::copy_file(path, tmp, hilti::rt::filesystem::copy_options::overwrite_existing, ec);
+
+    if ( ! ec )
+        hilti::rt::filesystem::rename(tmp, cached, ec);
+
+    if ( ec ) {
+        HILTI_DEBUG(logging::debug::Jit, util::fmt("could not store %s in cache: %s", path, ec.message()));
+        hilti::rt::filesystem::remove(tmp, ec);
+        return;
+    }
+
+    HILTI_DEBUG(logging::debug::Jit, util::fmt("stored %s in cache as %s", path.filename(), cached.filename()));
+}
+
+std::shared_ptr<const Library> JIT::_cachedLibrary() const {
+    auto cached = _cachePath(_library_key, ".hlto");
+    if ( ! cached )
+        return nullptr;
+
+    std::error_code ec;
+    if ( ! hilti::rt::filesystem::exists(*cached, ec) )
+        return nullptr;
+
+    HILTI_DEBUG(logging::debug::Jit, util::fmt("using cached library %s", *cached));
+
+    // The library remains in the cache after use.
+    auto library = std::make_shared<const Library>(*cached);
+
+    if ( _dump_code ) {
+        // Logging to driver because that's where all the other "saving to ..." messages go.
+        auto dbg = "dbg.__library__.hlto";
+        HILTI_DEBUG(logging::debug::Driver, util::fmt("saving library to %s", dbg));
+        library->save(dbg); // will go into current directory
+    }
+
+    return library;
+}
+
 hilti::Result<Nothing> JIT::_compile() {
     util::timing::Collector _("hilti/jit/compile");
 
     if ( ! hasInputs() )
         return Nothing();
 
-    auto cc_files = _files;
+    // Returns the cache key for the object compiled from the i-th input, if caching.
+    auto object_key = [&](size_t i) -> std::optional<std::size_t> {
+        return i < _object_keys.size() ? _object_keys[i] : std::nullopt;
+    };
+
+    // Returns the cached object for the i-th input, if available.
+    auto cached_object = [&](size_t i) -> std::optional<hilti::rt::filesystem::path> {
+        auto cached = _cachePath(object_key(i), ".o");
+        if ( ! cached )
+            return {};
+
+        std::error_code ec;
+        if ( ! hilti::rt::filesystem::exists(*cached, ec) )
+            return {};
+
+        HILTI_DEBUG(logging::debug::Jit, util::fmt("using cached object file %s", cached->filename()));
+        _cached_objects.push_back(*cached);
+        return cached;
+    };
+
+    // Source files to compile, along with where to cache their objects.
+    std::vector<std::pair<hilti::rt::filesystem::path, std::optional<hilti::rt::filesystem::path>>> cc_files;
+
+    for ( size_t i = 0; i < _files.size(); i++ ) {
+        if ( ! cached_object(i) )
+            cc_files.emplace_back(_files[i], _cachePath(object_key(i), ".o"));
+    }
 
     // Remember generated files and remove them on all exit paths.
     bool keep_tmps = options().keep_tmps;
     FileGuard cc_files_generated;
 
     // Write all in-memory code into temporary files.
-    for ( const auto& code : _codes ) {
+    for ( size_t i = 0; i < _codes.size(); i++ ) {
+        const auto& code = _codes[i];
+
+        if ( cached_object(_files.size() + i) )
+            continue;
+
         std::string id = hilti::rt::filesystem::path(code.id());
         if ( id.empty() )
             id = "code"; // dummy name
@@ -281,42 +472,19 @@ hilti::Result<Nothing> JIT::_compile() {
                                         ec); // will save into current directory; ignore errors
         }
 
-        cc_files.push_back(cc);
+        cc_files.emplace_back(cc, _cachePath(object_key(_files.size() + i), ".o"));
         if ( ! keep_tmps )
             cc_files_generated.add(cc);
     }
 
     // Compile all C++ files.
     std::vector<result::Error> errors;
-    for ( const auto& path : cc_files ) {
-        HILTI_DEBUG(logging::debug::Jit, util::fmt("compiling %s", path.filename().native()));
-
-        std::vector<std::string> args = {"-c"};
-
-        if ( options().debug )
-            args = hilti::util::concat(args, hilti::configuration().hlto_cxx_flags_debug);
-        else
-            args = hilti::util::concat(args, hilti::configuration().hlto_cxx_flags_release);
+    std::vector<std::pair<hilti::rt::filesystem::path, hilti::rt::filesystem::path>> objects_to_cache;
 
-        // For debug output on compilation:
-        // args.push_back("-v");
-        // args.push_back("-###");
-
-        for ( const auto& i : options().cxx_include_paths ) {
-            args.emplace_back("-I");
-            args.push_back(i);
-        }
-
-        if ( auto path = hilti::rt::getenv("HILTI_CXX_INCLUDE_DIRS") ) {
-            for ( auto&& dir : hilti::rt::split(*path, ":") ) {
-                if ( ! dir.empty() ) {
-                    args.insert(args.begin(), {"-I", std::string(dir)});
-                }
-            }
-        }
+    for ( const auto& [path, cached] : cc_files ) {
+        HILTI_DEBUG(logging::debug::Jit, util::fmt("compiling %s", path.filename().native()));
 
-        if ( auto flags = hilti::rt::getenv("HILTI_CXX_FLAGS") )
-            args.push_back(*flags);
+        auto args = _compileArgs();
 
         // We explicitly create the object file in the temporary directory.
         // This ensures that we use a temp path for object files created for
@@ -328,6 +496,9 @@ hilti::Result<Nothing> JIT::_compile() {
         args.push_back(obj);
         _objects.push_back(obj);
 
+        if ( cached )
+            objects_to_cache.emplace_back(obj, *cached);
+
         args.push_back(hilti::rt::filesystem::canonical(path));
 
         auto cxx = hilti::configuration().cxx;
@@ -343,6 +514,11 @@ hilti::Result<Nothing> JIT::_compile() {
     if ( auto rc = _runner._waitForJobs(); ! rc )
         errors.push_back(rc.error());
 
+    if ( errors.empty() ) {
+        for ( const auto& [obj, cached] : objects_to_cache )
+            _storeInCache(obj, cached);
+    }
+
     if ( ! errors.empty() )
         return errors.front();
 
@@ -353,16 +529,11 @@ hilti::Result<std::shared_ptr<const Library>> JIT::_link() {
     util::timing::Collector _("hilti/jit/link");
     HILTI_DEBUG(logging::debug::Jit, "linking object files");
 
-    if ( _objects.empty() )
+    if ( _objects.empty() && _cached_objects.empty() )
         return result::Error("no object code to link");
 
     // Link all object files together into a shared library.
-    std::vector<std::string> args;
-
-    if ( options().debug )
-        args = hilti::configuration().hlto_ld_flags_debug;
-    else
-        args = hilti::configuration().hlto_ld_flags_release;
+    std::vector<std::string> args = _linkArgs();
 
     // Create a random temporary file owned only by us so we are not racing
     // with other processes attempting to create the same output file.
@@ -378,7 +549,7 @@ hilti::Result<std::shared_ptr<const Library>> JIT::_link() {
     args.emplace_back("-o");
     args.push_back(lib0);
 
-    for ( const auto& path : _objects ) {
+    for ( const auto& path : util::concat(_objects, _cached_objects) ) {
         HILTI_DEBUG(logging::debug::Jit, util::fmt("  - %s", path.native()));
 
         // Double check that we really got the file.
@@ -422,6 +593,9 @@ hilti::Result<std::shared_ptr<const Library>> JIT::_link() {
     if ( ec )
         rt::fatalError(util::fmt("could not move file %s to final location %s: %s", lib0, lib, ec.message()));
 
+    if ( auto cached = _cachePath(_library_key, ".hlto") )
+        _storeInCache(lib, *cached);
+
     // Instantiate the library object from the file on disk, and set it up
     // to delete the file & its directory on destruction.
     bool keep_tmps = options().keep_tmps;
@@ -493,12 +667,7 @@ Result<Nothing> JIT::JobRunner::_spawnJob() {
     return {};
 }
 
-Result<Nothing> JIT::JobRunner::_waitForJobs() {
-    if ( _jobs_pending.empty() && _jobs.empty() )
-        return Nothing();
-
-    // Cap parallelism for background jobs.
-    //
+uint64_t JIT::parallelism() {
     // - if `HILTI_JIT_SEQUENTIAL` is used all parallelism is disabled and
     //   exactly one job is used.
     // - if `HILTI_JIT_PARALLELISM` is set it is interpreted as the maximum
@@ -506,8 +675,6 @@ Result<Nothing> JIT::JobRunner::_waitForJobs() {
     // - by default we use one job per available CPU (on some platforms
     //   `std::thread::hardware_concurrency` can return 0, so use one job
     //   there)
-    auto hilti_jit_parallelism = hilti::rt::getenv("HILTI_JIT_PARALLELISM");
-
     uint64_t parallelism = 1;
     if ( hilti::rt::getenv("HILTI_JIT_SEQUENTIAL").has_value() )
         parallelism = 1;
@@ -524,6 +691,16 @@ Result<Nothing> JIT::JobRunner::_waitForJobs() {
         parallelism = std::max(j, 1U);
     }
 
+    return parallelism;
+}
+
+Result<Nothing> JIT::JobRunner::_waitForJobs() {
+    if ( _jobs_pending.empty() && _jobs.empty() )
+        return Nothing();
+
+    // Cap parallelism for background jobs.
+    auto parallelism = JIT::parallelism();
+
     std::vector<result::Error> errors;
 
     while ( ! _jobs_pending.empty() || ! _jobs.empty() ) {
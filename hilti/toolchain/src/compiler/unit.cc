@@ -244,7 +244,7 @@ Result<Nothing> Unit::transformAST(const Plugin& plugin) {
     return Nothing();
 }
 
-Result<Nothing> Unit::codegen() {
+Result<Nothing> Unit::codegen(bool finalize) {
     if ( ! _module )
         return Nothing();
 
@@ -262,22 +262,45 @@ Result<Nothing> Unit::codegen() {
                                    c.error().description()));
 
     // Import declarations from our dependencies. They will have been compiled
-    // at this point.
-    //
-    // TODO(robin): Would be nice if we had a "cheap" compilation mode that
-    // only generated declarations.
+    // at this point. Each dependency generates its declarations just once,
+    // no matter how many units import it.
     for ( const auto& unit : dependencies(true) ) {
         HILTI_DEBUG(logging::debug::Compiler, fmt("importing declarations from module %s", unit.lock()->uniqueID()));
-        auto other = detail::CodeGen(context()).compileModule(unit.lock()->module(), unit.lock().get(), false);
-        c->importDeclarations(*other);
+        c->importDeclarations(unit.lock()->_cxxDeclarations());
     }
 
+    _cxx_unit = std::move(*c);
+
+    if ( ! finalize )
+        return Nothing();
+
     HILTI_DEBUG(logging::debug::Compiler, fmt("finalizing module %s", uniqueID()));
-    if ( auto x = c->finalize(); ! x )
-        return x.error();
+    return finalizeCxx();
+}
 
-    _cxx_unit = *c;
-    return Nothing();
+Result<Nothing> Unit::finalizeCxx() {
+    if ( ! _module )
+        return Nothing(); // nothing generated by `codegen()`
+
+    if ( ! _cxx_unit )
+        return result::Error("no C++ code available for unit");
+
+    // Note: This must not log anything, as it may run concurrently for
+    // different units.
+    return _cxx_unit->finalize();
+}
+
+const detail::cxx::Unit& Unit::_cxxDeclarations() {
+    if ( ! _cxx_declarations ) {
+        auto c = detail::CodeGen(context()).compileModule(*_module, this, false);
+        if ( ! c )
+            logger().internalError(fmt("generating declarations for module %s failed (%s)", uniqueID(),
+                                       c.error().description()));
+
+        _cxx_declarations = std::move(*c);
+    }
+
+    return *_cxx_declarations;
 }
 
 Result<Nothing> Unit::print(std::ostream& out) const {
@@ -461,6 +484,8 @@ void Unit::resetAST() {
 
     HILTI_DEBUG(logging::debug::Compiler, fmt("resetting nodes for module %s", uniqueID()));
 
+    clearCxx();
+
     auto v = hilti::visitor::PreOrder<>();
     for ( auto&& i : v.walk(&*_module) ) {
         i.node.clearScope();
@@ -12,6 +12,8 @@
 #include <hilti/ast/node.h>
 #include <hilti/ast/type.h>
 #include <hilti/ast/types/function.h>
+#include <hilti/ast/types/reference.h>
+#include <hilti/ast/types/stream.h>
 #include <hilti/base/logger.h>
 #include <hilti/compiler/detail/visitors.h>
 #include <hilti/global.h>
@@ -105,6 +107,28 @@ struct VisitorPost : public hilti::visitor::PreOrder<void, VisitorPost>, public
                 else if ( auto x = prio->valueAsInteger(); ! x )
                     error(x.error(), p);
             }
+
+            if ( auto attr = attrs->find("&run-directly-if-frozen") ) {
+                if ( f.callingConvention() != function::CallingConvention::Extern )
+                    error("&run-directly-if-frozen is only supported for extern functions", p);
+
+                else if ( auto x = attr->valueAsString(); ! x )
+                    error(x.error(), p);
+
+                else {
+                    auto params = f.ftype().parameters();
+                    auto param = std::find_if(params.begin(), params.end(),
+                                              [&](const auto& q) { return q.id() == ID(*x); });
+
+                    auto is_stream = [](const Type& t) {
+                        auto vr = t.tryAs<type::ValueReference>();
+                        return vr && vr->dereferencedType().isA<type::Stream>();
+                    };
+
+                    if ( param == params.end() || ! is_stream(param->type()) )
+                        error("&run-directly-if-frozen must name a parameter of type value_ref<stream>", p);
+                }
+            }
         }
     }
 
@@ -78,6 +78,12 @@ public:
     hilti::rt::Bytes finish();
 
 private:
+    // Encodes data, appending the result to `out`.
+    void _encode(const char* data, size_t len, std::string* out);
+
+    // Decodes data, appending the result to `out`.
+    void _decode(const char* data, size_t len, std::string* out);
+
     std::shared_ptr<detail::State> _state;
 };
 
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -28,6 +29,20 @@ struct Configuration {
      * the caller.
      */
     std::optional<std::function<void(const std::string&)>> hook_decline_input;
+
+    /**
+     * If non-zero, the driver's parsing state allocates the reference-managed
+     * values created while parsing a top-level unit from an arena dedicated to
+     * that unit, up to this many bytes. Any further allocations fall back to
+     * the heap. Zero disables arena allocation.
+     *
+     * Memory allocated from an arena is released only once all of it is
+     * unused: any value that outlives the parse, such as a unit handed to
+     * host code, keeps its unit's complete arena alive. The driver starts a
+     * new arena for each top-level unit it parses, such as for each block of
+     * block-based input, so that memory doesn't accumulate across units.
+     */
+    size_t parse_arena_size = 0;
 };
 
 namespace configuration {
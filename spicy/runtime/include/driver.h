@@ -2,11 +2,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
 
+#include <hilti/rt/arena.h>
+#include <hilti/rt/filesystem.h>
 #include <hilti/rt/result.h>
 
 #include <spicy/rt/parser.h>
@@ -101,6 +105,47 @@ public:
      */
     State process(size_t size, const char* data) { return _process(size, data, false); }
 
+    /**
+     * Like `process()`, but passes the data into parsing without copying it
+     * where possible.
+     *
+     * @param size length of data
+     * @param data pointer to *size* bytes to feed into parsing. If this is a nullptr a gap of length *size* will be
+     * processed.
+     * @param owner reference to whatever owns *data*; parsing may retain this, and the data must remain valid and
+     * unchanged for as long as it's alive
+     * @returns Returns `State` indicating if parsing remains ongoing or has finished.
+     * @throws any exceptions (including in particular parse errors) are
+     * passed through to caller
+     */
+    State process(size_t size, const char* data, std::shared_ptr<const void> owner) {
+        return _process(size, data, false, std::move(owner));
+    }
+
+    /**
+     * Like `process()`, but optimized for block-based parsing of many small,
+     * independent blocks, such as individual datagrams. As the block is
+     * complete, parsing cannot need to wait for further input. This method
+     * takes advantage of that by letting the parser access the caller's
+     * memory directly, without copying it, and by executing the parser on
+     * the caller's stack instead of inside a fiber. Each block is parsed
+     * from a new input stream, and parsing does not reference *data* anymore
+     * once this returns: any stream copies taken during parsing hold their
+     * own copy of the data, and the input stream itself gets emptied. A
+     * parser that attempts to suspend anyway
+     * (e.g., through an explicit `yield`) fails with a runtime error.
+     *
+     * For stream-based parsing, this is equivalent to `process()`.
+     *
+     * @param size length of data
+     * @param data pointer to *size* bytes to feed into parsing; it needs to remain valid only until the method
+     * returns. If this is a nullptr a gap of length *size* will be processed.
+     * @returns Returns `State` indicating if parsing remains ongoing or has finished.
+     * @throws any exceptions (including in particular parse errors) are
+     * passed through to caller
+     */
+    State processBlock(size_t size, const char* data);
+
     /**
      * Finalizes parsing, signaling end-of-data to the parser. After calling
      * this, `process()` can no longer be called.
@@ -118,6 +163,7 @@ public:
     void reset() {
         _input.reset();
         _resumable.reset();
+        _arena.reset();
         _done = false;
         _skip = false;
     }
@@ -136,7 +182,11 @@ protected:
     void debug(const std::string& msg, size_t size, const char* data);
 
 private:
-    State _process(size_t size, const char* data, bool eod = true);
+    State _process(size_t size, const char* data, bool eod = true, std::shared_ptr<const void> owner = {},
+                   bool direct = false);
+
+    // Returns a new arena for parsing a unit, or null if arenas are disabled.
+    std::shared_ptr<hilti::rt::Arena> _newArena();
 
     ParsingType _type;                   /**< type of parsing */
     const Parser* _parser;               /**< parser to use, or null if not specified */
@@ -147,6 +197,10 @@ private:
     bool _done = false; /**< flag to indicate that stream matching has completed (either regularly or irregularly) */
     std::optional<hilti::rt::ValueReference<hilti::rt::Stream>> _input; /**< Current input data */
     std::optional<hilti::rt::Resumable> _resumable; /**< State for resuming parsing on next data chunk */
+    std::shared_ptr<hilti::rt::Arena> _arena;       /**< Arena of the unit currently being parsed, if enabled */
+
+    // State for block parsing only
+    std::optional<hilti::rt::ValueReference<hilti::rt::Stream>> _block_input; /**< Input of the current `processBlock()` */
 };
 
 /** Specialized parsing state for use by *Driver*. */
@@ -195,6 +249,13 @@ struct ConnectionState {
     ParsingStateForDriver* resp_state = nullptr;
 };
 
+namespace detail {
+struct BatchCommand;
+class BatchReader;
+struct BatchState;
+class BatchWorker;
+} // namespace detail
+
 } // namespace driver
 
 /** Exception thrown when a unit type is requested for parsing that isn't useable. */
@@ -250,20 +311,52 @@ public:
      * format. See the documentation of `spicy-driver` for a reference of the
      * batch format.
      *
+     * If more than one thread is requested, flows and connections get
+     * distributed across that many worker threads by their IDs, with all
+     * input for a given flow or connection going to the same thread. Each
+     * worker executes parsers inside its own runtime context, which requires
+     * that all code has been compiled with dynamic globals so that every
+     * thread receives its own set of globals. Output produced by different
+     * flows may then interleave in nondeterministic order.
+     *
      * @param in an open stream to read the batch from
+     * @param threads number of worker threads to use; with one, all input is processed on the calling thread
      * @returns appropriate error if there was a problem processing the batch
      */
-    hilti::rt::Result<hilti::rt::Nothing> processPreBatchedInput(std::istream& in);
+    hilti::rt::Result<hilti::rt::Nothing> processPreBatchedInput(std::istream& in, unsigned int threads = 1);
+
+    /**
+     * Processes a batch of input data stored in a file, as with the
+     * stream-based version. If possible, this maps the file into memory and
+     * passes the data on to parsers without copying it. Otherwise, such as
+     * when reading from a pipe, it falls back to reading the file as a
+     * stream.
+     *
+     * @param path file to read the batch from
+     * @param threads number of worker threads to use; see the stream-based version
+     * @returns appropriate error if there was a problem processing the batch
+     */
+    hilti::rt::Result<hilti::rt::Nothing> processPreBatchedInput(const hilti::rt::filesystem::path& path,
+                                                                 unsigned int threads = 1);
 
     /** Records a debug message to the `spicy-driver` runtime debug stream. */
     void debug(const std::string& msg);
 
 private:
+    friend class driver::detail::BatchWorker;
+
     void _debugStats(const hilti::rt::ValueReference<hilti::rt::Stream>& data);
     void _debugStats(size_t current_flows, size_t current_connections);
 
-    uint64_t _total_flows = 0;
-    uint64_t _total_connections = 0;
+    // Reads and executes all commands of a batch.
+    hilti::rt::Result<hilti::rt::Nothing> _processPreBatchedInput(driver::detail::BatchReader* reader,
+                                                                  unsigned int threads);
+
+    // Executes a single command from a batch file on the given flow state.
+    void _processBatchCommand(driver::detail::BatchState* state, driver::detail::BatchCommand cmd);
+
+    std::atomic<uint64_t> _total_flows = 0;
+    std::atomic<uint64_t> _total_connections = 0;
 };
 
 } // namespace spicy::rt
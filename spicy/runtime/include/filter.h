@@ -231,6 +231,32 @@ inline void forward(UnitType<U>& unit, const hilti::rt::Bytes& data) {
     return forward(*unit, data);
 }
 
+/**
+ * Forwards data from a filter unit to the unit it's connected to, moving it
+ * into the destination stream without copying. A noop if the unit isn't
+ * connected as a filter to anything.
+ *
+ * @tparam S type compatible with the attribute's defined by the `State` type.
+ */
+template<typename S>
+inline void forward(S& state, hilti::rt::Bytes&& data) {
+    if ( ! state.__forward ) {
+        SPICY_RT_DEBUG_VERBOSE(
+            hilti::rt::fmt("- filter unit %s [%p] is forwarding \"%s\", but not connected to any unit",
+                           S::__parser.name, &state, data));
+        return;
+    }
+
+    SPICY_RT_DEBUG_VERBOSE(hilti::rt::fmt("- filter unit %s [%p] is forwarding \"%s\" to stream %p", S::__parser.name,
+                                          &state, data, state.__forward.get()));
+    state.__forward->append(std::move(data));
+}
+
+template<typename U>
+inline void forward(UnitType<U>& unit, hilti::rt::Bytes&& data) {
+    return forward(*unit, std::move(data));
+}
+
 /**
  * Signals EOD from a filter unit to the unit it's connected to. A noop if
  * the unit isn't connected as a filter to anything.
@@ -16,6 +16,7 @@
 #include <spicy/rt/mime.h>
 #include <spicy/rt/parsed-unit.h>
 #include <spicy/rt/parser.h>
+#include <spicy/rt/serialization.h>
 #include <spicy/rt/sink.h>
 #include <spicy/rt/typedefs.h>
 #include <spicy/rt/util.h>
@@ -3,6 +3,8 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -11,13 +13,16 @@
 
 #include <hilti/rt/exception.h>
 #include <hilti/rt/fiber.h>
+#include <hilti/rt/profiler.h>
 #include <hilti/rt/result.h>
 #include <hilti/rt/type-info.h>
 #include <hilti/rt/types/bytes.h>
 #include <hilti/rt/types/null.h>
 #include <hilti/rt/types/port.h>
 #include <hilti/rt/types/reference.h>
+#include <hilti/rt/types/stream.h>
 #include <hilti/rt/types/struct.h>
+#include <hilti/rt/types/vector.h>
 #include <hilti/rt/util.h>
 
 #include <spicy/rt/filter.h>
@@ -249,13 +254,13 @@ struct Parser {
 
     /** Pre-computed profiler tags used by the runtime driver. */
     struct {
-        std::string prepare_block;
-        std::string prepare_input;
-        std::string prepare_stream;
+        hilti::rt::profiler::ID prepare_block = hilti::rt::profiler::detail::NoID;
+        hilti::rt::profiler::ID prepare_input = hilti::rt::profiler::detail::NoID;
+        hilti::rt::profiler::ID prepare_stream = hilti::rt::profiler::detail::NoID;
 
         operator bool() const {
             // ensure initialization code has run
-            return ! prepare_input.empty();
+            return prepare_input != hilti::rt::profiler::detail::NoID;
         }
     } profiler_tags;
 
@@ -502,6 +507,49 @@ extern bool atEod(hilti::rt::ValueReference<hilti::rt::Stream>& data, const hilt
  */
 inline void backtrack() { throw Backtrack(); }
 
+// Flags a backtrack operation requested without throwing, see `requestBacktrack()`.
+extern HILTI_THREAD_LOCAL bool backtrack_pending;
+
+/**
+ * Requests a backtrack operation without throwing an exception. Parsers
+ * compiled for status-based backtracking turn `self.backtrack()` inside hooks
+ * into this, followed by returning from the hook. The generated code checks
+ * for a pending request whenever it regains control from a hook or a nested
+ * parse function, and then unwinds to the most recent &try by returning
+ * normally.
+ */
+inline void requestBacktrack() { backtrack_pending = true; }
+
+/** Returns true if a backtrack operation has been requested but not yet carried out. */
+inline bool hasPendingBacktrack() { return backtrack_pending; }
+
+/**
+ * Clears a pending backtrack request.
+ *
+ * @return true if a backtrack operation had been requested
+ */
+inline bool takePendingBacktrack() {
+    auto pending = backtrack_pending;
+    backtrack_pending = false;
+    return pending;
+}
+
+/**
+ * Discards any pending backtrack request. Generated parsers do so when they
+ * start parsing, and when they catch an exception that supersedes a request.
+ */
+inline void resetPendingBacktrack() { backtrack_pending = false; }
+
+/**
+ * Turns a pending backtrack request into a `Backtrack` exception. This is
+ * used where control cannot unwind through return values, such as at the
+ * boundary to the host application.
+ */
+inline void raisePendingBacktrack() {
+    if ( takePendingBacktrack() )
+        backtrack();
+}
+
 /**
  * Wrapper around hilti::rt::stream::View::find() that's more convenient to
  * call from Spicy's generated code.
@@ -517,5 +565,66 @@ std::optional<hilti::rt::stream::SafeConstIterator> unitFind(
     const hilti::rt::stream::SafeConstIterator& begin, const hilti::rt::stream::SafeConstIterator& end,
     const std::optional<hilti::rt::stream::SafeConstIterator>& i, const hilti::rt::Bytes& needle,
     hilti::rt::stream::Direction d);
+
+/**
+ * Multi-pattern matcher locating the earliest occurrence of any of a set of
+ * literal sync tokens inside a stream view in a single forward pass. The
+ * matcher compiles the tokens into an Aho-Corasick automaton once at
+ * construction; copies share that automaton.
+ */
+class SyncMatcher {
+public:
+    SyncMatcher() = default;
+
+    /**
+     * Constructor.
+     *
+     * @param patterns literal tokens to search for; must not be empty
+     */
+    explicit SyncMatcher(const hilti::rt::Vector<hilti::rt::Bytes>& patterns);
+
+    /**
+     * Scans data for the earliest position where one of the patterns
+     * starts. If the data ends in the middle of a potential match, or a
+     * potential match extends into a gap, the position where that candidate
+     * begins is returned instead, so that callers never skip over a token
+     * that could still complete once more data becomes available.
+     *
+     * @param cur data to scan
+     * @return number of bytes that can be skipped at the beginning of *cur*
+     * before a (potential) match
+     */
+    uint64_t skip(const hilti::rt::stream::View& cur) const;
+
+private:
+    struct Automaton;
+    std::shared_ptr<const Automaton> _automaton;
+};
+
+/**
+ * Used by generated parsers to create a matcher for a set of literal sync
+ * tokens.
+ *
+ * @param patterns literal tokens to search for
+ */
+inline SyncMatcher createSyncMatcher(const hilti::rt::Vector<hilti::rt::Bytes>& patterns) {
+    return SyncMatcher(patterns);
+}
+
+/**
+ * Used by generated parsers to advance input to the earliest position where
+ * one of the matcher's tokens might start.
+ *
+ * @param matcher matcher for the tokens to look for
+ * @param cur view of the data that's being parsed
+ * @return *cur* advanced to the (potential) match, or to its end if the
+ * data doesn't contain one
+ */
+inline hilti::rt::stream::View syncAdvance(const SyncMatcher& matcher, const hilti::rt::stream::View& cur) {
+    if ( auto n = matcher.skip(cur) )
+        return cur.advance(n);
+
+    return cur;
+}
 } // namespace detail
 } // namespace spicy::rt
@@ -0,0 +1,225 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+/**
+ * Compact binary serialization of parsed units, along with a reader to
+ * decode the data again.
+ *
+ * A serialized stream starts with a header consisting of the four bytes
+ * `SPKB` followed by a single byte format version. After that, it's a
+ * sequence of messages, each beginning with one byte identifying its kind:
+ *
+ * - `T` (type): `<type-id> <length> <type-definition>` describes the
+ *   schema of a value type. The writer emits it once per type, before the
+ *   first value of that type.
+ *
+ * - `V` (value): `<type-id> <length> <payload>` carries one value of a
+ *   previously described type, encoded according to that type's schema.
+ *
+ * All integers are variable-length encoded (LEB128), with signed values
+ * mapped to unsigned ones first through zigzag encoding. Strings are
+ * length-prefixed, with the length encoded as such an integer. See
+ * `serialization::Kind` for the encoding of type definitions and values.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <hilti/rt/exception.h>
+#include <hilti/rt/type-info.h>
+
+namespace spicy::rt {
+
+/** Exception thrown when reading serialized data that isn't well-formed. */
+HILTI_EXCEPTION(SerializationError, RuntimeError)
+
+namespace serialization {
+
+/** Current version of the serialization format. */
+constexpr uint8_t Version = 1;
+
+/**
+ * Kinds of types the serialization format distinguishes. Runtime types
+ * without a direct representation map to the closest kind, or to `Text` for
+ * a string rendering of their value.
+ *
+ * A type definition consists of the kind as one byte, followed by
+ * kind-specific data:
+ *
+ * - `SignedInt`, `UnsignedInt`: width in bits as one byte
+ * - `Enum`: name, number of labels, then each label's name and value
+ * - `Struct`: name, number of fields, then each field's name, `FieldFlags` as one byte, and type
+ * - `Tuple`, `Union`, `Bitfield`: number of elements, then each element's name and type
+ * - `Vector`, `Set`, `Optional`: type of the contained elements
+ * - `Map`: key type, then value type
+ * - `StructRef`: index of a struct defined earlier inside the same type
+ *   definition, counting in order of appearance; this allows for recursive types
+ *
+ * Values are encoded as follows:
+ *
+ * - `Bool`: one byte
+ * - `SignedInt`, `Enum`: zigzag varint
+ * - `UnsignedInt`: varint
+ * - `Real`: IEEE 754 double as 8 bytes in little endian byte order
+ * - `Bytes`, `String`, `Text`: length-prefixed data
+ * - `Address`: IP version (4 or 6) as one byte, then 4 or 16 bytes in network byte order
+ * - `Network`: prefix as an address, then the prefix length as one byte
+ * - `Port`: port number as varint, then the protocol as one byte (1=TCP, 2=UDP, 3=ICMP)
+ * - `Time`: nanoseconds since the epoch as varint
+ * - `Interval`: nanoseconds as zigzag varint
+ * - `Struct`: bitmap of set fields, with one bit per field and rounded up to
+ *   full bytes, followed by the values of all set fields
+ * - `Tuple`, `Bitfield`: values of all elements
+ * - `Vector`, `Set`: number of elements, then the elements
+ * - `Map`: number of elements, then each key followed by its value
+ * - `Optional`: one byte indicating if a value is present, then the value if so
+ * - `Union`: 1-based index of the set field as varint, or zero if none, then
+ *   that field's value
+ */
+enum class Kind : uint8_t {
+    Bool = 1,
+    SignedInt = 2,
+    UnsignedInt = 3,
+    Real = 4,
+    Bytes = 5,
+    String = 6,
+    Address = 7,
+    Network = 8,
+    Port = 9,
+    Time = 10,
+    Interval = 11,
+    Enum = 12,
+    Struct = 13,
+    Tuple = 14,
+    Vector = 15,
+    Set = 16,
+    Map = 17,
+    Optional = 18,
+    Union = 19,
+    Bitfield = 20,
+    Text = 21,
+    StructRef = 22,
+};
+
+/** Flags describing fields of `Struct` types. */
+enum FieldFlags : uint8_t {
+    Anonymous = 1, /**< field is anonymous */
+};
+
+/**
+ * Serializes parsed values into the binary format. Each writer keeps
+ * track of which types it has emitted a schema for already.
+ */
+class Writer {
+public:
+    /**
+     * Constructor. Writes out the stream header.
+     *
+     * @param out stream to send serialized data to
+     */
+    explicit Writer(std::ostream& out);
+
+    /**
+     * Serializes one value, preceded by its type's schema if that hasn't
+     * been written out yet.
+     *
+     * @param v value to serialize
+     */
+    void write(const hilti::rt::type_info::Value& v);
+
+private:
+    void _writeMessage(char kind, uint64_t id);
+    void _writeType(const hilti::rt::TypeInfo* type, std::vector<const hilti::rt::TypeInfo*>* structs);
+    void _writeValue(const hilti::rt::type_info::Value& v);
+
+    std::ostream& _out;
+    std::string _buffer;                                            // encoding of the current message
+    std::unordered_map<const hilti::rt::TypeInfo*, uint64_t> _types; // type IDs of schemas written so far
+};
+
+struct Type;
+
+/** Field, element, bits, or label of a type decoded from a schema. */
+struct Field {
+    std::string name;           /**< ID of the field, or empty if not named */
+    const Type* type = nullptr; /**< type of the field; null for enum labels */
+    uint8_t flags = 0;          /**< for struct fields, a combination of `FieldFlags` */
+    int64_t value = 0;          /**< for enum labels, the label's value */
+};
+
+/** Type decoded from a schema. */
+struct Type {
+    Kind kind;                      /**< kind of type */
+    std::string name;               /**< for structs and enums, their name */
+    unsigned int width = 0;         /**< for integers, their width in bits */
+    std::vector<Field> fields;      /**< struct fields, tuple elements, union fields, bits, or enum labels */
+    const Type* element = nullptr;  /**< for vectors, sets, optionals, and maps, the element (or key) type */
+    const Type* value = nullptr;    /**< for maps, the value type */
+};
+
+/**
+ * Value decoded from serialized data. Its data depends on the type's kind:
+ *
+ * - `Bool`: `bool`
+ * - `SignedInt`, `Interval`, `Enum`: `int64_t` (nanoseconds for intervals)
+ * - `UnsignedInt`, `Time`: `uint64_t` (nanoseconds since the epoch for times)
+ * - `Real`: `double`
+ * - `Bytes`, `String`, `Text`: `std::string`
+ * - `Address`, `Network`, `Port`: `std::string` with their usual rendering (e.g., `10.0.0.0/8`, `80/tcp`)
+ * - `Struct`, `Union`: `std::vector<Value>` with one entry per field, with unset fields holding `std::monostate`
+ * - `Tuple`, `Vector`, `Set`, `Bitfield`: `std::vector<Value>` with one entry per element
+ * - `Map`: `std::vector<Value>` with alternating keys and values
+ * - `Optional`: `std::vector<Value>` that's either empty or holds the contained value
+ */
+struct Value {
+    using Data = std::variant<std::monostate, bool, int64_t, uint64_t, double, std::string, std::vector<Value>>;
+
+    const Type* type = nullptr; /**< type of the value, owned by the reader */
+    Data data;                  /**< the value's data */
+
+    /** Returns true if the value is set. */
+    explicit operator bool() const { return ! std::holds_alternative<std::monostate>(data); }
+};
+
+/**
+ * Decodes values from serialized data. Types that values refer to remain
+ * valid for as long as the reader exists.
+ */
+class Reader {
+public:
+    /**
+     * Constructor. Reads and verifies the stream header.
+     *
+     * @param in stream to read serialized data from
+     * @throws SerializationError if the header is invalid or of an unsupported version
+     */
+    explicit Reader(std::istream& in);
+
+    /**
+     * Reads the next value.
+     *
+     * @return the value, or nothing if the end of the input has been reached
+     * @throws SerializationError if the data isn't well-formed
+     */
+    std::optional<Value> read();
+
+private:
+    struct Schema {
+        std::vector<std::unique_ptr<Type>> types; // all types of the schema; the first one is the root
+    };
+
+    std::istream& _in;
+    std::map<uint64_t, Schema> _schemas; // schemas read so far, indexed by type ID
+};
+
+} // namespace serialization
+} // namespace spicy::rt
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -29,7 +30,18 @@ namespace spicy::rt {
 HILTI_EXCEPTION(SinkError, UsageError)
 
 namespace sink {
-enum class ReassemblerPolicy { First };
+/**
+ * Policies for the sink's reassembler.
+ *
+ * - `First`: On overlap, keeps the original data and discards the new data.
+ *   Buffered data is kept in a list that's searched linearly, which is
+ *   cheapest for input that's mostly in order.
+ *
+ * - `FirstIndexed`: Same semantics as `First`, but additionally maintains an
+ *   index over the buffered data so that out-of-order input can be placed in
+ *   logarithmic instead of linear time.
+ */
+enum class ReassemblerPolicy { First, FirstIndexed };
 } // namespace sink
 
 namespace sink::detail {
@@ -240,8 +252,8 @@ public:
         _initial_seq = seq;
     }
 
-    /** Sets the sink's reassembler policy. */
-    void set_policy(sink::ReassemblerPolicy policy) { _policy = policy; }
+    /** Sets the sink's reassembler policy. This can be changed at any time, including while data is buffered. */
+    void set_policy(sink::ReassemblerPolicy policy);
 
     /**
      * Returns the number of bytes written into the sink so far.
@@ -291,6 +303,7 @@ private:
     };
 
     using ChunkList = std::list<Chunk>;
+    using ChunkIndex = std::map<uint64_t, ChunkList::iterator>; // maps chunk's `rupper` to its list position
 
     // Returns true if any input has been passed in already (including gaps).
     bool _haveInput() { return _cur_rseq || _chunks.size(); }
@@ -318,6 +331,15 @@ private:
     ChunkList::iterator _addAndCheck(std::optional<hilti::rt::Bytes> data, uint64_t rseq, uint64_t rupper,
                                      ChunkList::iterator c);
 
+    // Find first buffered chunk that doesn't come completely before *rseq*, beginning search at given start *c*.
+    ChunkList::iterator _findChunk(uint64_t rseq, ChunkList::iterator c);
+
+    // Insert chunk into buffer before given position, updating the index if maintained.
+    ChunkList::iterator _insertChunk(ChunkList::iterator pos, Chunk chunk);
+
+    // Remove chunk from buffer, updating the index if maintained. Returns the position following it.
+    ChunkList::iterator _eraseChunk(ChunkList::iterator c);
+
     // Deliver data to connected parsers. Returns false if the data is empty (i.e., a gap).
     bool _deliver(std::optional<hilti::rt::Bytes> data, uint64_t rseq, uint64_t rupper);
 
@@ -370,6 +392,7 @@ private:
     uint64_t _last_reassem_rseq{}; // Sequence of last byte reassembled and delivered + 1.
     uint64_t _trim_rseq{};         // Sequence of last byte trimmed so far + 1.
     ChunkList _chunks;             // Buffered data not yet delivered or trimmed
+    ChunkIndex _index;             // Index into `_chunks`; maintained only with `FirstIndexed` policy
 };
 
 } // namespace spicy::rt
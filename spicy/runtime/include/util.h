@@ -45,6 +45,10 @@ inline void confirm(U& p) {
         // `afterHook`, but this is not possible since we have no direct access
         // to the parser state here.
         p.__on_0x25_confirmed();
+
+        // With status-based backtracking, the hook may have requested to
+        // backtrack. We cannot unwind from here without an exception.
+        detail::raisePendingBacktrack();
     }
 }
 
@@ -59,6 +63,7 @@ inline void reject(U& p) {
         // to the parser state here.
         p.__on_0x25_rejected();
 
+        detail::raisePendingBacktrack();
         throw *error;
     }
     else
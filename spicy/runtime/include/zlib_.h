@@ -65,6 +65,9 @@ public:
     hilti::rt::Bytes finish();
 
 private:
+    // Decompresses data, appending the result to `out`.
+    void _decompress(const hilti::rt::stream::Byte* data, size_t len, std::string* out);
+
     std::shared_ptr<detail::State> _state;
 };
 
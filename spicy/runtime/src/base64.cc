@@ -1,5 +1,8 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
+#include <string>
+#include <utility>
+
 #include <hilti/rt/types/bytes.h>
 
 #include <spicy/rt/base64.h>
@@ -31,56 +34,69 @@ Stream::Stream() {
 // It'll eventually be cleaned up.
 Stream::~Stream() = default;
 
+// Upper bound on the output size for encoding `n` bytes: every 3 input bytes
+// become 4 output characters, plus line breaks every 72 characters.
+static size_t encodedSize(size_t n) { return n * 2 + 4; }
+
+// Upper bound on the output size for decoding `n` characters.
+static size_t decodedSize(size_t n) { return n / 4 * 3 + 3; }
+
+void Stream::_encode(const char* data, size_t len, std::string* out) {
+    // Encode directly into the output.
+    auto used = out->size();
+    out->resize(used + encodedSize(len));
+    auto n = base64_encode_block(data, static_cast<int>(len), out->data() + used, &_state->estate);
+    out->resize(used + n);
+}
+
+void Stream::_decode(const char* data, size_t len, std::string* out) {
+    // Decode directly into the output.
+    auto used = out->size();
+    out->resize(used + decodedSize(len));
+    auto n = base64_decode_block(data, static_cast<int>(len), out->data() + used, &_state->dstate);
+    out->resize(used + n);
+}
+
 hilti::rt::Bytes Stream::encode(const hilti::rt::Bytes& data) {
     if ( ! _state )
         throw Base64Error("encoding already finished");
 
-    char buf[static_cast<uint64_t>(data.size() * 2)];
-    auto len = base64_encode_block(data.data(), static_cast<int>(data.size()), buf, &_state->estate);
-    return hilti::rt::Bytes(buf, len);
+    std::string encoded;
+    _encode(data.data(), data.size(), &encoded);
+    return hilti::rt::Bytes(std::move(encoded));
 }
 
 hilti::rt::Bytes Stream::encode(const hilti::rt::stream::View& data) {
     if ( ! _state )
         throw Base64Error("encoding already finished");
 
-    hilti::rt::Bytes encoded;
+    std::string encoded;
 
-    for ( auto block = data.firstBlock(); block; block = data.nextBlock(block) ) {
-        char buf[static_cast<uint64_t>(block->size * 2)];
-        auto len = base64_encode_block(reinterpret_cast<const char*>(block->start), static_cast<int>(block->size), buf,
-                                       &_state->estate);
-        encoded.append(hilti::rt::Bytes(buf, len));
-    }
+    for ( auto block = data.firstBlock(); block; block = data.nextBlock(block) )
+        _encode(reinterpret_cast<const char*>(block->start), block->size, &encoded);
 
-    return encoded;
+    return hilti::rt::Bytes(std::move(encoded));
 }
 
 hilti::rt::Bytes Stream::decode(const hilti::rt::Bytes& data) {
     if ( ! _state )
         throw Base64Error("decoding already finished");
 
-    char buf[static_cast<uint64_t>(data.size() * 2)];
-    auto len = base64_decode_block(reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size()), buf,
-                                   &_state->dstate);
-
-    return hilti::rt::Bytes(buf, len);
+    std::string decoded;
+    _decode(data.data(), data.size(), &decoded);
+    return hilti::rt::Bytes(std::move(decoded));
 }
 
 hilti::rt::Bytes Stream::decode(const hilti::rt::stream::View& data) {
     if ( ! _state )
         throw Base64Error("decoding already finished");
 
-    hilti::rt::Bytes decoded;
+    std::string decoded;
 
-    for ( auto block = data.firstBlock(); block; block = data.nextBlock(block) ) {
-        char buf[static_cast<uint64_t>(block->size * 2)];
-        auto len = base64_decode_block(reinterpret_cast<const char*>(block->start), static_cast<int>(block->size), buf,
-                                       &_state->dstate);
-        decoded.append(hilti::rt::Bytes(buf, len));
-    }
+    for ( auto block = data.firstBlock(); block; block = data.nextBlock(block) )
+        _decode(reinterpret_cast<const char*>(block->start), block->size, &decoded);
 
-    return decoded;
+    return hilti::rt::Bytes(std::move(decoded));
 }
 
 hilti::rt::Bytes Stream::finish() {
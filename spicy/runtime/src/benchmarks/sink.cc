@@ -0,0 +1,95 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <hilti/rt/init.h>
+#include <hilti/rt/types/bytes.h>
+
+#include <spicy/rt/init.h>
+#include <spicy/rt/sink.h>
+
+using namespace spicy::rt;
+
+using Segments = std::vector<std::pair<uint64_t, hilti::rt::Bytes>>;
+
+static constexpr uint64_t SegmentSize = 64;
+
+// Writes all segments into a fresh sink using the given policy.
+static void reassemble(benchmark::State& state, sink::ReassemblerPolicy policy, const Segments& segments) {
+    hilti::rt::init();
+    spicy::rt::init();
+
+    for ( auto _ : state ) {
+        (void)_;
+
+        Sink sink;
+        sink.set_policy(policy);
+
+        for ( const auto& [seq, data] : segments )
+            sink.write(data, seq);
+
+        benchmark::DoNotOptimize(sink.sequence_number());
+        sink.close();
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(segments.size()));
+
+    spicy::rt::done();
+    hilti::rt::done();
+}
+
+// Consecutive segments arriving in order.
+static void in_order(benchmark::State& state, sink::ReassemblerPolicy policy) {
+    Segments segments;
+
+    for ( int64_t i = 0; i < state.range(0); i++ )
+        segments.emplace_back(i * SegmentSize, hilti::rt::Bytes(std::string(SegmentSize, 'x')));
+
+    reassemble(state, policy, segments);
+}
+
+// Consecutive segments arriving in reverse order, so that everything
+// remains buffered until the very last write.
+static void reversed(benchmark::State& state, sink::ReassemblerPolicy policy) {
+    Segments segments;
+
+    for ( int64_t i = state.range(0) - 1; i >= 0; i-- )
+        segments.emplace_back(i * SegmentSize, hilti::rt::Bytes(std::string(SegmentSize, 'x')));
+
+    reassemble(state, policy, segments);
+}
+
+// Segments of varying length at random positions, overlapping each other,
+// followed by a final segment filling the leading hole.
+static void random_overlap(benchmark::State& state, sink::ReassemblerPolicy policy) {
+    std::mt19937_64 rng(42); // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    auto range = static_cast<uint64_t>(state.range(0)) * SegmentSize;
+
+    Segments segments;
+
+    for ( int64_t i = 0; i < state.range(0); i++ ) {
+        auto seq = 1 + (rng() % range);
+        auto len = SegmentSize / 2 + (rng() % (SegmentSize * 2));
+        segments.emplace_back(seq, hilti::rt::Bytes(std::string(len, 'x')));
+    }
+
+    segments.emplace_back(0, hilti::rt::Bytes(std::string(1, 'x')));
+
+    reassemble(state, policy, segments);
+}
+
+BENCHMARK_CAPTURE(in_order, first, sink::ReassemblerPolicy::First)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK_CAPTURE(in_order, first_indexed, sink::ReassemblerPolicy::FirstIndexed)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK_CAPTURE(reversed, first, sink::ReassemblerPolicy::First)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK_CAPTURE(reversed, first_indexed, sink::ReassemblerPolicy::FirstIndexed)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK_CAPTURE(random_overlap, first, sink::ReassemblerPolicy::First)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK_CAPTURE(random_overlap, first_indexed, sink::ReassemblerPolicy::FirstIndexed)
+    ->RangeMultiplier(8)
+    ->Range(64, 32768);
+
+BENCHMARK_MAIN();
@@ -1,21 +1,41 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
+#include <fcntl.h>
 #include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <ios>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include <hilti/rt/configuration.h>
+#include <hilti/rt/context.h>
 #include <hilti/rt/exception.h>
 #include <hilti/rt/fmt.h>
+#include <hilti/rt/global-state.h>
 #include <hilti/rt/init.h>
 #include <hilti/rt/profiler.h>
 
+#include <spicy/rt/configuration.h>
 #include <spicy/rt/driver.h>
 
 using hilti::rt::Nothing;
@@ -67,9 +87,16 @@ void Driver::_debugStats(const hilti::rt::ValueReference<hilti::rt::Stream>& dat
     auto max_stacks = pretty_print_number(ru.max_fibers);
     auto max_stack_size = pretty_print_number(ru.max_fiber_stack_size);
     auto cached_stacks = pretty_print_number(ru.cached_fibers);
+    auto cache_hits = pretty_print_number(ru.fiber_cache_hits);
+    auto cache_misses = pretty_print_number(ru.fiber_cache_misses);
+    auto swap_size = pretty_print_number(ru.fiber_swap_size);
+    auto swap_pooled = pretty_print_number(ru.fiber_swap_pooled);
+    auto released = pretty_print_number(ru.fiber_released);
 
     DRIVER_DEBUG(fmt("memory: heap=%s fibers-cur=%s fibers-cached=%s fibers-max=%s fiber-stack-max=%s", memory_heap,
                      num_stacks, cached_stacks, max_stacks, max_stack_size));
+    DRIVER_DEBUG(fmt("fibers: cache-hits=%s cache-misses=%s swap-size=%s swap-pooled=%s released=%s", cache_hits,
+                     cache_misses, swap_size, swap_pooled, released));
 }
 
 void Driver::_debugStats(size_t current_flows, size_t current_connections) {
@@ -87,9 +114,16 @@ void Driver::_debugStats(size_t current_flows, size_t current_connections) {
     auto max_stacks = pretty_print_number(stats.max_fibers);
     auto max_stack_size = pretty_print_number(stats.max_fiber_stack_size);
     auto cached_stacks = pretty_print_number(stats.cached_fibers);
+    auto cache_hits = pretty_print_number(stats.fiber_cache_hits);
+    auto cache_misses = pretty_print_number(stats.fiber_cache_misses);
+    auto swap_size = pretty_print_number(stats.fiber_swap_size);
+    auto swap_pooled = pretty_print_number(stats.fiber_swap_pooled);
+    auto released = pretty_print_number(stats.fiber_released);
 
     DRIVER_DEBUG(fmt("memory  : heap=%s fibers-cur=%s fibers-cached=%s fibers-max=%s fiber-stack-max=%s", memory_heap,
                      num_stacks, cached_stacks, max_stacks, max_stack_size));
+    DRIVER_DEBUG(fmt("fibers  : cache-hits=%s cache-misses=%s swap-size=%s swap-pooled=%s released=%s", cache_hits,
+                     cache_misses, swap_size, swap_pooled, released));
 }
 
 Result<Nothing> Driver::listParsers(std::ostream& out) {
@@ -179,7 +213,7 @@ Result<spicy::rt::ParsedUnit> Driver::processInput(const spicy::rt::Parser& pars
             auto profiler = hilti::rt::profiler::start(parser.profiler_tags.prepare_input);
 
             if ( auto n = in.gcount() )
-                data->append(hilti::rt::Bytes(buffer, n));
+                data->append(buffer, static_cast<size_t>(n));
 
             if ( in.peek() == EOF )
                 data->freeze();
@@ -231,7 +265,30 @@ std::optional<hilti::rt::stream::Offset> driver::ParsingState::finish() {
         return {};
 }
 
-driver::ParsingState::State driver::ParsingState::_process(size_t size, const char* data, bool eod) {
+driver::ParsingState::State driver::ParsingState::processBlock(size_t size, const char* data) {
+    if ( _type != ParsingType::Block )
+        return process(size, data);
+
+    // Makes sure we no longer reference the caller's memory once we return.
+    auto release = [this]() {
+        if ( _block_input ) {
+            (*_block_input)->reset();
+            _block_input.reset();
+        }
+    };
+
+    try {
+        auto state = _process(size, data, false, {}, true);
+        release();
+        return state;
+    } catch ( ... ) {
+        release();
+        throw;
+    }
+}
+
+driver::ParsingState::State driver::ParsingState::_process(size_t size, const char* data, bool eod,
+                                                           std::shared_ptr<const void> owner, bool direct) {
     assert(size == 0 || ! eod);
 
     if ( ! _parser ) {
@@ -256,7 +313,18 @@ driver::ParsingState::State driver::ParsingState::_process(size_t size, const ch
                 assert(_parser->profiler_tags);
                 auto profiler = hilti::rt::profiler::start(_parser->profiler_tags.prepare_block);
 
-                auto input = hilti::rt::reference::make_value<hilti::rt::Stream>(data, size);
+                auto input = hilti::rt::reference::make_value<hilti::rt::Stream>();
+
+                if ( direct ) {
+                    // Borrow the caller's memory without taking ownership;
+                    // `processBlock()` resets the stream before returning.
+                    // Each block gets its own stream, so nothing parsed
+                    // from an earlier block can see later ones.
+                    owner = std::shared_ptr<const void>(std::shared_ptr<const void>(), data);
+                    _block_input = input;
+                }
+
+                input->append(data, size, std::move(owner));
                 input->freeze();
 
                 if ( ! _parser->parse1 )
@@ -273,7 +341,15 @@ driver::ParsingState::State driver::ParsingState::_process(size_t size, const ch
 
                 hilti::rt::profiler::stop(profiler);
 
-                _resumable = _parser->parse1(input, {}, _context);
+                // Each block gets parsed into a new unit, with a new arena.
+                hilti::rt::arena::Scope arena_scope(_newArena());
+
+                if ( direct ) {
+                    hilti::rt::resumable::RunDirectly run_directly;
+                    _resumable = _parser->parse1(input, {}, _context);
+                }
+                else
+                    _resumable = _parser->parse1(input, {}, _context);
 
                 if ( ! *_resumable )
                     hilti::rt::internalError("block-based parsing yielded");
@@ -305,7 +381,8 @@ driver::ParsingState::State driver::ParsingState::_process(size_t size, const ch
                             DRIVER_DEBUG("no context provided");
                     }
 
-                    _input = hilti::rt::reference::make_value<hilti::rt::Stream>(data, size);
+                    _input = hilti::rt::reference::make_value<hilti::rt::Stream>();
+                    (*_input)->append(data, size, std::move(owner));
                     if ( eod )
                         (*_input)->freeze();
 
@@ -315,6 +392,9 @@ driver::ParsingState::State driver::ParsingState::_process(size_t size, const ch
                                 _parser->name));
 
                     hilti::rt::profiler::stop(profiler);
+
+                    _arena = _newArena();
+                    hilti::rt::arena::Scope arena_scope(_arena);
                     _resumable = _parser->parse1(*_input, {}, _context);
                 }
 
@@ -323,7 +403,7 @@ driver::ParsingState::State driver::ParsingState::_process(size_t size, const ch
                     assert(_input && _resumable);
 
                     if ( size )
-                        (*_input)->append(data, size);
+                        (*_input)->append(data, size, std::move(owner));
 
                     if ( eod ) {
                         DRIVER_DEBUG("end of data");
@@ -333,12 +413,16 @@ driver::ParsingState::State driver::ParsingState::_process(size_t size, const ch
                         DRIVER_DEBUG("next data chunk", size, data);
 
                     hilti::rt::profiler::stop(profiler);
+
+                    hilti::rt::arena::Scope arena_scope(_arena);
                     _resumable->resume();
                 }
 
                 if ( *_resumable ) {
-                    // Done parsing.
+                    // Done parsing. Anything still referring to the unit's
+                    // arena keeps it alive, but we don't need it anymore.
                     _done = true;
+                    _arena.reset();
                     DRIVER_DEBUG("parsing finished");
                     return Done;
                 }
@@ -353,21 +437,302 @@ driver::ParsingState::State driver::ParsingState::_process(size_t size, const ch
     } catch ( const hilti::rt::Exception& e ) {
         DRIVER_DEBUG(e.what());
         _done = true;
+        _arena.reset();
         throw;
     }
 
     hilti::rt::cannot_be_reached();
 }
 
-Result<hilti::rt::Nothing> Driver::processPreBatchedInput(std::istream& in) {
-    std::string magic;
-    std::getline(in, magic);
+std::shared_ptr<hilti::rt::Arena> driver::ParsingState::_newArena() {
+    if ( auto size = spicy::rt::configuration::get().parse_arena_size )
+        return std::make_shared<hilti::rt::Arena>(size);
 
-    if ( magic != std::string("!spicy-batch v2") )
-        return hilti::rt::result::Error("input is not a v2 Spicy batch file");
+    return nullptr;
+}
+
+namespace spicy::rt::driver::detail {
+
+/** A single, already validated command read from a batch file. */
+struct BatchCommand {
+    enum Kind { BeginFlow, BeginConn, Data, Gap, EndFlow, EndConn };
+
+    Kind kind = BeginFlow;                  /**< type of command */
+    std::vector<std::string> args;          /**< command's arguments, excluding the command itself */
+    ParsingType type = ParsingType::Stream; /**< session type for `BeginFlow` and `BeginConn` */
+    uint64_t size = 0;                      /**< size for `Data` and `Gap` */
+    const char* data = nullptr;             /**< payload for `Data` */
+    std::shared_ptr<const void> owner;      /**< keeps `data` alive */
+};
+
+/** Source of batch input. */
+class BatchReader {
+public:
+    /** A block of data read from the input, along with a reference keeping it alive. */
+    struct Block {
+        const char* data;
+        std::shared_ptr<const void> owner;
+    };
+
+    virtual ~BatchReader() = default;
+
+    /** Reads the next line, excluding its trailing newline. Returns false once all input has been consumed. */
+    virtual bool getline(std::string* line) = 0;
+
+    /**
+     * Reads *size* bytes of data followed by a newline. Fails if input ends
+     * prematurely or the data isn't followed by a newline.
+     */
+    virtual Result<Block> read(size_t size) = 0;
+};
+
+/** Reads batch input from a stream, copying each block of data once. */
+class StreamBatchReader : public BatchReader {
+public:
+    explicit StreamBatchReader(std::istream& in) : _in(in) {}
+
+    bool getline(std::string* line) override {
+        if ( ! _in.good() || _in.eof() )
+            return false;
+
+        std::getline(_in, *line);
+        return true;
+    }
+
+    Result<Block> read(size_t size) override {
+        auto data = std::make_shared<std::string>(size, '\0');
+        _in.read(data->data(), static_cast<std::streamsize>(size));
+        auto nl = _in.get();
+
+        if ( _in.eof() || _in.fail() )
+            return Error("premature end of @data");
+
+        if ( nl != '\n' )
+            return Error("@data not followed by newline");
 
-    std::unordered_map<std::string, driver::ParsingStateForDriver> flows;
-    std::unordered_map<std::string, driver::ConnectionState> connections;
+        return Block{data->data(), std::move(data)};
+    }
+
+private:
+    std::istream& _in;
+};
+
+/** A file mapped into memory in its entirety. */
+struct MappedFile {
+    MappedFile(const char* data, size_t size) : data(data), size(size) {}
+    ~MappedFile() { ::munmap(const_cast<char*>(data), size); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    /**
+     * Maps a file into memory. Returns null if that's not possible, for
+     * example because it's not a regular file.
+     */
+    static std::shared_ptr<const MappedFile> open(const hilti::rt::filesystem::path& path) {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if ( fd < 0 )
+            return nullptr;
+
+        struct stat st {};
+        if ( ::fstat(fd, &st) < 0 || ! S_ISREG(st.st_mode) || st.st_size == 0 ) {
+            ::close(fd);
+            return nullptr;
+        }
+
+        auto size = static_cast<size_t>(st.st_size);
+        auto* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // mapping remains valid
+
+        if ( data == MAP_FAILED )
+            return nullptr;
+
+        ::madvise(data, size, MADV_SEQUENTIAL);
+        return std::make_shared<MappedFile>(static_cast<const char*>(data), size);
+    }
+
+    const char* data;
+    size_t size;
+};
+
+/**
+ * Reads batch input from a memory-mapped file. Blocks of data are passed on
+ * as references into the mapping, which they keep alive.
+ */
+class MappedBatchReader : public BatchReader {
+public:
+    explicit MappedBatchReader(std::shared_ptr<const MappedFile> file) : _file(std::move(file)) {}
+
+    bool getline(std::string* line) override {
+        if ( _pos >= _file->size )
+            return false;
+
+        const auto* begin = _file->data + _pos;
+        const auto* end = static_cast<const char*>(memchr(begin, '\n', _file->size - _pos));
+        if ( ! end )
+            end = _file->data + _file->size;
+
+        line->assign(begin, end);
+        _pos = static_cast<size_t>(end - _file->data) + 1;
+        return true;
+    }
+
+    Result<Block> read(size_t size) override {
+        // We need the data plus its trailing newline.
+        if ( _pos >= _file->size || size >= _file->size - _pos )
+            return Error("premature end of @data");
+
+        if ( _file->data[_pos + size] != '\n' )
+            return Error("@data not followed by newline");
+
+        const auto* data = _file->data + _pos;
+        _pos += size + 1;
+        return Block{data, _file};
+    }
+
+private:
+    std::shared_ptr<const MappedFile> _file;
+    size_t _pos = 0;
+};
+
+/** State of all active flows and connections during batch processing; one instance per thread. */
+struct BatchState {
+    std::unordered_map<std::string, ParsingStateForDriver> flows;
+    std::unordered_map<std::string, ConnectionState> connections;
+};
+
+/**
+ * Thread executing batch commands inside its own runtime context. Commands
+ * are queued by the thread reading the batch, which blocks if the worker
+ * falls too far behind.
+ */
+class BatchWorker {
+public:
+    BatchWorker(Driver* driver, hilti::rt::vthread::ID vid) : _driver(driver) {
+        _thread = std::thread([this, vid]() { _run(vid); });
+    }
+
+    ~BatchWorker() { _stop(); }
+
+    BatchWorker(const BatchWorker&) = delete;
+    BatchWorker(BatchWorker&&) = delete;
+    BatchWorker& operator=(const BatchWorker&) = delete;
+    BatchWorker& operator=(BatchWorker&&) = delete;
+
+    /**
+     * Queues a command for execution. Fails if the worker has aborted
+     * processing because of an unexpected exception, in which case it won't
+     * accept any further commands.
+     */
+    Result<Nothing> schedule(BatchCommand cmd) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this]() { return _queue.size() < MaxQueueSize || _error; });
+
+        if ( _error )
+            return _errorResult();
+
+        _queue.push_back(std::move(cmd));
+        _cv.notify_all();
+        return Nothing();
+    }
+
+    /**
+     * Waits for all queued commands to be executed and then terminates the
+     * thread. Fails if an unexpected exception aborted processing.
+     */
+    Result<Nothing> finish() {
+        _stop();
+
+        if ( _error )
+            return _errorResult();
+
+        return Nothing();
+    }
+
+private:
+    static constexpr size_t MaxQueueSize = 1024;
+
+    // Turns the exception that aborted processing into an error.
+    Error _errorResult() const {
+        try {
+            std::rethrow_exception(_error);
+        } catch ( const std::exception& e ) {
+            return Error(fmt("batch worker aborted: %s", e.what()));
+        } catch ( ... ) {
+            return Error("batch worker aborted: unknown exception");
+        }
+    }
+
+    void _stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+
+        _cv.notify_all();
+
+        if ( _thread.joinable() )
+            _thread.join();
+    }
+
+    void _run(hilti::rt::vthread::ID vid) {
+        try {
+            hilti::rt::Context ctx(vid);
+            hilti::rt::context::detail::set(&ctx);
+
+            {
+                // Scoped so that all parsing state is released while the
+                // worker's context is still active.
+                BatchState state;
+
+                while ( true ) {
+                    BatchCommand cmd;
+
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _cv.wait(lock, [this]() { return ! _queue.empty() || _done; });
+
+                        if ( _queue.empty() )
+                            break;
+
+                        cmd = std::move(_queue.front());
+                        _queue.pop_front();
+                    }
+
+                    _cv.notify_all();
+                    _driver->_processBatchCommand(&state, std::move(cmd));
+                }
+            }
+
+            hilti::rt::context::detail::set(nullptr);
+        } catch ( ... ) {
+            hilti::rt::context::detail::set(nullptr);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::current_exception();
+            _queue.clear();
+            _cv.notify_all();
+        }
+    }
+
+    Driver* _driver;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<BatchCommand> _queue;
+    bool _done = false;
+    std::exception_ptr _error;
+    std::thread _thread; // started last, once everything else has been initialized
+};
+
+} // namespace spicy::rt::driver::detail
+
+using driver::detail::BatchCommand;
+
+void Driver::_processBatchCommand(driver::detail::BatchState* state, BatchCommand cmd) {
+    auto& flows = state->flows;
+    auto& connections = state->connections;
 
     // Helper to add flows to the map.
     auto create_state = [&](driver::ParsingType type, const std::string& parser_name, const std::string& id,
@@ -389,59 +754,27 @@ Result<hilti::rt::Nothing> Driver::processPreBatchedInput(std::istream& in) {
         }
     };
 
-    while ( in.good() && ! in.eof() ) {
-        std::string cmd;
-        std::getline(in, cmd);
-        cmd = hilti::rt::trim(cmd);
-
-        if ( cmd.empty() )
-            continue;
-
-        auto m = hilti::rt::split(cmd);
-        if ( m[0] == "@begin-flow" ) {
-            // @begin-flow <id> <parser> <type>
-            if ( m.size() != 4 )
-                return hilti::rt::result::Error("unexpected number of argument for @begin-flow");
-
-            auto id = std::string(m[1]);
-            auto parser_name = std::string(m[3]);
-
-            driver::ParsingType type;
-
-            if ( m[2] == "stream" )
-                type = driver::ParsingType::Stream;
-            else if ( m[2] == "block" )
-                type = driver::ParsingType::Block;
-            else
-                return hilti::rt::result::Error(hilti::rt::fmt("unknown session type '%s'", m[2]));
-
-
-            create_state(type, parser_name, id, {}, {});
+    switch ( cmd.kind ) {
+        case BatchCommand::BeginFlow: {
+            // @begin-flow <id> <type> <parser>
+            const auto& id = cmd.args[0];
+            const auto& parser_name = cmd.args[2];
+            create_state(cmd.type, parser_name, id, {}, {});
+            break;
         }
-        else if ( m[0] == "@begin-conn" ) {
-            // @begin-conn <conn-id> <type> <orig-id> <orig-parser> <resp-id> <resp-parser>
-            if ( m.size() != 7 )
-                return hilti::rt::result::Error("unexpected number of argument for @begin-conn");
-
-            auto cid = std::string(m[1]);
-            auto orig_id = std::string(m[3]);
-            auto orig_parser_name = std::string(m[4]);
-            auto resp_id = std::string(m[5]);
-            auto resp_parser_name = std::string(m[6]);
-
-            driver::ParsingType type;
 
-            if ( m[2] == "stream" )
-                type = driver::ParsingType::Stream;
-            else if ( m[2] == "block" )
-                type = driver::ParsingType::Block;
-            else
-                return hilti::rt::result::Error(hilti::rt::fmt("unknown session type '%s'", m[2]));
+        case BatchCommand::BeginConn: {
+            // @begin-conn <conn-id> <type> <orig-id> <orig-parser> <resp-id> <resp-parser>
+            const auto& cid = cmd.args[0];
+            const auto& orig_id = cmd.args[2];
+            const auto& orig_parser_name = cmd.args[3];
+            const auto& resp_id = cmd.args[4];
+            const auto& resp_parser_name = cmd.args[5];
 
             if ( connections.find(cid) != connections.end() ) {
                 // already exists, ignore
                 DRIVER_DEBUG(hilti::rt::fmt("connection %s exists, skipping", cid));
-                continue;
+                break;
             }
 
             driver::ParsingStateForDriver* orig_state = nullptr;
@@ -449,19 +782,19 @@ Result<hilti::rt::Nothing> Driver::processPreBatchedInput(std::istream& in) {
 
             std::optional<UnitContext> context;
 
-            if ( auto [x, ctx] = create_state(type, orig_parser_name, orig_id, cid, context); x != flows.end() ) {
+            if ( auto [x, ctx] = create_state(cmd.type, orig_parser_name, orig_id, cid, context); x != flows.end() ) {
                 orig_state = &x->second;
                 context = std::move(ctx);
             }
 
-            if ( auto [x, ctx] = create_state(type, resp_parser_name, resp_id, cid, context); x != flows.end() )
+            if ( auto [x, ctx] = create_state(cmd.type, resp_parser_name, resp_id, cid, context); x != flows.end() )
                 resp_state = &x->second;
 
             if ( ! (orig_state && resp_state) ) {
                 // cannot get parsers, ignore
                 flows.erase(orig_id);
                 flows.erase(resp_id);
-                continue;
+                break;
             }
 
             connections[cid] = driver::ConnectionState{.orig_id = orig_id,
@@ -469,55 +802,30 @@ Result<hilti::rt::Nothing> Driver::processPreBatchedInput(std::istream& in) {
                                                        .orig_state = orig_state,
                                                        .resp_state = resp_state};
             _total_connections++;
+            break;
         }
-        else if ( m[0] == "@data" ) {
-            // @data <id> <size>
-            // [data]\n
-            if ( m.size() != 3 )
-                return hilti::rt::result::Error("unexpected number of argument for @data");
-
-            auto id = std::string(m[1]);
-            auto size = std::stoul(std::string(m[2]));
-
-            char data[size];
-            in.read(data, static_cast<std::streamsize>(size));
-            in.get(); // Eat newline.
 
-            if ( in.eof() || in.fail() )
-                return hilti::rt::result::Error("premature end of @data");
-
-            auto s = flows.find(id);
-            if ( s != flows.end() ) {
-                try {
-                    s->second.process(size, data);
-                } catch ( const hilti::rt::Exception& e ) {
-                    std::cout << hilti::rt::fmt("error for ID %s: %s\n", id, e.what());
-                }
-            }
-        }
-        else if ( m[0] == "@gap" ) {
+        case BatchCommand::Data:
+        case BatchCommand::Gap: {
+            // @data <id> <size>
             // @gap <id> <size>
-            if ( m.size() != 3 )
-                return hilti::rt::result::Error("unexpected number of argument for @gap");
-
-            auto id = std::string(m[1]);
-            auto size = std::stoul(std::string(m[2]));
+            const auto& id = cmd.args[0];
 
             auto s = flows.find(id);
             if ( s != flows.end() ) {
                 try {
-                    s->second.process(size, nullptr);
+                    s->second.process(cmd.size, cmd.data, std::move(cmd.owner));
                 } catch ( const hilti::rt::Exception& e ) {
                     std::cout << hilti::rt::fmt("error for ID %s: %s\n", id, e.what());
                 }
             }
+
+            break;
         }
-        else if ( m[0] == "@end-flow" ) {
-            // @end-flow <id>
-            if ( m.size() != 2 )
-                return hilti::rt::result::Error("unexpected number of argument for @end-flow");
 
-            auto id = std::string(m[1]);
+        case BatchCommand::EndFlow: {
+            // @end-flow <id>
+            const auto& id = cmd.args[0];
 
             auto s = flows.find(id);
             if ( s != flows.end() ) {
@@ -530,13 +838,13 @@ Result<hilti::rt::Nothing> Driver::processPreBatchedInput(std::istream& in) {
                 flows.erase(s);
                 DRIVER_DEBUG_STATS(flows.size(), connections.size());
             }
+
+            break;
         }
-        else if ( m[0] == "@end-conn" ) {
-            // @end-conn <cid>
-            if ( m.size() != 2 )
-                return hilti::rt::result::Error("unexpected number of argument for @end-conn");
 
-            auto cid = std::string(m[1]);
+        case BatchCommand::EndConn: {
+            // @end-conn <cid>
+            const auto& cid = cmd.args[0];
 
             if ( auto s = connections.find(cid); s != connections.end() ) {
                 try {
@@ -556,13 +864,245 @@ Result<hilti::rt::Nothing> Driver::processPreBatchedInput(std::istream& in) {
                 connections.erase(s);
                 DRIVER_DEBUG_STATS(flows.size(), connections.size());
             }
+
+            break;
+        }
+    }
+}
+
+Result<hilti::rt::Nothing> Driver::processPreBatchedInput(std::istream& in, unsigned int threads) {
+    driver::detail::StreamBatchReader reader(in);
+    return _processPreBatchedInput(&reader, threads);
+}
+
+Result<hilti::rt::Nothing> Driver::processPreBatchedInput(const hilti::rt::filesystem::path& path,
+                                                          unsigned int threads) {
+    if ( auto file = driver::detail::MappedFile::open(path) ) {
+        DRIVER_DEBUG(fmt("reading batch from memory-mapped file %s", path.native()));
+        driver::detail::MappedBatchReader reader(std::move(file));
+        return _processPreBatchedInput(&reader, threads);
+    }
+
+    std::ifstream in(path.native(), std::ios::in | std::ios::binary);
+    if ( ! in.is_open() )
+        return hilti::rt::result::Error(fmt("cannot open %s for reading", path.native()));
+
+    return processPreBatchedInput(in, threads);
+}
+
+Result<hilti::rt::Nothing> Driver::_processPreBatchedInput(driver::detail::BatchReader* reader, unsigned int threads) {
+    std::string magic;
+    reader->getline(&magic);
+
+    if ( magic != std::string("!spicy-batch v2") )
+        return hilti::rt::result::Error("input is not a v2 Spicy batch file");
+
+    if ( threads > 1 ) {
+        if ( hilti::rt::configuration::get().enable_profiling )
+            return hilti::rt::result::Error("profiling is not supported when processing a batch with multiple threads");
+
+        // Each worker needs its own copy of all globals, which we can only
+        // provide if they are managed by the runtime.
+        for ( const auto& m : hilti::rt::detail::globalState()->hilti_modules ) {
+            if ( m.init_globals && ! m.globals_idx )
+                return hilti::rt::result::Error(
+                    fmt("cannot process batch with multiple threads, module %s was not compiled with dynamic globals",
+                        m.name));
+        }
+    }
+
+    // State for processing on the current thread; unused with workers.
+    driver::detail::BatchState state;
+
+    // Worker threads, if any, along with which of them is handling which flow and connection.
+    std::vector<std::unique_ptr<driver::detail::BatchWorker>> workers;
+    std::unordered_map<std::string, size_t> flow_workers;
+    std::unordered_map<std::string, std::tuple<size_t, std::string, std::string>> conn_workers;
+
+    if ( threads > 1 ) {
+        for ( unsigned int i = 0; i < threads; i++ )
+            workers.emplace_back(std::make_unique<driver::detail::BatchWorker>(this, i));
+    }
+
+    // Helper to pass a command on to whoever is handling its flow or connection.
+    auto dispatch = [&](BatchCommand cmd) -> Result<Nothing> {
+        if ( workers.empty() ) {
+            _processBatchCommand(&state, std::move(cmd));
+            return Nothing();
+        }
+
+        auto shard = [&](const std::string& id) { return std::hash<std::string>()(id) % workers.size(); };
+
+        std::optional<size_t> worker;
+
+        switch ( cmd.kind ) {
+            case BatchCommand::BeginFlow: {
+                worker = shard(cmd.args[0]);
+                flow_workers[cmd.args[0]] = *worker;
+                break;
+            }
+
+            case BatchCommand::BeginConn: {
+                const auto& cid = cmd.args[0];
+
+                if ( auto c = conn_workers.find(cid); c != conn_workers.end() )
+                    worker = std::get<0>(c->second); // will be ignored there
+                else {
+                    worker = shard(cid);
+                    conn_workers[cid] = std::make_tuple(*worker, cmd.args[2], cmd.args[4]);
+                    flow_workers[cmd.args[2]] = *worker;
+                    flow_workers[cmd.args[4]] = *worker;
+                }
+
+                break;
+            }
+
+            case BatchCommand::Data:
+            case BatchCommand::Gap: {
+                if ( auto f = flow_workers.find(cmd.args[0]); f != flow_workers.end() )
+                    worker = f->second;
+
+                break;
+            }
+
+            case BatchCommand::EndFlow: {
+                if ( auto f = flow_workers.find(cmd.args[0]); f != flow_workers.end() ) {
+                    worker = f->second;
+                    flow_workers.erase(f);
+                }
+
+                break;
+            }
+
+            case BatchCommand::EndConn: {
+                if ( auto c = conn_workers.find(cmd.args[0]); c != conn_workers.end() ) {
+                    const auto& [w, orig_id, resp_id] = c->second;
+                    worker = w;
+                    flow_workers.erase(orig_id);
+                    flow_workers.erase(resp_id);
+                    conn_workers.erase(c);
+                }
+
+                break;
+            }
+        }
+
+        if ( ! worker )
+            return Nothing();
+
+        // Fail fast if the worker has died, instead of losing its flows' data.
+        auto id = cmd.args[0];
+        if ( auto rc = workers[*worker]->schedule(std::move(cmd)); ! rc )
+            return Error(fmt("error for ID %s: %s", id, rc.error()));
+
+        return Nothing();
+    };
+
+    auto parse_type = [](std::string_view type) -> Result<driver::ParsingType> {
+        if ( type == "stream" )
+            return driver::ParsingType::Stream;
+        else if ( type == "block" )
+            return driver::ParsingType::Block;
+        else
+            return hilti::rt::result::Error(hilti::rt::fmt("unknown session type '%s'", type));
+    };
+
+    auto args = [](const std::vector<std::string_view>& m) {
+        return std::vector<std::string>(std::next(m.begin()), m.end());
+    };
+
+    std::string cmd;
+    while ( reader->getline(&cmd) ) {
+        cmd = hilti::rt::trim(cmd);
+
+        if ( cmd.empty() )
+            continue;
+
+        auto m = hilti::rt::split(cmd);
+        if ( m[0] == "@begin-flow" ) {
+            // @begin-flow <id> <type> <parser>
+            if ( m.size() != 4 )
+                return hilti::rt::result::Error("unexpected number of argument for @begin-flow");
+
+            auto type = parse_type(m[2]);
+            if ( ! type )
+                return type.error();
+
+            auto rc = dispatch(BatchCommand{.kind = BatchCommand::BeginFlow, .args = args(m), .type = *type});
+            if ( ! rc )
+                return rc.error();
+        }
+        else if ( m[0] == "@begin-conn" ) {
+            // @begin-conn <conn-id> <type> <orig-id> <orig-parser> <resp-id> <resp-parser>
+            if ( m.size() != 7 )
+                return hilti::rt::result::Error("unexpected number of argument for @begin-conn");
+
+            auto type = parse_type(m[2]);
+            if ( ! type )
+                return type.error();
+
+            auto rc = dispatch(BatchCommand{.kind = BatchCommand::BeginConn, .args = args(m), .type = *type});
+            if ( ! rc )
+                return rc.error();
+        }
+        else if ( m[0] == "@data" ) {
+            // @data <id> <size>
+            // [data]\n
+            if ( m.size() != 3 )
+                return hilti::rt::result::Error("unexpected number of argument for @data");
+
+            auto size = std::stoul(std::string(m[2]));
+
+            auto block = reader->read(size);
+            if ( ! block )
+                return block.error();
+
+            auto rc = dispatch(BatchCommand{.kind = BatchCommand::Data,
+                                            .args = args(m),
+                                            .size = size,
+                                            .data = block->data,
+                                            .owner = std::move(block->owner)});
+            if ( ! rc )
+                return rc.error();
+        }
+        else if ( m[0] == "@gap" ) {
+            // @gap <id> <size>
+            if ( m.size() != 3 )
+                return hilti::rt::result::Error("unexpected number of argument for @gap");
+
+            auto size = std::stoul(std::string(m[2]));
+            auto rc = dispatch(BatchCommand{.kind = BatchCommand::Gap, .args = args(m), .size = size});
+            if ( ! rc )
+                return rc.error();
+        }
+        else if ( m[0] == "@end-flow" ) {
+            // @end-flow <id>
+            if ( m.size() != 2 )
+                return hilti::rt::result::Error("unexpected number of argument for @end-flow");
+
+            auto rc = dispatch(BatchCommand{.kind = BatchCommand::EndFlow, .args = args(m)});
+            if ( ! rc )
+                return rc.error();
+        }
+        else if ( m[0] == "@end-conn" ) {
+            // @end-conn <cid>
+            if ( m.size() != 2 )
+                return hilti::rt::result::Error("unexpected number of argument for @end-conn");
+
+            auto rc = dispatch(BatchCommand{.kind = BatchCommand::EndConn, .args = args(m)});
+            if ( ! rc )
+                return rc.error();
         }
         else
             return hilti::rt::result::Error(hilti::rt::fmt("unknown command '%s'", m[0]));
     }
 
+    for ( auto& w : workers ) {
+        if ( auto rc = w->finish(); ! rc )
+            return rc.error();
+    }
 
-    DRIVER_DEBUG_STATS(flows.size(), connections.size());
+    DRIVER_DEBUG_STATS(state.flows.size(), state.connections.size());
 
     return hilti::rt::Nothing();
 }
@@ -1,9 +1,16 @@
 // Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <deque>
 #include <limits>
+#include <optional>
 #include <utility>
+#include <vector>
 
 #include <hilti/rt/exception.h>
+#include <hilti/rt/fiber.h>
 #include <hilti/rt/types/bytes.h>
 #include <hilti/rt/types/stream.h>
 
@@ -19,12 +26,14 @@ HILTI_EXCEPTION_IMPL(Backtrack)
 HILTI_EXCEPTION_IMPL(MissingData);
 HILTI_EXCEPTION_IMPL(ParseError)
 
+HILTI_THREAD_LOCAL bool detail::backtrack_pending = false;
+
 void spicy::rt::Parser::_initProfiling() {
-    // Cache profiler tags to avoid recomputing them frequently.
+    // Intern profiler tags upfront to avoid looking them up frequently.
     assert(! name.empty());
-    profiler_tags.prepare_block = "spicy/prepare/block/" + name;
-    profiler_tags.prepare_input = "spicy/prepare/input/" + name;
-    profiler_tags.prepare_stream = "spicy/prepare/stream/" + name;
+    profiler_tags.prepare_block = hilti::rt::profiler::intern("spicy/prepare/block/" + name);
+    profiler_tags.prepare_input = hilti::rt::profiler::intern("spicy/prepare/input/" + name);
+    profiler_tags.prepare_stream = hilti::rt::profiler::intern("spicy/prepare/stream/" + name);
 }
 
 void spicy::rt::accept_input() {
@@ -137,13 +146,28 @@ bool detail::waitForInputOrEod(hilti::rt::ValueReference<hilti::rt::Stream>& dat
         if ( _haveEod(data, cur) )
             return false;
 
-        SPICY_RT_DEBUG_VERBOSE(hilti::rt::fmt("suspending to wait for more input for stream %p, currently have %lu",
-                                              data.get(), cur.size()));
-        hilti::rt::detail::yield();
-
-        if ( filters ) {
-            SPICY_RT_DEBUG_VERBOSE("resuming filter execution");
+        if ( filters && ! hilti::rt::detail::canYield() ) {
+            // We are executing without a fiber, as parsers may do for frozen
+            // input. The only input that can still arrive then is output
+            // pending from our filters, so let them run directly instead of
+            // suspending for it.
+            SPICY_RT_DEBUG_VERBOSE("cannot suspend, resuming filter execution directly");
             spicy::rt::filter::flush(filters);
+
+            if ( cur.size() == old && ! _haveEod(data, cur) )
+                // No progress, so we would need to wait; this fails.
+                hilti::rt::detail::yield();
+        }
+
+        else {
+            SPICY_RT_DEBUG_VERBOSE(hilti::rt::fmt("suspending to wait for more input for stream %p, currently have %lu",
+                                                  data.get(), cur.size()));
+            hilti::rt::detail::yield();
+
+            if ( filters ) {
+                SPICY_RT_DEBUG_VERBOSE("resuming filter execution");
+                spicy::rt::filter::flush(filters);
+            }
         }
 
         SPICY_RT_DEBUG_VERBOSE(
@@ -194,3 +218,112 @@ std::optional<hilti::rt::stream::SafeConstIterator> detail::unitFind(
     else
         return {};
 }
+
+struct detail::SyncMatcher::Automaton {
+    // Fully expanded transition table indexed by state and input byte. State
+    // zero is the root.
+    std::vector<std::array<uint32_t, 256>> next;
+
+    // Length of the path from the root to each state, i.e., the size of the
+    // longest pattern prefix the state represents.
+    std::vector<uint32_t> depth;
+
+    // Length of the longest pattern ending at each state, or zero if none.
+    std::vector<uint32_t> match;
+};
+
+detail::SyncMatcher::SyncMatcher(const hilti::rt::Vector<hilti::rt::Bytes>& patterns) {
+    auto a = std::make_shared<Automaton>();
+    a->next.emplace_back();
+    a->depth.push_back(0);
+    a->match.push_back(0);
+
+    // Build the trie. While doing so, a zero transition means there's no
+    // child yet; no trie edge can lead back to the root.
+    for ( const auto& p : patterns ) {
+        uint32_t state = 0;
+
+        for ( auto c : p.str() ) {
+            auto& n = a->next[state][static_cast<uint8_t>(c)];
+
+            if ( ! n ) {
+                n = a->next.size();
+                a->next.emplace_back();
+                a->depth.push_back(a->depth[state] + 1);
+                a->match.push_back(0);
+            }
+
+            state = a->next[state][static_cast<uint8_t>(c)];
+        }
+
+        a->match[state] = a->depth[state];
+    }
+
+    // Compute failure links breadth-first, turning the trie into a DFA by
+    // filling in all missing transitions.
+    std::vector<uint32_t> fail(a->next.size(), 0);
+    std::deque<uint32_t> queue;
+
+    for ( auto& n : a->next[0] ) {
+        if ( n )
+            queue.push_back(n);
+    }
+
+    while ( ! queue.empty() ) {
+        auto state = queue.front();
+        queue.pop_front();
+
+        auto f = fail[state];
+
+        if ( ! a->match[state] )
+            a->match[state] = a->match[f];
+
+        for ( size_t c = 0; c < 256; c++ ) {
+            auto& n = a->next[state][c];
+
+            if ( n ) {
+                fail[n] = a->next[f][c];
+                queue.push_back(n);
+            }
+            else
+                n = a->next[f][c];
+        }
+    }
+
+    _automaton = std::move(a);
+}
+
+uint64_t detail::SyncMatcher::skip(const hilti::rt::stream::View& cur) const {
+    assert(_automaton);
+    const auto& a = *_automaton;
+
+    uint64_t pos = 0;
+    uint32_t state = 0;
+    std::optional<uint64_t> best;
+
+    try {
+        for ( auto block = cur.firstBlock(); block; block = cur.nextBlock(block) ) {
+            for ( uint64_t i = 0; i < block->size; i++ ) {
+                state = a.next[state][block->start[i]];
+                ++pos;
+
+                if ( auto m = a.match[state] ) {
+                    if ( ! best || pos - m < *best )
+                        best = pos - m;
+                }
+
+                // A match starting even earlier would still have to be in
+                // progress; once none is, we're done.
+                if ( best && pos - a.depth[state] >= *best )
+                    return *best;
+            }
+        }
+    } catch ( const hilti::rt::MissingData& ) {
+        // Ran into a gap, stop scanning there and leave it to the caller to
+        // recover.
+    }
+
+    // Don't skip past a candidate that may still complete.
+    auto pending = pos - a.depth[state];
+    return best ? std::min(*best, pending) : pending;
+}
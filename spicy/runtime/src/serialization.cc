@@ -0,0 +1,875 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+#include <hilti/rt/fmt.h>
+#include <hilti/rt/libhilti.h>
+
+#include <spicy/rt/serialization.h>
+#include <spicy/rt/util.h>
+
+using namespace spicy::rt;
+using namespace spicy::rt::serialization;
+using hilti::rt::TypeInfo;
+
+HILTI_EXCEPTION_IMPL(SerializationError)
+
+static constexpr char Magic[] = {'S', 'P', 'K', 'B'};
+static constexpr char TypeMessage = 'T';
+static constexpr char ValueMessage = 'V';
+
+static void writeUInt(std::string* out, uint64_t x) {
+    while ( x >= 0x80 ) {
+        *out += static_cast<char>((x & 0x7f) | 0x80);
+        x >>= 7;
+    }
+
+    *out += static_cast<char>(x);
+}
+
+static void writeInt(std::string* out, int64_t x) {
+    writeUInt(out, (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63));
+}
+
+static void writeString(std::string* out, const std::string& s) {
+    writeUInt(out, s.size());
+    *out += s;
+}
+
+static void writeKind(std::string* out, Kind k) { *out += static_cast<char>(k); }
+
+static void writeAddress(std::string* out, const hilti::rt::Address& a) {
+    auto addr = a.asInAddr();
+
+    if ( auto* in4 = std::get_if<struct in_addr>(&addr) ) {
+        *out += static_cast<char>(4);
+        out->append(reinterpret_cast<const char*>(in4), sizeof(*in4));
+    }
+    else {
+        *out += static_cast<char>(6);
+        out->append(reinterpret_cast<const char*>(&std::get<struct in6_addr>(addr)), sizeof(struct in6_addr));
+    }
+}
+
+static void writeReal(std::string* out, double d) {
+    uint64_t x;
+    std::memcpy(&x, &d, sizeof(x));
+
+    for ( int i = 0; i < 8; i++ )
+        *out += static_cast<char>((x >> (i * 8)) & 0xff);
+}
+
+serialization::Writer::Writer(std::ostream& out) : _out(out) {
+    _out.write(Magic, sizeof(Magic));
+    _out.put(static_cast<char>(Version));
+}
+
+void serialization::Writer::write(const hilti::rt::type_info::Value& v) {
+    const auto* type = &v.type();
+
+    auto i = _types.find(type);
+    if ( i == _types.end() ) {
+        i = _types.emplace(type, _types.size()).first;
+
+        _buffer.clear();
+        std::vector<const TypeInfo*> structs;
+        _writeType(type, &structs);
+        _writeMessage(TypeMessage, i->second);
+    }
+
+    _buffer.clear();
+    _writeValue(v);
+    _writeMessage(ValueMessage, i->second);
+}
+
+void serialization::Writer::_writeMessage(char kind, uint64_t id) {
+    std::string header;
+    header += kind;
+    writeUInt(&header, id);
+    writeUInt(&header, _buffer.size());
+
+    _out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    _out.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+}
+
+void serialization::Writer::_writeType(const TypeInfo* type, std::vector<const TypeInfo*>* structs) {
+    auto* out = &_buffer;
+
+    switch ( type->tag ) {
+        case TypeInfo::Bool: writeKind(out, Kind::Bool); return;
+
+        case TypeInfo::SignedInteger_int8:
+        case TypeInfo::SignedInteger_int16:
+        case TypeInfo::SignedInteger_int32:
+        case TypeInfo::SignedInteger_int64: {
+            writeKind(out, Kind::SignedInt);
+
+            switch ( type->tag ) {
+                case TypeInfo::SignedInteger_int8: *out += static_cast<char>(8); break;
+                case TypeInfo::SignedInteger_int16: *out += static_cast<char>(16); break;
+                case TypeInfo::SignedInteger_int32: *out += static_cast<char>(32); break;
+                default: *out += static_cast<char>(64); break;
+            }
+
+            return;
+        }
+
+        case TypeInfo::UnsignedInteger_uint8:
+        case TypeInfo::UnsignedInteger_uint16:
+        case TypeInfo::UnsignedInteger_uint32:
+        case TypeInfo::UnsignedInteger_uint64: {
+            writeKind(out, Kind::UnsignedInt);
+
+            switch ( type->tag ) {
+                case TypeInfo::UnsignedInteger_uint8: *out += static_cast<char>(8); break;
+                case TypeInfo::UnsignedInteger_uint16: *out += static_cast<char>(16); break;
+                case TypeInfo::UnsignedInteger_uint32: *out += static_cast<char>(32); break;
+                default: *out += static_cast<char>(64); break;
+            }
+
+            return;
+        }
+
+        case TypeInfo::Real: writeKind(out, Kind::Real); return;
+
+        case TypeInfo::Bytes:
+        case TypeInfo::Stream:
+        case TypeInfo::StreamView: writeKind(out, Kind::Bytes); return;
+
+        case TypeInfo::String: writeKind(out, Kind::String); return;
+        case TypeInfo::Address: writeKind(out, Kind::Address); return;
+        case TypeInfo::Network: writeKind(out, Kind::Network); return;
+        case TypeInfo::Port: writeKind(out, Kind::Port); return;
+        case TypeInfo::Time: writeKind(out, Kind::Time); return;
+        case TypeInfo::Interval: writeKind(out, Kind::Interval); return;
+
+        case TypeInfo::Enum: {
+            writeKind(out, Kind::Enum);
+            writeString(out, type->id ? *type->id : type->display);
+
+            const auto& labels = type->enum_->labels();
+            writeUInt(out, labels.size());
+
+            for ( const auto& l : labels ) {
+                writeString(out, l.name);
+                writeInt(out, l.value);
+            }
+
+            return;
+        }
+
+        case TypeInfo::Struct: {
+            if ( auto i = std::find(structs->begin(), structs->end(), type); i != structs->end() ) {
+                writeKind(out, Kind::StructRef);
+                writeUInt(out, i - structs->begin());
+                return;
+            }
+
+            structs->push_back(type);
+
+            writeKind(out, Kind::Struct);
+            writeString(out, type->id ? *type->id : type->display);
+
+            auto fields = type->struct_->fields();
+            writeUInt(out, fields.size());
+
+            for ( const auto& f : fields ) {
+                writeString(out, f.get().name);
+                *out += static_cast<char>(f.get().isAnonymous() ? FieldFlags::Anonymous : 0);
+                _writeType(f.get().type, structs);
+            }
+
+            return;
+        }
+
+        case TypeInfo::Tuple: {
+            writeKind(out, Kind::Tuple);
+
+            const auto& elements = type->tuple->elements();
+            writeUInt(out, elements.size());
+
+            for ( const auto& e : elements ) {
+                writeString(out, e.name);
+                _writeType(e.type, structs);
+            }
+
+            return;
+        }
+
+        case TypeInfo::Union: {
+            writeKind(out, Kind::Union);
+
+            const auto& fields = type->union_->fields();
+            writeUInt(out, fields.size());
+
+            for ( const auto& f : fields ) {
+                writeString(out, f.name);
+                _writeType(f.type, structs);
+            }
+
+            return;
+        }
+
+        case TypeInfo::Bitfield: {
+            writeKind(out, Kind::Bitfield);
+
+            const auto& bits = type->bitfield->bits();
+            writeUInt(out, bits.size());
+
+            for ( const auto& b : bits ) {
+                writeString(out, b.name);
+                _writeType(b.type, structs);
+            }
+
+            return;
+        }
+
+        case TypeInfo::Vector:
+            writeKind(out, Kind::Vector);
+            _writeType(type->vector->dereferencedType(), structs);
+            return;
+
+        case TypeInfo::Set:
+            writeKind(out, Kind::Set);
+            _writeType(type->set->dereferencedType(), structs);
+            return;
+
+        case TypeInfo::Map:
+            writeKind(out, Kind::Map);
+            _writeType(type->map->keyType(), structs);
+            _writeType(type->map->valueType(), structs);
+            return;
+
+        case TypeInfo::Optional:
+            writeKind(out, Kind::Optional);
+            _writeType(type->optional->valueType(), structs);
+            return;
+
+        case TypeInfo::Result:
+            writeKind(out, Kind::Optional);
+            _writeType(type->result->valueType(), structs);
+            return;
+
+        case TypeInfo::StrongReference:
+            writeKind(out, Kind::Optional);
+            _writeType(type->strong_reference->valueType(), structs);
+            return;
+
+        case TypeInfo::ValueReference:
+            writeKind(out, Kind::Optional);
+            _writeType(type->value_reference->valueType(), structs);
+            return;
+
+        case TypeInfo::WeakReference:
+            writeKind(out, Kind::Optional);
+            _writeType(type->weak_reference->valueType(), structs);
+            return;
+
+        case TypeInfo::Undefined: throw hilti::rt::RuntimeError("unhandled type");
+
+        case TypeInfo::Any:
+        case TypeInfo::BytesIterator:
+        case TypeInfo::Error:
+        case TypeInfo::Exception:
+        case TypeInfo::Function:
+        case TypeInfo::Library:
+        case TypeInfo::MapIterator:
+        case TypeInfo::RegExp:
+        case TypeInfo::SetIterator:
+        case TypeInfo::StreamIterator:
+        case TypeInfo::VectorIterator:
+        case TypeInfo::Void: writeKind(out, Kind::Text); return;
+    }
+
+    throw hilti::rt::RuntimeError("unhandled type");
+}
+
+// Writes a value contained in a type mapped to `Kind::Optional`.
+#define WRITE_OPTIONAL(accessor)                                                                                       \
+    {                                                                                                                  \
+        auto y = type.accessor->value(v);                                                                              \
+        *out += static_cast<char>(y ? 1 : 0);                                                                          \
+        if ( y )                                                                                                       \
+            _writeValue(y);                                                                                            \
+        return;                                                                                                        \
+    }
+
+void serialization::Writer::_writeValue(const hilti::rt::type_info::Value& v) {
+    auto* out = &_buffer;
+    const auto& type = v.type();
+
+    switch ( type.tag ) {
+        case TypeInfo::Bool: *out += static_cast<char>(type.bool_->get(v) ? 1 : 0); return;
+        case TypeInfo::SignedInteger_int8: writeInt(out, type.signed_integer_int8->get(v)); return;
+        case TypeInfo::SignedInteger_int16: writeInt(out, type.signed_integer_int16->get(v)); return;
+        case TypeInfo::SignedInteger_int32: writeInt(out, type.signed_integer_int32->get(v)); return;
+        case TypeInfo::SignedInteger_int64: writeInt(out, type.signed_integer_int64->get(v)); return;
+        case TypeInfo::UnsignedInteger_uint8: writeUInt(out, type.unsigned_integer_uint8->get(v)); return;
+        case TypeInfo::UnsignedInteger_uint16: writeUInt(out, type.unsigned_integer_uint16->get(v)); return;
+        case TypeInfo::UnsignedInteger_uint32: writeUInt(out, type.unsigned_integer_uint32->get(v)); return;
+        case TypeInfo::UnsignedInteger_uint64: writeUInt(out, type.unsigned_integer_uint64->get(v)); return;
+        case TypeInfo::Real: writeReal(out, type.real->get(v)); return;
+        case TypeInfo::Bytes: writeString(out, type.bytes->get(v).str()); return;
+        case TypeInfo::Stream: writeString(out, type.stream->get(v).view().data().str()); return;
+        case TypeInfo::StreamView: writeString(out, type.stream_view->get(v).data().str()); return;
+        case TypeInfo::String: writeString(out, type.string->get(v)); return;
+        case TypeInfo::Address: writeAddress(out, type.address->get(v)); return;
+
+        case TypeInfo::Network: {
+            const auto& n = type.network->get(v);
+            writeAddress(out, n.prefix());
+            *out += static_cast<char>(n.length());
+            return;
+        }
+
+        case TypeInfo::Port: {
+            const auto& p = type.port->get(v);
+            writeUInt(out, p.port());
+            *out += static_cast<char>(p.protocol().value());
+            return;
+        }
+
+        case TypeInfo::Time: writeUInt(out, type.time->get(v).nanoseconds()); return;
+        case TypeInfo::Interval: writeInt(out, type.interval->get(v).nanoseconds()); return;
+        case TypeInfo::Enum: writeInt(out, type.enum_->get(v).value); return;
+
+        case TypeInfo::Struct: {
+            auto fields = type.struct_->iterate(v);
+
+            auto bitmap_offset = out->size();
+            out->append((fields.size() + 7) / 8, '\0');
+
+            for ( size_t i = 0; i < fields.size(); i++ ) {
+                if ( ! fields[i].second )
+                    // Field not set.
+                    continue;
+
+                (*out)[bitmap_offset + i / 8] |= static_cast<char>(1 << (i % 8));
+                _writeValue(fields[i].second);
+            }
+
+            return;
+        }
+
+        case TypeInfo::Tuple:
+            for ( const auto& i : type.tuple->iterate(v) )
+                _writeValue(i.second);
+
+            return;
+
+        case TypeInfo::Bitfield:
+            for ( const auto& i : type.bitfield->iterate(v) )
+                _writeValue(i.second);
+
+            return;
+
+        case TypeInfo::Union: {
+            auto index = type.union_->index(v);
+            writeUInt(out, index);
+
+            if ( index > 0 )
+                _writeValue(type.union_->value(v));
+
+            return;
+        }
+
+        case TypeInfo::Vector: {
+            // The element count precedes the elements, so count them first.
+            uint64_t n = 0;
+            for ( auto i : type.vector->iterate(v) ) {
+                (void)i;
+                ++n;
+            }
+
+            writeUInt(out, n);
+
+            for ( auto i : type.vector->iterate(v) )
+                _writeValue(i);
+
+            return;
+        }
+
+        case TypeInfo::Set: {
+            uint64_t n = 0;
+            for ( auto i : type.set->iterate(v) ) {
+                (void)i;
+                ++n;
+            }
+
+            writeUInt(out, n);
+
+            for ( auto i : type.set->iterate(v) )
+                _writeValue(i);
+
+            return;
+        }
+
+        case TypeInfo::Map: {
+            uint64_t n = 0;
+            for ( auto i : type.map->iterate(v) ) {
+                (void)i;
+                ++n;
+            }
+
+            writeUInt(out, n);
+
+            for ( auto [key, value] : type.map->iterate(v) ) {
+                _writeValue(key);
+                _writeValue(value);
+            }
+
+            return;
+        }
+
+        case TypeInfo::Optional: WRITE_OPTIONAL(optional);
+        case TypeInfo::Result: WRITE_OPTIONAL(result);
+        case TypeInfo::StrongReference: WRITE_OPTIONAL(strong_reference);
+        case TypeInfo::ValueReference: WRITE_OPTIONAL(value_reference);
+        case TypeInfo::WeakReference: WRITE_OPTIONAL(weak_reference);
+
+        case TypeInfo::Undefined: throw hilti::rt::RuntimeError("unhandled type");
+
+        case TypeInfo::Any: writeString(out, "<any>"); return;
+        case TypeInfo::BytesIterator: writeString(out, hilti::rt::to_string(type.bytes_iterator->get(v))); return;
+        case TypeInfo::Error: writeString(out, hilti::rt::to_string(type.error->get(v))); return;
+        case TypeInfo::Exception: writeString(out, hilti::rt::to_string(type.exception->get(v))); return;
+        case TypeInfo::Function: writeString(out, "<function>"); return;
+        case TypeInfo::Library: writeString(out, "<library value>"); return;
+        case TypeInfo::RegExp: writeString(out, hilti::rt::to_string(type.regexp->get(v))); return;
+        case TypeInfo::StreamIterator:
+            writeString(out, hilti::rt::to_string_for_print(type.stream_iterator->get(v)));
+            return;
+        case TypeInfo::Void: writeString(out, "<void>"); return;
+
+        case TypeInfo::MapIterator:
+        case TypeInfo::SetIterator:
+        case TypeInfo::VectorIterator: writeString(out, "<iterator>"); return;
+    }
+
+    throw hilti::rt::RuntimeError("unhandled type");
+}
+
+#undef WRITE_OPTIONAL
+
+namespace {
+
+// Decodes the primitives of a single message's payload.
+class Decoder {
+public:
+    explicit Decoder(const std::string& data) : _data(data) {}
+
+    bool atEnd() const { return _pos == _data.size(); }
+
+    /** Returns the number of bytes not yet decoded. */
+    size_t remaining() const { return _data.size() - _pos; }
+
+    uint8_t byte() { return static_cast<uint8_t>(*_raw(1)); }
+
+    uint64_t uint() {
+        uint64_t x = 0;
+
+        for ( int shift = 0; shift < 64; shift += 7 ) {
+            auto b = byte();
+            x |= static_cast<uint64_t>(b & 0x7f) << shift;
+
+            if ( ! (b & 0x80) )
+                return x;
+        }
+
+        throw SerializationError("invalid integer encoding");
+    }
+
+    int64_t int_() {
+        auto x = uint();
+        return static_cast<int64_t>((x >> 1) ^ (~(x & 1) + 1));
+    }
+
+    std::string string() {
+        auto n = uint();
+        return std::string(_raw(n), n);
+    }
+
+    double real() {
+        uint64_t x = 0;
+        const auto* p = _raw(8);
+
+        for ( int i = 0; i < 8; i++ )
+            x |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (i * 8);
+
+        double d;
+        std::memcpy(&d, &x, sizeof(d));
+        return d;
+    }
+
+    hilti::rt::Address address() {
+        switch ( byte() ) {
+            case 4: {
+                struct in_addr a;
+                std::memcpy(&a, _raw(sizeof(a)), sizeof(a));
+                return hilti::rt::Address(a);
+            }
+
+            case 6: {
+                struct in6_addr a;
+                std::memcpy(&a, _raw(sizeof(a)), sizeof(a));
+                return hilti::rt::Address(a);
+            }
+
+            default: throw SerializationError("invalid address family");
+        }
+    }
+
+private:
+    const char* _raw(uint64_t n) {
+        if ( n > _data.size() - _pos )
+            throw SerializationError("unexpected end of message");
+
+        const auto* p = _data.data() + _pos;
+        _pos += n;
+        return p;
+    }
+
+    const std::string& _data;
+    size_t _pos = 0;
+};
+
+// Maximum nesting of types and values we accept, to protect against
+// malformed input exhausting the stack.
+constexpr int MaxDepth = 256;
+
+// Maximum number of elements we accept for containers whose elements may
+// encode to zero bytes, such as vectors of empty structs. For all other
+// containers, the size of the message bounds the number of elements.
+constexpr uint64_t MaxZeroSizeElements = 65536;
+
+// Maximum number of bytes we read from the input at a time, so that a
+// corrupt message length doesn't make us allocate more than the input
+// actually provides.
+constexpr uint64_t ReadChunkSize = 65536;
+
+// Returns the minimum number of bytes that any value of the given type
+// encodes to.
+uint64_t minEncodedSize(const Type* t) {
+    switch ( t->kind ) {
+        case Kind::Real: return 8;
+        case Kind::Address: return 1 + 4;
+        case Kind::Network: return 1 + 4 + 1;
+        case Kind::Port: return 2;
+        case Kind::Struct: return (t->fields.size() + 7) / 8; // fields may all be unset
+
+        case Kind::Tuple:
+        case Kind::Bitfield: {
+            uint64_t n = 0;
+            for ( const auto& f : t->fields )
+                n += minEncodedSize(f.type);
+
+            return n;
+        }
+
+        case Kind::StructRef: return 0; // resolved during decoding, never part of a schema
+
+        default: return 1; // everything else starts with at least one byte
+    }
+}
+
+const Type* decodeType(Decoder* d, std::vector<std::unique_ptr<Type>>* types, std::vector<const Type*>* structs,
+                       int depth) {
+    if ( depth > MaxDepth )
+        throw SerializationError("type nested too deeply");
+
+    auto kind = static_cast<Kind>(d->byte());
+
+    if ( kind == Kind::StructRef ) {
+        auto i = d->uint();
+        if ( i >= structs->size() )
+            throw SerializationError("invalid struct reference");
+
+        return (*structs)[i];
+    }
+
+    auto* t = types->emplace_back(std::make_unique<Type>()).get();
+    t->kind = kind;
+
+    switch ( kind ) {
+        case Kind::Bool:
+        case Kind::Real:
+        case Kind::Bytes:
+        case Kind::String:
+        case Kind::Address:
+        case Kind::Network:
+        case Kind::Port:
+        case Kind::Time:
+        case Kind::Interval:
+        case Kind::Text: break;
+
+        case Kind::SignedInt:
+        case Kind::UnsignedInt: t->width = d->byte(); break;
+
+        case Kind::Enum: {
+            t->name = d->string();
+
+            for ( auto n = d->uint(); n > 0; n-- ) {
+                auto name = d->string();
+                t->fields.push_back(Field{.name = std::move(name), .value = d->int_()});
+            }
+
+            break;
+        }
+
+        case Kind::Struct: {
+            structs->push_back(t);
+            t->name = d->string();
+
+            for ( auto n = d->uint(); n > 0; n-- ) {
+                auto name = d->string();
+                auto flags = d->byte();
+                t->fields.push_back(
+                    Field{.name = std::move(name), .type = decodeType(d, types, structs, depth + 1), .flags = flags});
+            }
+
+            break;
+        }
+
+        case Kind::Tuple:
+        case Kind::Union:
+        case Kind::Bitfield: {
+            for ( auto n = d->uint(); n > 0; n-- ) {
+                auto name = d->string();
+                t->fields.push_back(Field{.name = std::move(name), .type = decodeType(d, types, structs, depth + 1)});
+            }
+
+            break;
+        }
+
+        case Kind::Vector:
+        case Kind::Set:
+        case Kind::Optional: t->element = decodeType(d, types, structs, depth + 1); break;
+
+        case Kind::Map:
+            t->element = decodeType(d, types, structs, depth + 1);
+            t->value = decodeType(d, types, structs, depth + 1);
+            break;
+
+        default: throw SerializationError(hilti::rt::fmt("unknown type kind %d", static_cast<int>(kind)));
+    }
+
+    return t;
+}
+
+serialization::Value decodeValue(Decoder* d, const Type* t, int depth) {
+    if ( depth > MaxDepth )
+        throw SerializationError("value nested too deeply");
+
+    serialization::Value v;
+    v.type = t;
+
+    switch ( t->kind ) {
+        case Kind::Bool: v.data = (d->byte() != 0); break;
+        case Kind::SignedInt:
+        case Kind::Interval:
+        case Kind::Enum: v.data = d->int_(); break;
+        case Kind::UnsignedInt:
+        case Kind::Time: v.data = d->uint(); break;
+        case Kind::Real: v.data = d->real(); break;
+        case Kind::Bytes:
+        case Kind::String:
+        case Kind::Text: v.data = d->string(); break;
+        case Kind::Address: v.data = hilti::rt::to_string(d->address()); break;
+
+        case Kind::Network: {
+            auto prefix = d->address();
+            auto length = d->byte();
+
+            if ( length > (prefix.family() == hilti::rt::AddressFamily::IPv4 ? 32 : 128) )
+                throw SerializationError("invalid network prefix length");
+
+            v.data = hilti::rt::to_string(hilti::rt::Network(prefix, length));
+            break;
+        }
+
+        case Kind::Port: {
+            auto port = d->uint();
+            auto protocol = d->byte();
+
+            if ( port > 0xffff || protocol > hilti::rt::Protocol::ICMP )
+                throw SerializationError("invalid port");
+
+            v.data = hilti::rt::to_string(hilti::rt::Port(port, hilti::rt::Protocol(protocol)));
+            break;
+        }
+
+        case Kind::Struct: {
+            auto n = t->fields.size();
+
+            std::string bitmap;
+            for ( size_t i = 0; i < (n + 7) / 8; i++ )
+                bitmap += static_cast<char>(d->byte());
+
+            std::vector<serialization::Value> fields(n);
+            for ( size_t i = 0; i < n; i++ ) {
+                if ( bitmap[i / 8] & (1 << (i % 8)) )
+                    fields[i] = decodeValue(d, t->fields[i].type, depth + 1);
+                else
+                    fields[i].type = t->fields[i].type;
+            }
+
+            v.data = std::move(fields);
+            break;
+        }
+
+        case Kind::Tuple:
+        case Kind::Bitfield: {
+            std::vector<serialization::Value> elements;
+            elements.reserve(t->fields.size());
+
+            for ( const auto& f : t->fields )
+                elements.push_back(decodeValue(d, f.type, depth + 1));
+
+            v.data = std::move(elements);
+            break;
+        }
+
+        case Kind::Union: {
+            std::vector<serialization::Value> fields(t->fields.size());
+            for ( size_t i = 0; i < fields.size(); i++ )
+                fields[i].type = t->fields[i].type;
+
+            if ( auto i = d->uint(); i > 0 ) {
+                if ( i > fields.size() )
+                    throw SerializationError("invalid union field");
+
+                fields[i - 1] = decodeValue(d, t->fields[i - 1].type, depth + 1);
+            }
+
+            v.data = std::move(fields);
+            break;
+        }
+
+        case Kind::Vector:
+        case Kind::Set:
+        case Kind::Map: {
+            auto n = d->uint();
+
+            auto min_size = minEncodedSize(t->element);
+            if ( t->kind == Kind::Map )
+                min_size += minEncodedSize(t->value);
+
+            if ( (min_size > 0 && n > d->remaining() / min_size) || (min_size == 0 && n > MaxZeroSizeElements) )
+                throw SerializationError("invalid number of elements");
+
+            std::vector<serialization::Value> elements;
+            for ( uint64_t i = 0; i < n; i++ ) {
+                elements.push_back(decodeValue(d, t->element, depth + 1));
+
+                if ( t->kind == Kind::Map )
+                    elements.push_back(decodeValue(d, t->value, depth + 1));
+            }
+
+            v.data = std::move(elements);
+            break;
+        }
+
+        case Kind::Optional: {
+            std::vector<serialization::Value> value;
+
+            if ( d->byte() )
+                value.push_back(decodeValue(d, t->element, depth + 1));
+
+            v.data = std::move(value);
+            break;
+        }
+
+        case Kind::StructRef: throw SerializationError("unexpected struct reference");
+    }
+
+    return v;
+}
+
+} // namespace
+
+serialization::Reader::Reader(std::istream& in) : _in(in) {
+    char header[sizeof(Magic) + 1];
+
+    if ( ! _in.read(header, sizeof(header)) || std::memcmp(header, Magic, sizeof(Magic)) != 0 )
+        throw SerializationError("input is not in Spicy's binary serialization format");
+
+    if ( static_cast<uint8_t>(header[sizeof(Magic)]) != Version )
+        throw SerializationError(hilti::rt::fmt("unsupported serialization format version %d",
+                                                static_cast<int>(static_cast<uint8_t>(header[sizeof(Magic)]))));
+}
+
+// Reads a varint directly from the input stream.
+static std::optional<uint64_t> readUInt(std::istream& in) {
+    uint64_t x = 0;
+
+    for ( int shift = 0; shift < 64; shift += 7 ) {
+        auto c = in.get();
+        if ( c == std::istream::traits_type::eof() )
+            return {};
+
+        x |= static_cast<uint64_t>(c & 0x7f) << shift;
+
+        if ( ! (c & 0x80) )
+            return x;
+    }
+
+    throw SerializationError("invalid integer encoding");
+}
+
+std::optional<serialization::Value> serialization::Reader::read() {
+    while ( true ) {
+        auto kind = _in.get();
+        if ( kind == std::istream::traits_type::eof() )
+            return {};
+
+        auto id = readUInt(_in);
+        auto len = readUInt(_in);
+        if ( ! (id && len) )
+            throw SerializationError("unexpected end of input");
+
+        // Read the payload in chunks, so that we don't trust the length with
+        // allocating memory before the input proves to have that much data.
+        std::string payload;
+        for ( auto remaining = *len; remaining > 0; ) {
+            auto size = payload.size();
+            auto chunk = std::min(remaining, ReadChunkSize);
+            payload.resize(size + chunk);
+
+            if ( ! _in.read(payload.data() + size, static_cast<std::streamsize>(chunk)) )
+                throw SerializationError("unexpected end of input");
+
+            remaining -= chunk;
+        }
+
+        Decoder d(payload);
+
+        switch ( kind ) {
+            case TypeMessage: {
+                Schema schema;
+                std::vector<const Type*> structs;
+                decodeType(&d, &schema.types, &structs, 0);
+                _schemas[*id] = std::move(schema);
+                break;
+            }
+
+            case ValueMessage: {
+                auto schema = _schemas.find(*id);
+                if ( schema == _schemas.end() )
+                    throw SerializationError(hilti::rt::fmt("value refers to unknown type %d", *id));
+
+                auto v = decodeValue(&d, schema->second.types.front().get(), 0);
+                if ( ! d.atEnd() )
+                    throw SerializationError("trailing data in value");
+
+                return v;
+            }
+
+            default: throw SerializationError(hilti::rt::fmt("unknown message kind %d", kind));
+        }
+    }
+}
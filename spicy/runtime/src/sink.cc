@@ -20,6 +20,47 @@ void Sink::_init() {
     _last_reassem_rseq = 0;
     _trim_rseq = 0;
     _chunks.clear();
+    _index.clear();
+}
+
+void Sink::set_policy(sink::ReassemblerPolicy policy) {
+    _policy = policy;
+    _index.clear();
+
+    if ( _policy == sink::ReassemblerPolicy::FirstIndexed ) {
+        for ( auto c = _chunks.begin(); c != _chunks.end(); c++ )
+            _index.emplace(c->rupper, c);
+    }
+}
+
+Sink::ChunkList::iterator Sink::_findChunk(uint64_t rseq, ChunkList::iterator c) {
+    if ( _policy == sink::ReassemblerPolicy::FirstIndexed ) {
+        // Chunks don't overlap, so their upper bounds are ordered just like
+        // the chunks themselves.
+        auto i = _index.upper_bound(rseq);
+        return i != _index.end() ? i->second : _chunks.end();
+    }
+
+    for ( ; c != _chunks.end() && c->rupper <= rseq; c++ )
+        ;
+
+    return c;
+}
+
+Sink::ChunkList::iterator Sink::_insertChunk(ChunkList::iterator pos, Chunk chunk) {
+    auto c = _chunks.insert(pos, std::move(chunk));
+
+    if ( _policy == sink::ReassemblerPolicy::FirstIndexed )
+        _index.emplace(c->rupper, c);
+
+    return c;
+}
+
+Sink::ChunkList::iterator Sink::_eraseChunk(ChunkList::iterator c) {
+    if ( _policy == sink::ReassemblerPolicy::FirstIndexed )
+        _index.erase(c->rupper);
+
+    return _chunks.erase(c);
 }
 
 Sink::ChunkList::iterator Sink::_addAndCheck(std::optional<hilti::rt::Bytes> data, uint64_t rseq, uint64_t rupper,
@@ -27,24 +68,19 @@ Sink::ChunkList::iterator Sink::_addAndCheck(std::optional<hilti::rt::Bytes> dat
     assert(! _chunks.empty());
 
     // Special check for the common case of appending to the end.
-    if ( rseq == _chunks.back().rupper ) {
-        _chunks.emplace_back(std::move(data), rseq, rupper);
-        return std::next(_chunks.end(), -1);
-    }
+    if ( rseq == _chunks.back().rupper )
+        return _insertChunk(_chunks.end(), Chunk(std::move(data), rseq, rupper));
 
     // Find the first block that doesn't come completely before the new data.
-    for ( ; c != _chunks.end() && c->rupper <= rseq; c++ )
-        ;
+    c = _findChunk(rseq, c);
 
-    if ( c == _chunks.end() ) {
+    if ( c == _chunks.end() )
         // c is the last block, and it comes completely before the new block.
-        _chunks.emplace_back(std::move(data), rseq, rupper);
-        return std::next(_chunks.end(), -1);
-    }
+        return _insertChunk(_chunks.end(), Chunk(std::move(data), rseq, rupper));
 
     if ( rupper <= c->rseq )
         // The new block comes completely before c.
-        return _chunks.insert(c, Chunk(std::move(data), rseq, rupper));
+        return _insertChunk(c, Chunk(std::move(data), rseq, rupper));
 
     ChunkList::iterator new_c;
 
@@ -56,7 +92,7 @@ Sink::ChunkList::iterator Sink::_addAndCheck(std::optional<hilti::rt::Bytes> dat
 
         if ( data ) {
             auto prefix = data->sub(data->begin() + prefix_len);
-            new_c = _chunks.insert(c, Chunk(std::move(prefix), rseq, rseq + prefix_len));
+            new_c = _insertChunk(c, Chunk(std::move(prefix), rseq, rseq + prefix_len));
             data = data->sub(data->begin() + prefix_len, data->end());
         }
 
@@ -194,10 +230,8 @@ void Sink::_newData(std::optional<hilti::rt::Bytes> data, uint64_t rseq, uint64_
             data = data->sub(data->begin() + amount_old, data->end());
     }
 
-    if ( _chunks.empty() ) {
-        _chunks.emplace_back(std::move(data), rseq, rseq + len);
-        c = std::next(_chunks.end(), -1);
-    }
+    if ( _chunks.empty() )
+        c = _insertChunk(_chunks.end(), Chunk(std::move(data), rseq, rseq + len));
     else
         c = _addAndCheck(std::move(data), rseq, rupper_rseq, _chunks.begin());
 
@@ -239,7 +273,7 @@ void Sink::_trim(uint64_t rseq) {
         SPICY_RT_DEBUG_VERBOSE(fmt("trimming sink %p to EOD", this));
     }
 
-    for ( auto c = _chunks.begin(); c != _chunks.end(); c = _chunks.erase(c) ) {
+    for ( auto c = _chunks.begin(); c != _chunks.end(); c = _eraseChunk(c) ) {
         if ( c->rseq >= rseq )
             break;
 
@@ -461,6 +495,7 @@ std::string to_string(const Sink& /*x*/, tag /*unused*/) { return "<sink>"; }
 std::string to_string(const sink::ReassemblerPolicy& x, tag /*unused*/) {
     switch ( x ) {
         case spicy::rt::sink::ReassemblerPolicy::First: return "sink::ReassemblerPolicy::First";
+        case spicy::rt::sink::ReassemblerPolicy::FirstIndexed: return "sink::ReassemblerPolicy::FirstIndexed";
     }
 
     cannot_be_reached();
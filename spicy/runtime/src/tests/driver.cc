@@ -0,0 +1,169 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <doctest/doctest.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <hilti/rt/fiber.h>
+#include <hilti/rt/init.h>
+#include <hilti/rt/types/reference.h>
+#include <hilti/rt/types/stream.h>
+
+#include <spicy/rt/driver.h>
+#include <spicy/rt/filter.h>
+#include <spicy/rt/parser.h>
+#include <spicy/rt/typedefs.h>
+
+using hilti::rt::Nothing;
+using namespace hilti::rt::bytes::literals;
+using namespace spicy::rt;
+
+namespace {
+
+// Input stream and data that the most recent parser invocation received.
+std::shared_ptr<hilti::rt::Stream> last_input;
+hilti::rt::Bytes last_data;
+
+// Parser requiring at least four bytes of input, and rejecting any input that contains an `x`.
+hilti::rt::Resumable parseBlock(hilti::rt::ValueReference<hilti::rt::Stream>& data,
+                                const std::optional<hilti::rt::stream::View>& /* cur */,
+                                const std::optional<UnitContext>& /* context */) {
+    return hilti::rt::fiber::execute([&data](hilti::rt::resumable::Handle* /* r */) {
+        last_input = data.asSharedPtr();
+        last_data = data->view().data();
+
+        auto filters = hilti::rt::StrongReference<filter::detail::Filters>();
+        detail::waitForInput(data, data->view(), 4, "insufficient input", "location", filters);
+
+        if ( last_data.str().find('x') != std::string::npos )
+            throw ParseError("unexpected x", "location");
+
+        return Nothing();
+    });
+}
+
+// Parser suspending unconditionally.
+hilti::rt::Resumable parseYield(hilti::rt::ValueReference<hilti::rt::Stream>& data,
+                                const std::optional<hilti::rt::stream::View>& /* cur */,
+                                const std::optional<UnitContext>& /* context */) {
+    return hilti::rt::fiber::execute([&data](hilti::rt::resumable::Handle* /* r */) {
+        last_input = data.asSharedPtr();
+        last_data = data->view().data();
+        hilti::rt::detail::yield();
+        return Nothing();
+    });
+}
+
+class TestState : public driver::ParsingState {
+public:
+    using driver::ParsingState::ParsingState;
+
+protected:
+    void debug(const std::string& /* msg */) override {}
+};
+
+} // namespace
+
+TEST_SUITE_BEGIN("Driver");
+
+TEST_CASE("processBlock") {
+    hilti::rt::init(); // Noop if already initialized.
+
+    const Parser block_parser("Block", true, parseBlock, Parse2Function<int>(), Parse3Function(), nullptr, nullptr,
+                              "", {}, {});
+    const Parser yield_parser("Yield", true, parseYield, Parse2Function<int>(), Parse3Function(), nullptr, nullptr,
+                              "", {}, {});
+
+    last_input.reset();
+    last_data = ""_b;
+
+    SUBCASE("fresh input for each block") {
+        TestState state(driver::ParsingType::Block, &block_parser);
+
+        std::vector<std::string> blocks = {"abcd", "efghij", "klmn"};
+        std::vector<std::shared_ptr<hilti::rt::Stream>> inputs;
+
+        for ( auto& block : blocks ) {
+            CHECK_EQ(state.processBlock(block.size(), block.data()), driver::ParsingState::Done);
+            CHECK_EQ(last_data, hilti::rt::Bytes(block.data(), block.size()));
+
+            for ( const auto& i : inputs )
+                CHECK(last_input != i);
+
+            inputs.push_back(last_input);
+        }
+    }
+
+    SUBCASE("does not retain caller's data") {
+        TestState state(driver::ParsingType::Block, &block_parser);
+
+        std::string block = "abcd";
+        CHECK_EQ(state.processBlock(block.size(), block.data()), driver::ParsingState::Done);
+        REQUIRE(last_input);
+        CHECK(last_input->isEmpty());
+        CHECK_FALSE(last_input->isFrozen());
+
+        // Overwriting the caller's buffer must not affect anything parsed
+        // before, while the next block sees the new content.
+        block = "efgh";
+        CHECK_EQ(last_data, "abcd"_b);
+        CHECK_EQ(state.processBlock(block.size(), block.data()), driver::ParsingState::Done);
+        CHECK_EQ(last_data, "efgh"_b);
+        CHECK(last_input->isEmpty());
+    }
+
+    SUBCASE("parse error in middle of block") {
+        TestState state(driver::ParsingType::Block, &block_parser);
+
+        std::vector<std::string> blocks = {"abcd", "efxgh", "ijkl"};
+
+        CHECK_EQ(state.processBlock(blocks[0].size(), blocks[0].data()), driver::ParsingState::Done);
+        CHECK_THROWS_WITH_AS(state.processBlock(blocks[1].size(), blocks[1].data()), "unexpected x (location)",
+                             const ParseError&);
+        CHECK_EQ(last_data, "efxgh"_b);
+        CHECK(last_input->isEmpty());
+
+        // Blocks are independent, so the next one parses normally.
+        CHECK_EQ(state.processBlock(blocks[2].size(), blocks[2].data()), driver::ParsingState::Done);
+        CHECK_EQ(last_data, "ijkl"_b);
+        CHECK(last_input->isEmpty());
+    }
+
+    SUBCASE("incomplete block") {
+        TestState state(driver::ParsingType::Block, &block_parser);
+
+        // The block is complete by definition, so instead of waiting for
+        // more input the parser reports an error.
+        std::string block = "ab";
+        CHECK_THROWS_WITH_AS(state.processBlock(block.size(), block.data()), "insufficient input (location)",
+                             const ParseError&);
+        CHECK(last_input->isEmpty());
+    }
+
+    SUBCASE("parser yields") {
+        TestState state(driver::ParsingType::Block, &yield_parser);
+
+        std::string block = "abcd";
+        CHECK_THROWS_WITH_AS(state.processBlock(block.size(), block.data()), "'yield' in non-suspendable context",
+                             const hilti::rt::RuntimeError&);
+        CHECK_EQ(last_data, "abcd"_b);
+        CHECK(last_input->isEmpty());
+    }
+
+    SUBCASE("stream parsing") {
+        // For stream-based parsing, `processBlock()` forwards to `process()`,
+        // which copies the data and runs the parser inside a fiber.
+        TestState state(driver::ParsingType::Stream, &yield_parser);
+
+        std::string block = "abcd";
+        CHECK_EQ(state.processBlock(block.size(), block.data()), driver::ParsingState::Continue);
+        block = "efgh";
+        CHECK_EQ(last_data, "abcd"_b);
+        CHECK_EQ(last_input->view().data(), "abcd"_b);
+    }
+}
+
+TEST_SUITE_END();
@@ -2,6 +2,7 @@
 
 #include <doctest/doctest.h>
 
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -414,6 +415,26 @@ TEST_CASE("waitForInputOrEod with min") {
     }
 }
 
+TEST_CASE("pending backtrack") {
+    CHECK_FALSE(detail::hasPendingBacktrack());
+    CHECK_NOTHROW(detail::raisePendingBacktrack());
+
+    detail::requestBacktrack();
+    CHECK(detail::hasPendingBacktrack());
+    CHECK(detail::takePendingBacktrack());
+    CHECK_FALSE(detail::hasPendingBacktrack());
+    CHECK_FALSE(detail::takePendingBacktrack());
+
+    detail::requestBacktrack();
+    detail::resetPendingBacktrack();
+    CHECK_FALSE(detail::hasPendingBacktrack());
+    CHECK_NOTHROW(detail::raisePendingBacktrack());
+
+    detail::requestBacktrack();
+    CHECK_THROWS_AS(detail::raisePendingBacktrack(), const Backtrack&);
+    CHECK_FALSE(detail::hasPendingBacktrack());
+}
+
 TEST_CASE("unitFind") {
     // We just tests the argument forwarding here, the matching itself is
     // covered by hilti::rt::stream::View::find().
@@ -429,4 +450,61 @@ TEST_CASE("unitFind") {
     CHECK(! detail::unitFind(begin, end, s.at(4), "XYZ"_b, hilti::rt::stream::Direction::Backward));
 }
 
+TEST_CASE("SyncMatcher") {
+    auto m = detail::SyncMatcher(Vector<Bytes>({"abcdef"_b, "cd"_b, "xyz"_b}));
+
+    auto skip = [&](const std::vector<const char*>& chunks) {
+        auto s = hilti::rt::Stream();
+        for ( const auto* c : chunks ) {
+            if ( c )
+                s.append(c, strlen(c));
+            else
+                s.append(nullptr, 3);
+        }
+
+        return m.skip(s.view());
+    };
+
+    SUBCASE("no match") {
+        CHECK_EQ(skip({}), 0);
+        CHECK_EQ(skip({"0123456789"}), 10);
+    }
+
+    SUBCASE("single match") {
+        CHECK_EQ(skip({"0123xyz89"}), 4);
+        CHECK_EQ(skip({"xyz"}), 0);
+    }
+
+    SUBCASE("earliest start wins") {
+        CHECK_EQ(skip({"01abcdef"}), 2);
+        CHECK_EQ(skip({"01abcdXX"}), 4);
+        CHECK_EQ(skip({"0cd1abcdef"}), 1);
+    }
+
+    SUBCASE("across chunks") {
+        CHECK_EQ(skip({"0123x", "y", "z89"}), 4);
+        CHECK_EQ(skip({"01ab", "cdef"}), 2);
+    }
+
+    SUBCASE("partial match at end") {
+        CHECK_EQ(skip({"0123x"}), 4);
+        CHECK_EQ(skip({"01abcd"}), 2); // "abcdef" may still complete
+        CHECK_EQ(skip({"0123xy"}), 4);
+    }
+
+    SUBCASE("gaps") {
+        CHECK_EQ(skip({"012x", nullptr, "xyz"}), 3);
+        CHECK_EQ(skip({"0123", nullptr, "xyz"}), 4);
+        CHECK_EQ(skip({nullptr, "xyz"}), 0);
+    }
+
+    SUBCASE("advance") {
+        auto s = hilti::rt::Stream("0123xyz89");
+        CHECK_EQ(detail::syncAdvance(m, s.view()).begin(), s.at(4));
+
+        auto copy = m;
+        CHECK_EQ(detail::syncAdvance(copy, s.view().advance(5)).begin(), s.at(9));
+    }
+}
+
 TEST_SUITE_END();
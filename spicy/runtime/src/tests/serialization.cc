@@ -0,0 +1,150 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+
+#include <doctest/doctest.h>
+
+#include <sstream>
+#include <string>
+
+#include <hilti/rt/type-info.h>
+#include <hilti/rt/types/reference.h>
+
+#include <spicy/rt/serialization.h>
+
+using namespace spicy::rt;
+
+TEST_SUITE_BEGIN("Serialization");
+
+namespace __hlt::type_info {
+namespace {
+extern const hilti::rt::TypeInfo __ti_Test_X;
+extern const hilti::rt::TypeInfo __ti_Test_Y;
+} // namespace
+} // namespace __hlt::type_info
+
+namespace Test {
+
+// Reduced declaration of the struct types, see `hilti/runtime/src/tests/type-info.cc`.
+struct Y {
+    hilti::rt::Bool b;
+    double r;
+};
+
+struct X {
+    hilti::rt::integer::safe<int32_t> i;
+    std::string s;
+    Y y;
+};
+} // namespace Test
+
+namespace __hlt::type_info {
+namespace {
+const hilti::rt::TypeInfo __ti_Test_X =
+    {"Test::X", "Test::X",
+     new hilti::rt::type_info::Struct(std::vector<hilti::rt::type_info::struct_::Field>(
+         {hilti::rt::type_info::struct_::Field{"i", &hilti::rt::type_info::int32, offsetof(Test::X, i), false, false},
+          hilti::rt::type_info::struct_::Field{"s", &hilti::rt::type_info::string, offsetof(Test::X, s), false, false},
+          hilti::rt::type_info::struct_::Field{"y", &type_info::__ti_Test_Y, offsetof(Test::X, y), false, false}}))};
+const hilti::rt::TypeInfo __ti_Test_Y =
+    {"Test::Y", "Test::Y",
+     new hilti::rt::type_info::Struct(std::vector<hilti::rt::type_info::struct_::Field>(
+         {hilti::rt::type_info::struct_::Field{"b", &hilti::rt::type_info::bool_, offsetof(Test::Y, b), false, false},
+          hilti::rt::type_info::struct_::Field{"r", &hilti::rt::type_info::real, offsetof(Test::Y, r), false,
+                                               false}}))};
+} // namespace
+} // namespace __hlt::type_info
+
+TEST_CASE("round-trip") {
+    auto sx = hilti::rt::StrongReference<Test::X>({-42, "foo", Test::Y{true, 3.14}});
+    auto p = hilti::rt::type_info::value::Parent(sx);
+    auto v = hilti::rt::type_info::Value(&*sx, &__hlt::type_info::__ti_Test_X, p);
+
+    std::stringstream data;
+    serialization::Writer writer(data);
+    writer.write(v);
+    writer.write(v);
+
+    const auto size_one = data.str().size();
+    writer.write(v);
+    const auto size_two = data.str().size();
+
+    // The schema gets written only once.
+    CHECK_LT(size_two - size_one, size_one);
+
+    serialization::Reader reader(data);
+
+    for ( int n = 0; n < 3; n++ ) {
+        auto x = reader.read();
+        REQUIRE(x);
+
+        const auto* tx = x->type;
+        CHECK_EQ(tx->kind, serialization::Kind::Struct);
+        CHECK_EQ(tx->name, "Test::X");
+        REQUIRE_EQ(tx->fields.size(), 3);
+        CHECK_EQ(tx->fields[0].name, "i");
+        CHECK_EQ(tx->fields[0].type->kind, serialization::Kind::SignedInt);
+        CHECK_EQ(tx->fields[0].type->width, 32);
+        CHECK_EQ(tx->fields[2].type->name, "Test::Y");
+
+        const auto& fx = std::get<std::vector<serialization::Value>>(x->data);
+        REQUIRE_EQ(fx.size(), 3);
+        CHECK_EQ(std::get<int64_t>(fx[0].data), -42);
+        CHECK_EQ(std::get<std::string>(fx[1].data), "foo");
+
+        const auto& fy = std::get<std::vector<serialization::Value>>(fx[2].data);
+        REQUIRE_EQ(fy.size(), 2);
+        CHECK_EQ(std::get<bool>(fy[0].data), true);
+        CHECK_EQ(std::get<double>(fy[1].data), 3.14);
+    }
+
+    CHECK(! reader.read());
+}
+
+TEST_CASE("invalid input") {
+    SUBCASE("header") {
+        std::stringstream data("XXXX\x01");
+        CHECK_THROWS_WITH_AS(serialization::Reader{data}, "input is not in Spicy's binary serialization format",
+                             const SerializationError&);
+    }
+
+    SUBCASE("version") {
+        std::stringstream data("SPKB\xff");
+        CHECK_THROWS_WITH_AS(serialization::Reader{data}, "unsupported serialization format version 255",
+                             const SerializationError&);
+    }
+
+    SUBCASE("truncated") {
+        std::stringstream data(std::string("SPKB\x01V\x00\x05\x01", 9));
+        serialization::Reader reader(data);
+        CHECK_THROWS_WITH_AS(reader.read(), "unexpected end of input", const SerializationError&);
+    }
+
+    SUBCASE("oversized message") {
+        // Length of 2^62 bytes, which must not get allocated upfront.
+        std::stringstream data(std::string("SPKB\x01V\x00\x80\x80\x80\x80\x80\x80\x80\x80\x40", 16));
+        serialization::Reader reader(data);
+        CHECK_THROWS_WITH_AS(reader.read(), "unexpected end of input", const SerializationError&);
+    }
+
+    SUBCASE("too many elements") {
+        // A vector of 5 booleans, but with only one present.
+        std::stringstream data(std::string("SPKB\x01T\x00\x02\x0f\x01V\x00\x02\x05\x01", 15));
+        serialization::Reader reader(data);
+        CHECK_THROWS_WITH_AS(reader.read(), "invalid number of elements", const SerializationError&);
+    }
+
+    SUBCASE("too many empty elements") {
+        // A vector of 2^40 structs without fields, which encode to zero bytes each.
+        std::stringstream data(
+            std::string("SPKB\x01T\x00\x04\x0f\x0d\x00\x00V\x00\x06\x80\x80\x80\x80\x80\x20", 21));
+        serialization::Reader reader(data);
+        CHECK_THROWS_WITH_AS(reader.read(), "invalid number of elements", const SerializationError&);
+    }
+
+    SUBCASE("unknown type") {
+        std::stringstream data(std::string("SPKB\x01V\x07\x00", 8));
+        serialization::Reader reader(data);
+        CHECK_THROWS_WITH_AS(reader.read(), "value refers to unknown type 7", const SerializationError&);
+    }
+}
+
+TEST_SUITE_END();
@@ -11,6 +11,9 @@ using namespace spicy::rt;
 
 TEST_SUITE_BEGIN("Sink");
 
-TEST_CASE("to_string") { CHECK_EQ(to_string(sink::ReassemblerPolicy::First), "sink::ReassemblerPolicy::First"); }
+TEST_CASE("to_string") {
+    CHECK_EQ(to_string(sink::ReassemblerPolicy::First), "sink::ReassemblerPolicy::First");
+    CHECK_EQ(to_string(sink::ReassemblerPolicy::FirstIndexed), "sink::ReassemblerPolicy::FirstIndexed");
+}
 
 TEST_SUITE_END();
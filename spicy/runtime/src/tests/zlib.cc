@@ -34,6 +34,16 @@ TEST_CASE("decompress") {
             CHECK_EQ(zlib::finish(raw_stream), ""_b);
         }
 
+        SUBCASE("large output") {
+            // 10,000 null bytes, decompressing to more than the initial output buffer.
+            auto decompressed = zlib::decompress(stream,
+                                                 "\x78\x9c\xed\xc1\x01\x0d\x00\x00\x00\xc2\xa0\xf7\x4f\x6d\x0e"
+                                                 "\x37\xa0\x00\x00\x00\x00\x00\x00\x00\x00\x00\xe0\xdf\x00\x27"
+                                                 "\x10\x00\x01"_b);
+            CHECK_EQ(decompressed, Bytes(std::string(10000, '\0')));
+            CHECK_EQ(zlib::finish(stream), ""_b);
+        }
+
         SUBCASE("multiple blocks") {
             auto decompress = zlib::decompress(stream, "x\x01\x01\x03\x00\xfc\xff\x00\x01\x02\x00\x07\x00\x04"_b);
             decompress.append(zlib::decompress(stream, "\x00\x01\x02"_b));
@@ -2,6 +2,9 @@
 
 #include <zlib.h>
 
+#include <string>
+#include <utility>
+
 #include <hilti/rt/types/bytes.h>
 
 #include <spicy/rt/zlib_.h>
@@ -30,72 +33,51 @@ Stream::~Stream() = default;
 
 hilti::rt::Bytes Stream::finish() { return hilti::rt::Bytes(); }
 
-hilti::rt::Bytes Stream::decompress(const hilti::rt::stream::View& data) {
-    if ( ! _state )
-        throw ZlibError("error'ed zlib stream cannot be reused");
-
-    hilti::rt::Bytes decoded;
+void Stream::_decompress(const hilti::rt::stream::Byte* data, size_t len, std::string* out) {
+    _state->stream.next_in = const_cast<Bytef*>(data);
+    _state->stream.avail_in = len;
 
-    for ( auto block = data.firstBlock(); block; block = data.nextBlock(block) ) {
-        _state->stream.next_in = const_cast<Bytef*>(block->start);
-        _state->stream.avail_in = block->size;
-
-        do {
-            char buf[4096];
-            _state->stream.next_out = reinterpret_cast<unsigned char*>(buf);
-            _state->stream.avail_out = sizeof(buf);
-
-            int zip_status = inflate(&_state->stream, Z_SYNC_FLUSH);
+    while ( true ) {
+        // Decompress through a scratch buffer so that the output grows only by
+        // what zlib actually produces. Callers may adopt the output's memory
+        // as-is, so we must not leave speculative excess capacity behind.
+        Bytef buf[4096];
+        _state->stream.next_out = buf;
+        _state->stream.avail_out = sizeof(buf);
 
-            if ( zip_status != Z_STREAM_END && zip_status != Z_OK && zip_status != Z_BUF_ERROR ) {
-                _state = nullptr;
-                throw ZlibError("inflate failed");
-            }
+        int zip_status = inflate(&_state->stream, Z_SYNC_FLUSH);
 
-            if ( auto len = (sizeof(buf) - _state->stream.avail_out) )
-                decoded.append(hilti::rt::Bytes(buf, static_cast<int>(len)));
+        if ( zip_status != Z_STREAM_END && zip_status != Z_OK && zip_status != Z_BUF_ERROR ) {
+            _state = nullptr;
+            throw ZlibError("inflate failed");
+        }
 
-            if ( zip_status == Z_STREAM_END ) {
-                break;
-            }
+        out->append(reinterpret_cast<const char*>(buf), sizeof(buf) - _state->stream.avail_out);
 
-        } while ( _state->stream.avail_out == 0 );
+        if ( zip_status == Z_STREAM_END || _state->stream.avail_out != 0 )
+            break;
     }
-
-    return decoded;
 }
 
-hilti::rt::Bytes Stream::decompress(const hilti::rt::Bytes& data) {
+hilti::rt::Bytes Stream::decompress(const hilti::rt::stream::View& data) {
     if ( ! _state )
         throw ZlibError("error'ed zlib stream cannot be reused");
 
-    hilti::rt::Bytes decoded;
+    std::string decoded;
 
-    _state->stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data.data()));
-    _state->stream.avail_in = data.size();
+    for ( auto block = data.firstBlock(); block; block = data.nextBlock(block) )
+        _decompress(block->start, block->size, &decoded);
 
-    do {
-        char buf[4096];
-        _state->stream.next_out = reinterpret_cast<unsigned char*>(buf);
-        _state->stream.avail_out = sizeof(buf);
-
-        int zip_status = inflate(&_state->stream, Z_SYNC_FLUSH);
-
-        if ( zip_status != Z_STREAM_END && zip_status != Z_OK && zip_status != Z_BUF_ERROR ) {
-            _state = nullptr;
-            throw ZlibError("inflate failed");
-        }
-
-        if ( auto len = (sizeof(buf) - _state->stream.avail_out) )
-            decoded.append(hilti::rt::Bytes(buf, static_cast<int>(len)));
-
-        if ( zip_status == Z_STREAM_END ) {
-            break;
-        }
+    return hilti::rt::Bytes(std::move(decoded));
+}
 
-    } while ( _state->stream.avail_out == 0 );
+hilti::rt::Bytes Stream::decompress(const hilti::rt::Bytes& data) {
+    if ( ! _state )
+        throw ZlibError("error'ed zlib stream cannot be reused");
 
-    return decoded;
+    std::string decoded;
+    _decompress(reinterpret_cast<const hilti::rt::stream::Byte*>(data.data()), data.size(), &decoded);
+    return hilti::rt::Bytes(std::move(decoded));
 }
 
 uint64_t zlib::crc32_init() { return ::crc32(0L, Z_NULL, 0); }
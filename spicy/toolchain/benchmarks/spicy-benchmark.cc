@@ -0,0 +1,573 @@
+// Copyright (c) 2020-2023 by the Zeek Project. See LICENSE for details.
+//
+// End-to-end parsing benchmark running precompiled parsers on deterministic,
+// synthetic inputs. Each scenario executes in a child process of its own so
+// that its peak memory usage can be reported separately. Results go to
+// stdout as JSON.
+
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <hilti/rt/libhilti.h>
+
+#include <spicy/rt/libspicy.h>
+
+using hilti::rt::fmt;
+
+// Allocation tracking through replacements of the global allocation
+// functions. The remaining variants forward to these by default.
+
+static std::atomic<uint64_t> allocations = 0;
+static std::atomic<uint64_t> allocated_bytes = 0;
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if ( auto* p = std::malloc(size ? size : 1) )
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    auto align = static_cast<size_t>(alignment);
+    if ( auto* p = std::aligned_alloc(align, (std::max(size, size_t(1)) + align - 1) / align * align) )
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t /* alignment */) noexcept { std::free(p); }
+
+namespace {
+
+/**
+ * Source of deterministic pseudo-random values. We stick to the raw output
+ * of the engine, which is fully specified by the standard, rather than
+ * distributions, which aren't.
+ */
+class Random {
+public:
+    explicit Random(uint64_t seed) : _rng(seed) {}
+
+    /** Returns a value in `[min, max]`. */
+    uint64_t range(uint64_t min, uint64_t max) { return min + _rng() % (max - min + 1); }
+
+    /** Returns a random element of a non-empty list. */
+    template<typename T>
+    const T& pick(const std::vector<T>& xs) {
+        return xs[range(0, xs.size() - 1)];
+    }
+
+    /** Returns a string of given length made up of characters from an alphabet. */
+    std::string text(size_t len, const std::string& alphabet = "abcdefghijklmnopqrstuvwxyz0123456789") {
+        std::string s;
+        s.reserve(len);
+
+        for ( size_t i = 0; i < len; i++ )
+            s += alphabet[range(0, alphabet.size() - 1)];
+
+        return s;
+    }
+
+    /** Returns a string of given length made up of arbitrary bytes. */
+    std::string binary(size_t len) {
+        std::string s;
+        s.reserve(len);
+
+        for ( size_t i = 0; i < len; i++ )
+            s += static_cast<char>(_rng() & 0xff);
+
+        return s;
+    }
+
+private:
+    std::mt19937_64 _rng;
+};
+
+void appendUInt(std::string* out, uint64_t x, int width) {
+    for ( int i = width - 1; i >= 0; i-- )
+        *out += static_cast<char>((x >> (i * 8)) & 0xff);
+}
+
+// Input generators. Each appends one top-level element of its format to
+// `out`, matching the corresponding grammar in this directory.
+
+void generateHTTP(Random& r, std::string* out) {
+    static const std::vector<std::string> methods = {"GET", "GET", "GET", "HEAD", "POST"};
+    static const std::vector<std::string> agents = {"Mozilla/5.0 (X11; Linux x86_64)", "curl/7.88.1",
+                                                    "Wget/1.21.3"};
+
+    const auto& method = r.pick(methods);
+    auto dir = r.text(r.range(1, 16));
+    auto file = r.text(r.range(1, 12));
+    auto id = r.range(0, 1000000);
+
+    *out += fmt("%s /%s/%s.html?id=%d HTTP/1.1\r\n", method, dir, file, id);
+    *out += fmt("Host: www.%s.com\r\n", r.text(r.range(4, 12)));
+    *out += fmt("User-Agent: %s\r\n", r.pick(agents));
+    *out += "Accept: */*\r\n";
+
+    for ( auto i = r.range(0, 6); i > 0; i-- ) {
+        auto name = r.text(r.range(4, 10));
+        auto value = r.text(r.range(8, 64));
+        *out += fmt("X-%s: %s\r\n", name, value);
+    }
+
+    std::string body;
+    if ( method == "POST" ) {
+        body = r.text(r.range(0, 2048));
+        *out += fmt("Content-Length: %d\r\n", body.size());
+    }
+
+    *out += "\r\n";
+    *out += body;
+}
+
+void generateDNS(Random& r, std::string* out) {
+    auto name = [&]() {
+        std::string n;
+
+        for ( auto i = r.range(2, 4); i > 0; i-- ) {
+            auto label = r.text(r.range(1, 16));
+            n += static_cast<char>(label.size());
+            n += label;
+        }
+
+        n += '\0';
+        return n;
+    };
+
+    auto qdcount = 1;
+    auto ancount = r.range(0, 8);
+    auto nscount = r.range(0, 2);
+    auto arcount = r.range(0, 2);
+
+    std::string msg;
+    appendUInt(&msg, r.range(0, 0xffff), 2); // id
+    appendUInt(&msg, 0x8180, 2);             // flags
+    appendUInt(&msg, qdcount, 2);
+    appendUInt(&msg, ancount, 2);
+    appendUInt(&msg, nscount, 2);
+    appendUInt(&msg, arcount, 2);
+
+    msg += name();
+    appendUInt(&msg, 1, 2); // qtype
+    appendUInt(&msg, 1, 2); // qclass
+
+    for ( auto i = ancount + nscount + arcount; i > 0; i-- ) {
+        auto rdata = r.binary(r.pick(std::vector<size_t>{4, 4, 16, 32}));
+        msg += name();
+        appendUInt(&msg, 1, 2);                  // rtype
+        appendUInt(&msg, 1, 2);                  // rclass
+        appendUInt(&msg, r.range(0, 86400), 4); // ttl
+        appendUInt(&msg, rdata.size(), 2);
+        msg += rdata;
+    }
+
+    appendUInt(out, msg.size(), 2);
+    *out += msg;
+}
+
+void generateTLS(Random& r, std::string* out) {
+    std::string payload;
+    uint64_t content_type = 0;
+
+    switch ( r.range(0, 9) ) {
+        case 0:
+        case 1: {
+            content_type = 22; // handshake
+
+            for ( auto i = r.range(1, 4); i > 0; i-- ) {
+                auto body = r.binary(r.range(32, 512));
+                appendUInt(&payload, r.range(1, 20), 1);
+                appendUInt(&payload, body.size(), 3);
+                payload += body;
+            }
+
+            break;
+        }
+
+        case 2:
+            content_type = 21; // alert
+            payload = r.binary(2);
+            break;
+
+        case 3:
+            content_type = 20; // change cipher spec
+            payload = r.binary(1);
+            break;
+
+        default:
+            content_type = 23; // application data
+            payload = r.binary(r.range(64, 16384));
+            break;
+    }
+
+    appendUInt(out, content_type, 1);
+    appendUInt(out, 0x0303, 2);
+    appendUInt(out, payload.size(), 2);
+    *out += payload;
+}
+
+void generateNested(Random& r, std::string* out, int level = 1) {
+    appendUInt(out, r.range(0, 0xffff), 2);
+
+    auto n = r.range(1, 3);
+    appendUInt(out, n, 1);
+
+    for ( auto i = n; i > 0; i-- ) {
+        if ( level < 6 )
+            generateNested(r, out, level + 1);
+        else {
+            auto data = r.binary(r.range(0, 16));
+            appendUInt(out, r.range(0, 0xff), 1);
+            appendUInt(out, data.size(), 1);
+            *out += data;
+        }
+    }
+}
+
+void generateTokens(Random& r, std::string* out) {
+    static const std::vector<std::string> levels = {"DEBUG", "INFO", "INFO", "WARN", "ERROR"};
+
+    // Each value gets drawn separately to keep the order of draws well-defined.
+    *out += fmt("2023-%02d", r.range(1, 12));
+    *out += fmt("-%02d", r.range(1, 28));
+    *out += fmt("T%02d", r.range(0, 23));
+    *out += fmt(":%02d", r.range(0, 59));
+    *out += fmt(":%02dZ", r.range(0, 59));
+    *out += fmt(" %s ", r.pick(levels));
+    *out += fmt("%d", r.range(1, 254));
+    *out += fmt(".%d", r.range(0, 255));
+    *out += fmt(".%d", r.range(0, 255));
+    *out += fmt(".%d", r.range(1, 254));
+
+    for ( auto i = r.range(1, 12); i > 0; i-- ) {
+        switch ( r.range(0, 3) ) {
+            case 0: {
+                auto key = r.text(r.range(2, 8));
+                *out += fmt(" %s=%d", key, r.range(0, 100000));
+                break;
+            }
+
+            case 1: {
+                auto dir = r.text(r.range(2, 8));
+                *out += fmt(" /%s/%s", dir, r.text(r.range(2, 12)));
+                break;
+            }
+
+            default: *out += " " + r.text(r.range(1, 12), "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"); break;
+        }
+    }
+
+    *out += "\n";
+}
+
+struct Scenario {
+    std::string name;
+    std::string parser;
+    uint64_t seed;
+    void (*generate)(Random& r, std::string* out);
+};
+
+const std::vector<Scenario> scenarios = {
+    {"http", "HTTP::Requests", 1, generateHTTP},
+    {"dns", "DNS::Messages", 2, generateDNS},
+    {"tls", "TLS::Records", 3, generateTLS},
+    {"nested", "Nested::Document", 4, [](Random& r, std::string* out) { generateNested(r, out); }},
+    {"tokens", "Tokens::Lines", 5, generateTokens},
+};
+
+/** How inputs get passed to parsers. */
+enum class Mode {
+    Stream, /**< incrementally in chunks through the driver, with parsers suspending until more input arrives */
+    Fiber,  /**< all at once as a frozen stream, with parsers executing inside a fiber */
+    Direct, /**< all at once as a frozen stream, with parsers executing directly on the caller's stack */
+};
+
+const std::vector<std::pair<std::string, Mode>> modes = {{"stream", Mode::Stream},
+                                                         {"fiber", Mode::Fiber},
+                                                         {"direct", Mode::Direct}};
+
+struct Options {
+    std::vector<std::string> scenarios;
+    uint64_t input_size = 8 * 1024 * 1024;
+    unsigned int iterations = 5;
+    Mode mode = Mode::Stream;
+    std::string mode_name = "stream";
+};
+
+std::string escapeJSON(const std::string& s) {
+    std::string x;
+
+    for ( auto c : s ) {
+        switch ( c ) {
+            case '"': x += "\\\""; break;
+            case '\\': x += "\\\\"; break;
+            case '\n': x += "\\n"; break;
+            default:
+                if ( static_cast<unsigned char>(c) < 0x20 )
+                    x += fmt("\\u%04x", static_cast<int>(c));
+                else
+                    x += c;
+        }
+    }
+
+    return x;
+}
+
+uint64_t peakRSS() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024; // bytes
+#else
+    return ru.ru_maxrss; // kilobytes
+#endif
+}
+
+// Runs a single scenario, returning its result as a JSON object.
+std::string run(const Scenario& scenario, const Options& options) {
+    Random r(scenario.seed);
+
+    std::string input;
+    input.reserve(options.input_size + 65536);
+
+    while ( input.size() < options.input_size )
+        scenario.generate(r, &input);
+
+    auto config = hilti::rt::configuration::get();
+    config.fiber_bypass_on_frozen_input = (options.mode == Mode::Direct);
+    hilti::rt::configuration::set(config);
+
+    hilti::rt::init();
+    spicy::rt::init();
+
+    std::string result =
+        fmt(R"("name": "%s", "parser": "%s", "mode": "%s", "input_bytes": %d, "iterations": %u)", scenario.name,
+            scenario.parser, options.mode_name, input.size(), options.iterations);
+
+    try {
+        spicy::rt::Driver driver;
+
+        auto parser = driver.lookupParser(scenario.parser);
+        if ( ! parser )
+            throw std::runtime_error(parser.error().description());
+
+        std::vector<double> seconds;
+        uint64_t total_allocations = 0;
+        uint64_t total_allocated_bytes = 0;
+
+        if ( options.mode != Mode::Stream && ! (*parser)->parse3 )
+            throw std::runtime_error("parser cannot be used as external entry point");
+
+        for ( unsigned int i = 0; i < options.iterations; i++ ) {
+            std::istringstream in(input);
+
+            // Parsing consumes the stream, so we set up a new one each time.
+            auto data = hilti::rt::reference::make_value<hilti::rt::Stream>();
+            if ( options.mode != Mode::Stream ) {
+                data->append(input.data(), input.size());
+                data->freeze();
+            }
+
+            auto allocations_before = allocations.load();
+            auto allocated_bytes_before = allocated_bytes.load();
+            auto start = std::chrono::steady_clock::now();
+
+            if ( options.mode == Mode::Stream ) {
+                // A failed parse would otherwise report a fast, but wrong, throughput.
+                if ( auto rc = driver.processInput(**parser, in); ! rc )
+                    throw std::runtime_error(rc.error().description());
+            }
+            else {
+                hilti::rt::ValueReference<spicy::rt::ParsedUnit> unit;
+                if ( ! (*parser)->parse3(unit, data, {}, {}) )
+                    throw std::runtime_error("parsing yielded on frozen input");
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            total_allocations += allocations.load() - allocations_before;
+            total_allocated_bytes += allocated_bytes.load() - allocated_bytes_before;
+            seconds.push_back(std::chrono::duration<double>(end - start).count());
+        }
+
+        std::sort(seconds.begin(), seconds.end());
+        auto median = seconds[seconds.size() / 2];
+
+        result += fmt(R"(, "seconds_min": %.6f, "seconds_median": %.6f, "mb_per_sec": %.2f)", seconds.front(), median,
+                      static_cast<double>(input.size()) / 1e6 / median);
+        result += fmt(R"(, "allocations": %d, "allocated_bytes": %d)",
+                      total_allocations / options.iterations, total_allocated_bytes / options.iterations);
+    } catch ( const std::exception& e ) {
+        result += fmt(R"(, "error": "%s")", escapeJSON(e.what()));
+    }
+
+    spicy::rt::done();
+    hilti::rt::done();
+
+    result += fmt(R"(, "peak_rss_kb": %d)", peakRSS());
+    return "{" + result + "}";
+}
+
+// Runs a scenario inside a child process, returning its result.
+std::string runInChild(const Scenario& scenario, const Options& options) {
+    int fds[2];
+    if ( pipe(fds) < 0 )
+        hilti::rt::fatalError("cannot create pipe");
+
+    auto pid = fork();
+    if ( pid < 0 )
+        hilti::rt::fatalError("cannot fork");
+
+    if ( pid == 0 ) {
+        close(fds[0]);
+
+        auto result = run(scenario, options);
+        for ( size_t written = 0; written < result.size(); ) {
+            auto n = write(fds[1], result.data() + written, result.size() - written);
+            if ( n < 0 )
+                _exit(1);
+
+            written += n;
+        }
+
+        close(fds[1]);
+        _exit(0);
+    }
+
+    close(fds[1]);
+
+    std::string result;
+    char buffer[4096];
+    ssize_t n;
+    while ( (n = read(fds[0], buffer, sizeof(buffer))) > 0 )
+        result.append(buffer, n);
+
+    close(fds[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    if ( ! WIFEXITED(status) || WEXITSTATUS(status) != 0 || result.empty() )
+        return fmt(R"({"name": "%s", "parser": "%s", "error": "benchmark process terminated abnormally"})",
+                   scenario.name, scenario.parser);
+
+    return result;
+}
+
+void usage(const std::string& prog) {
+    std::cerr << "Usage: " << prog
+              << " [options]\n"
+                 "\n"
+                 "Options:\n"
+                 "\n"
+                 "  -h | --help                     Show usage information.\n"
+                 "  -l | --list-scenarios           List available scenarios and exit.\n"
+                 "  -m | --mode <mode>              How to pass input to parsers: 'stream' (default) feeds it in\n"
+                 "                                  chunks; 'fiber' and 'direct' pass it all at once, with parsers\n"
+                 "                                  running inside a fiber or on the caller's stack, respectively.\n"
+                 "  -n | --iterations <n>           Parse each input <n> times; default is 5.\n"
+                 "  -s | --scenario <name>          Run only scenario <name>; can be given multiple times.\n"
+                 "  -S | --input-size <bytes>       Generate inputs of about <bytes> size; default is 8MB.\n"
+                 "\n";
+}
+
+const struct option long_options[] = {{"help", no_argument, nullptr, 'h'},
+                                      {"iterations", required_argument, nullptr, 'n'},
+                                      {"input-size", required_argument, nullptr, 'S'},
+                                      {"list-scenarios", no_argument, nullptr, 'l'},
+                                      {"mode", required_argument, nullptr, 'm'},
+                                      {"scenario", required_argument, nullptr, 's'},
+                                      {nullptr, 0, nullptr, 0}};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto prog = hilti::rt::filesystem::path(argv[0]).filename().native();
+    Options options;
+
+    while ( true ) {
+        int c = getopt_long(argc, argv, "hlm:n:s:S:", long_options, nullptr);
+
+        if ( c < 0 )
+            break;
+
+        switch ( c ) {
+            case 'l':
+                for ( const auto& s : scenarios )
+                    std::cout << s.name << " (" << s.parser << ")" << std::endl;
+
+                return 0;
+
+            case 'm': {
+                auto m = std::find_if(modes.begin(), modes.end(), [&](const auto& m) { return m.first == optarg; });
+                if ( m == modes.end() ) {
+                    std::cerr << "[error] " << prog << ": unknown mode '" << optarg << "'" << std::endl;
+                    return 1;
+                }
+
+                options.mode_name = m->first;
+                options.mode = m->second;
+                break;
+            }
+
+            case 'n': options.iterations = std::max(1, atoi(optarg)); /* NOLINT */ break;
+            case 's': options.scenarios.emplace_back(optarg); break;
+            case 'S': options.input_size = strtoull(optarg, nullptr, 10); break;
+            case 'h': usage(prog); return 0;
+            default: usage(prog); return 1;
+        }
+    }
+
+    if ( optind != argc ) {
+        usage(prog);
+        return 1;
+    }
+
+    for ( const auto& name : options.scenarios ) {
+        if ( std::none_of(scenarios.begin(), scenarios.end(), [&](const auto& s) { return s.name == name; }) ) {
+            std::cerr << "[error] " << prog << ": unknown scenario '" << name << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> results;
+
+    for ( const auto& s : scenarios ) {
+        if ( options.scenarios.empty() ||
+             std::find(options.scenarios.begin(), options.scenarios.end(), s.name) != options.scenarios.end() )
+            results.emplace_back(runInChild(s, options));
+    }
+
+    std::cout << "{\n  \"scenarios\": [\n";
+
+    for ( size_t i = 0; i < results.size(); i++ )
+        std::cout << "    " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+
+    std::cout << "  ]\n}" << std::endl;
+    return 0;
+}
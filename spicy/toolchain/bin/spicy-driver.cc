@@ -17,6 +17,10 @@
 
 using spicy::rt::fmt;
 
+constexpr int OPT_PROFILING_STACKS = 1000;
+constexpr int OPT_JIT_CACHE = 1001;
+constexpr int OPT_PARSE_ARENA = 1002;
+
 static struct option long_driver_options[] = {{"abort-on-exceptions", required_argument, nullptr, 'A'},
                                               {"require-accept", no_argument, nullptr, 'c'},
                                               {"compiler-debug", required_argument, nullptr, 'D'},
@@ -27,13 +31,17 @@ static struct option long_driver_options[] = {{"abort-on-exceptions", required_a
                                               {"batch-file", required_argument, nullptr, 'F'},
                                               {"help", no_argument, nullptr, 'h'},
                                               {"increment", required_argument, nullptr, 'i'},
+                                              {"jit-cache", required_argument, nullptr, OPT_JIT_CACHE},
                                               {"library-path", required_argument, nullptr, 'L'},
                                               {"list-parsers", no_argument, nullptr, 'l'},
+                                              {"parse-arena", required_argument, nullptr, OPT_PARSE_ARENA},
                                               {"parser", required_argument, nullptr, 'p'},
+                                              {"profiling-stacks", required_argument, nullptr, OPT_PROFILING_STACKS},
                                               {"report-times", required_argument, nullptr, 'R'},
                                               {"show-backtraces", required_argument, nullptr, 'B'},
                                               {"skip-dependencies", no_argument, nullptr, 'S'},
                                               {"report-resource-usage", no_argument, nullptr, 'U'},
+                                              {"threads", required_argument, nullptr, 'T'},
                                               {"version", no_argument, nullptr, 'v'},
                                               {nullptr, 0, nullptr, 0}};
 
@@ -56,6 +64,7 @@ public:
 
     bool opt_list_parsers = false;
     int opt_increment = 0;
+    unsigned int opt_threads = 1;
     bool opt_input_is_batch = false;
     std::string opt_file = "/dev/stdin";
     std::string opt_parser;
@@ -109,9 +118,14 @@ void SpicyDriver::usage() {
            "  -L | --library-path <path>      Add path to list of directories to search when importing modules.\n"
            "  -R | --report-times             Report a break-down of compiler's execution time.\n"
            "  -S | --skip-dependencies        Do not automatically compile dependencies during JIT.\n"
+           "  -T | --threads <n>              Distribute flows of batch input across <n> threads (requires -F).\n"
            "  -U | --report-resource-usage    Print summary of runtime resource usage.\n"
            "  -X | --debug-addl <addl>        Implies -d and adds selected additional instrumentation\n"
            "  -Z | --enable-profiling         Report profiling statistics after execution.\n"
+           "       --jit-cache <dir>          Reuse compiled code across runs by caching it in <dir>.\n"
+           "       --parse-arena <bytes>      Allocate each parsed unit from its own arena of up to <bytes>.\n"
+           "       --profiling-stacks <file>  Implies -Z and writes profiled call paths to <file> in the folded stack "
+           "format used by flamegraph tools.\n"
            "(comma-separated; see 'help' for list).\n"
            "\n"
            "Environment variables:\n"
@@ -134,7 +148,7 @@ void SpicyDriver::parseOptions(int argc, char** argv) {
     driver_options.logger = std::make_unique<hilti::Logger>();
 
     while ( true ) {
-        int c = getopt_long(argc, argv, "ABcD:f:F:hdJX:Vlp:i:SRL:UZ", long_driver_options, nullptr);
+        int c = getopt_long(argc, argv, "ABcD:f:F:hdJX:Vlp:i:SRL:T:UZ", long_driver_options, nullptr);
 
         if ( c < 0 )
             break;
@@ -223,6 +237,15 @@ void SpicyDriver::parseOptions(int argc, char** argv) {
 
             case 'S': driver_options.skip_dependencies = true; break;
 
+            case 'T': {
+                auto n = atoi(optarg); // NOLINT
+                if ( n < 1 )
+                    fatalError("number of threads must be at least 1");
+
+                opt_threads = static_cast<unsigned int>(n);
+                break;
+            }
+
             case 'U': driver_options.report_resource_usage = true; break;
 
             case 'v': std::cerr << "spicy-driver v" << hilti::configuration().version_string_long << std::endl; exit(0);
@@ -234,12 +257,42 @@ void SpicyDriver::parseOptions(int argc, char** argv) {
                 driver_options.enable_profiling = true;
                 break;
 
+            case OPT_JIT_CACHE: compiler_options.jit_cache = optarg; break;
+
+            case OPT_PARSE_ARENA: {
+                auto n = atoll(optarg); // NOLINT
+                if ( n < 0 )
+                    fatalError("arena size must not be negative");
+
+                auto config = spicy::rt::configuration::get();
+                config.parse_arena_size = static_cast<size_t>(n);
+                spicy::rt::configuration::set(std::move(config));
+                break;
+            }
+
+            case OPT_PROFILING_STACKS:
+                compiler_options.enable_profiling = true;
+                driver_options.enable_profiling = true;
+                driver_options.profiling_stacks = optarg;
+                break;
+
             case 'h': usage(); exit(0);
             case '?': usage(); exit(1); // getopt reports error
             default: usage(); fatalError(fmt("option %c not supported", c));
         }
     }
 
+    if ( opt_threads > 1 ) {
+        if ( ! opt_input_is_batch )
+            fatalError("--threads requires batch input through -F");
+
+        if ( compiler_options.enable_profiling )
+            fatalError("--threads cannot be combined with profiling");
+
+        // Each thread needs its own copy of the globals.
+        compiler_options.cxx_enable_dynamic_globals = true;
+    }
+
     setCompilerOptions(compiler_options);
     setDriverOptions(std::move(driver_options));
 
@@ -274,24 +327,23 @@ int main(int argc, char** argv) {
         if ( driver.opt_list_parsers )
             driver.listParsers(std::cout);
 
+        else if ( driver.opt_input_is_batch ) {
+            if ( auto x = driver.processPreBatchedInput(driver.opt_file, driver.opt_threads); ! x )
+                driver.fatalError(x.error());
+        }
+
         else {
             std::ifstream in(driver.opt_file, std::ios::in | std::ios::binary);
 
             if ( ! in.is_open() )
                 driver.fatalError("cannot open input for reading");
 
-            if ( driver.opt_input_is_batch ) {
-                if ( auto x = driver.processPreBatchedInput(in); ! x )
-                    driver.fatalError(x.error());
-            }
-            else {
-                auto parser = driver.lookupParser(driver.opt_parser);
-                if ( ! parser )
-                    driver.fatalError(parser.error());
+            auto parser = driver.lookupParser(driver.opt_parser);
+            if ( ! parser )
+                driver.fatalError(parser.error());
 
-                if ( auto x = driver.processInput(**parser, in, driver.opt_increment); ! x )
-                    driver.fatalError(x.error());
-            }
+            if ( auto x = driver.processInput(**parser, in, driver.opt_increment); ! x )
+                driver.fatalError(x.error());
         }
 
         driver.finishRuntime();
@@ -23,6 +23,7 @@
 using spicy::rt::fmt;
 
 static struct option long_options[] = {{"abort-on-exceptions", required_argument, nullptr, 'A'},
+                                       {"binary", no_argument, nullptr, 'b'},
                                        {"compiler-debug", required_argument, nullptr, 'D'},
                                        {"debug", no_argument, nullptr, 'd'},
                                        {"debug-addl", required_argument, nullptr, 'X'},
@@ -55,6 +56,7 @@ public:
     void parseOptions(int argc, char** argv);
     void usage();
 
+    bool opt_binary = false;
     bool opt_json = false;
     bool opt_list_parsers = false;
     bool opt_enable_print = false;
@@ -75,6 +77,7 @@ void SpicyDump::usage() {
            "\n"
            "Options:\n"
            "\n"
+           "  -b | --binary                   Print output in Spicy's compact binary serialization format.\n"
            "  -d | --debug                    Include debug instrumentation into generated code.\n"
            "  -f | --file <path>              Read input from <path> instead of stdin.\n"
            "  -l | --list-parsers             List available parsers and exit.\n"
@@ -117,7 +120,7 @@ void SpicyDump::parseOptions(int argc, char** argv) {
     driver_options.logger = std::make_unique<hilti::Logger>();
 
     while ( true ) {
-        int c = getopt_long(argc, argv, "ABD:f:hdX:QVlp:PSRL:J", long_options, nullptr);
+        int c = getopt_long(argc, argv, "AbBD:f:hdX:QVlp:PSRL:J", long_options, nullptr);
 
         if ( c < 0 )
             break;
@@ -178,6 +181,8 @@ void SpicyDump::parseOptions(int argc, char** argv) {
                 break;
             }
 
+            case 'b': opt_binary = true; break;
+
             case 'J': opt_json = true; break;
 
             case 'Q':
@@ -260,7 +265,9 @@ int main(int argc, char** argv) {
             if ( ! unit )
                 fatalError(unit.error());
 
-            if ( driver.opt_json )
+            if ( driver.opt_binary )
+                spicy::rt::serialization::Writer(std::cout).write(unit->value());
+            else if ( driver.opt_json )
                 JSONPrinter(std::cout, driver.output_options).print(unit->value());
             else {
                 TextPrinter(std::cout, driver.output_options).print(unit->value());
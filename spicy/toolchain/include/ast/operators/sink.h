@@ -193,9 +193,11 @@ BEGIN_METHOD(sink, SetPolicy)
                                         .doc = R"(
 Sets a sink's reassembly policy for ambiguous input. As long as data hasn't
 been trimmed, a sink will detect overlapping chunks. This policy decides how to
-handle ambiguous overlaps. The default (and currently only) policy is
-``ReassemblerPolicy::First``, which resolves ambiguities by taking the data
-from the chunk that came first.
+handle ambiguous overlaps. The default policy is ``ReassemblerPolicy::First``,
+which resolves ambiguities by taking the data from the chunk that came first.
+``ReassemblerPolicy::FirstIndexed`` resolves ambiguities the same way, but
+maintains an index over buffered data that speeds up reassembly of heavily
+out-of-order input.
 )"};
         return _signature;
     }
@@ -5,6 +5,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -63,6 +64,21 @@ constexpr hilti::util::enum_::Value<LiteralMode> literal_modes[] = {{LiteralMode
 
 constexpr auto to_string(LiteralMode cc) { return hilti::util::enum_::to_string(cc, detail::literal_modes); }
 
+/**
+ * Determines how generated code leaves its current scope when it finds a
+ * backtrack operation pending. Only relevant with status-based backtracking.
+ */
+enum class BacktrackExit {
+    /** Turn the pending backtrack into a `Backtrack` exception. */
+    Raise,
+
+    /** Return from the current parse function, leaving it to the caller to continue unwinding. */
+    Return,
+
+    /** Break out of the loop wrapping the scope of the current `&try`. */
+    Break,
+};
+
 namespace look_ahead {
 
 /** Type for storing a look-ahead ID. */
@@ -163,6 +179,9 @@ struct ParserState {
      * Expression holding the last parse error if any. This field is set only in sync or trial mode.
      */
     Expression error;
+
+    /** How to leave the current scope if a backtrack operation is pending. */
+    BacktrackExit backtrack_exit = BacktrackExit::Raise;
 };
 
 /** Generates the parsing logic for a unit type. */
@@ -465,8 +484,11 @@ public:
      *
      * @param success true if parsing was successful, false if an error occurred.
      * @param l location to associate with the generated code
+     * @param error if not successful, string expression describing the error
+     * for the `%error` hook; defaults to the message of the exception
+     * currently being handled
      */
-    void finalizeUnit(bool success, const Location& l);
+    void finalizeUnit(bool success, const Location& l, const std::optional<Expression>& error = {});
 
     /** Prepare for backtracking via ``&try``. */
     void initBacktracking();
@@ -474,6 +496,19 @@ public:
     /** Clean up after potential backtracking via ``&try``. */
     void finishBacktracking();
 
+    /**
+     * Returns true if generated parsers propagate backtracking through
+     * return values instead of exceptions.
+     */
+    bool statusBacktracking() const;
+
+    /**
+     * Generates code that leaves the current scope if a backtrack operation
+     * is pending, as determined by the parsing state's `backtrack_exit`.
+     * This is a no-op unless status-based backtracking is enabled.
+     */
+    void checkBacktrack();
+
     /**
      * Prepare for parsing the body of a loop of "something". Must be followed
      * by calling `finishLoopBody()` once parsing is done.
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <hilti/compiler/driver.h>
 
@@ -13,7 +14,8 @@ namespace spicy {
  * Compiler options for the Spicy code generator.
  */
 struct Options {
-    bool track_offsets = false; /**< true to have the generated code record fields' offsets */
+    bool track_offsets = false;       /**< true to have the generated code record fields' offsets */
+    bool status_backtracking = false; /**< true to have the generated code backtrack without exceptions */
 };
 
 /**
@@ -62,6 +64,7 @@ public:
 
 protected:
     std::string hookAddCommandLineOptions() override;
+    std::vector<std::pair<std::string, int>> hookAddLongCommandLineOptions() override;
     bool hookProcessCommandLineOption(int opt, const char* optarg) override;
     std::string hookAugmentUsage() override;
 
@@ -374,6 +374,24 @@ struct VisitorPass2 : public hilti::visitor::PreOrder<void, VisitorPass2> {
         replaceNode(&p, hilti::statement::Expression(call, p.node.location()));
     }
 
+    void operator()(const hilti::statement::Expression& n, position_t p) {
+        if ( ! n.expression().isA<operator_::unit::Backtrack>() ||
+             ! cg->options().getAuxOption<bool>("spicy.status_backtracking", false) )
+            return;
+
+        auto f = p.findParent<hilti::Function>();
+        if ( ! f || f->get().ftype().flavor() != hilti::type::function::Flavor::Hook ||
+             ! f->get().ftype().result().type().isA<hilti::type::Void>() )
+            return;
+
+        // Inside a hook, record the request and leave the hook. The parser
+        // checks for pending requests once the hook returns.
+        auto b = builder::Builder(cg->context());
+        b.addCall("spicy_rt::backtrack_request", {}, n.meta());
+        b.addReturn(n.meta());
+        replaceNode(&p, b.block());
+    }
+
     void operator()(const statement::Stop& n, position_t p) {
         auto b = builder::Builder(cg->context());
         b.addAssign(builder::id("__stop"), builder::bool_(true), n.meta());
@@ -524,6 +542,14 @@ std::optional<hilti::declaration::Function> CodeGen::compileHook(
     if ( ! id.namespace_().empty() )
         hid = fmt("%s::%s", id.namespace_(), hid);
 
+    if ( body && result.isA<hilti::type::Void>() && options().getAuxOption<bool>("spicy.status_backtracking", false) ) {
+        // Skip any further implementations of the hook once one has requested
+        // to backtrack.
+        auto guard = builder::Builder(context());
+        guard.addIf(builder::call("spicy_rt::backtrack_pending", {}))->addReturn();
+        body = hilti::statement::Block({guard.block(), *body}, meta);
+    }
+
     auto rt = hilti::type::function::Result(std::move(result));
     auto ft = hilti::type::Function(std::move(rt), params, hilti::type::function::Flavor::Hook, meta);
 
@@ -84,6 +84,24 @@ struct ProductionVisitor
     void pushState(ParserState p) { pb->pushState(std::move(p)); }
     auto popState() { return pb->popState(); }
 
+    // Pushes a copy of the current state that turns pending backtracking
+    // requests back into exceptions. We use that for code recovering from
+    // parse errors through `&synchronize`, so that it sees backtracking the
+    // same way as without status-based backtracking.
+    void pushStateRaisingBacktrack() {
+        auto pstate = state();
+        pstate.backtrack_exit = BacktrackExit::Raise;
+        pushState(std::move(pstate));
+    }
+
+    // Leaving a loop for a pending backtrack through `break` ends only the
+    // loop itself; call this after every loop that may run a hook to
+    // continue unwinding.
+    void checkBacktrackAfterLoop() {
+        if ( state().backtrack_exit == BacktrackExit::Break )
+            pb->checkBacktrack();
+    }
+
     auto builder() { return pb->builder(); }
     auto pushBuilder(std::shared_ptr<builder::Builder> b) { return pb->pushBuilder(std::move(b)); }
     auto pushBuilder() { return pb->pushBuilder(); }
@@ -233,7 +251,18 @@ struct ProductionVisitor
                         try_->addCatch({builder::parameter("__except", builder::typeByID("hilti::SystemException"))});
 
                     pushBuilder(catch_, [&]() {
+                        if ( pb->statusBacktracking() )
+                            // Any earlier request is moot now.
+                            builder()->addCall("spicy_rt::backtrack_reset", {});
+
                         pb->finalizeUnit(false, p.location());
+
+                        if ( pb->statusBacktracking() )
+                            // The `%error` hook may have requested to
+                            // backtrack, which replaces the error just like
+                            // a `Backtrack` exception thrown by the hook would.
+                            builder()->addCall("spicy_rt::backtrack_raise", {});
+
                         run_finally();
                         builder()->addRethrow();
                     });
@@ -285,6 +314,7 @@ struct ProductionVisitor
                     pstate.lahead = builder::id("__lah");
                     pstate.lahead_end = builder::id("__lahe");
                     pstate.error = builder::id("__error");
+                    pstate.backtrack_exit = BacktrackExit::Return;
 
                     std::optional<PathTracker> path_tracker;
                     if ( unit->id() ) {
@@ -305,6 +335,14 @@ struct ProductionVisitor
                     if ( unit )
                         pstate.unit = *unit;
 
+                    if ( pb->statusBacktracking() ) {
+                        // Wrap the unit's parsing into a loop that we can
+                        // leave once a backtrack is pending, so that we can
+                        // then clean up like the exception handler would.
+                        pushBuilder(builder()->addWhile(builder::bool_(true)));
+                        pstate.backtrack_exit = BacktrackExit::Break;
+                    }
+
                     pushState(std::move(pstate));
 
                     // Disable trimming for random-access units.
@@ -339,6 +377,7 @@ struct ProductionVisitor
                             args2[1] = builder::optional(type::stream::Iterator());
                             args2[2] = builder::deref(args2[0]);
                             builder()->addExpression(builder::memberCall(state().self, id_stage2, args2));
+                            pb->checkBacktrack();
 
                             // Assume the filter consumed the full input.
                             pb->advanceInput(builder::size(state().cur));
@@ -356,8 +395,35 @@ struct ProductionVisitor
                     builder()->addAssign(store_result, builder::memberCall(state().self, id_stage2, args));
                     popBuilder();
 
+                    if ( pb->statusBacktracking() ) {
+                        builder()->addBreak();
+                        popBuilder();
+
+                        auto pstate = state();
+                        pstate.backtrack_exit = BacktrackExit::Return;
+                        pushState(std::move(pstate));
+                    }
+
                     end_try(try_);
+
+                    if ( pb->statusBacktracking() ) {
+                        // Abort the unit for a pending backtrack the way we
+                        // do for a `Backtrack` exception, then pass it on.
+                        auto pending = builder::call("spicy_rt::backtrack_take", {});
+                        pushBuilder(builder()->addIf(pending), [&]() {
+                            pb->finalizeUnit(false, p.location(),
+                                             builder::string("backtracking outside of &try scope"));
+                            run_finally();
+                            builder()->addCall("spicy_rt::backtrack_request", {});
+                            builder()->addReturn(store_result);
+                        });
+                    }
+
                     run_finally();
+
+                    if ( pb->statusBacktracking() )
+                        popState();
+
                     popState();
 
                     builder()->addReturn(store_result);
@@ -404,6 +470,7 @@ struct ProductionVisitor
                     pstate.lahead = builder::id("__lah");
                     pstate.lahead_end = builder::id("__lahe");
                     pstate.error = builder::id("__error");
+                    pstate.backtrack_exit = BacktrackExit::Return;
 
                     std::optional<PathTracker> path_tracker;
 
@@ -475,7 +542,23 @@ struct ProductionVisitor
             args.push_back(destination());
 
         auto call = builder::memberCall(state().self, id, args);
-        builder()->addAssign(builder::tuple({state().cur, state().lahead, state().lahead_end, state().error}), call);
+        assignParseResult(call);
+    }
+
+    // Stores the result of calling a parse function in the current state.
+    // With status-based backtracking, leaves the current scope first if the
+    // call returned with a backtrack pending, keeping the state as it was.
+    void assignParseResult(const Expression& call) {
+        auto state_ = builder::tuple({state().cur, state().lahead, state().lahead_end, state().error});
+
+        if ( ! pb->statusBacktracking() ) {
+            builder()->addAssign(state_, call);
+            return;
+        }
+
+        auto result = builder()->addTmp("result", call);
+        pb->checkBacktrack();
+        builder()->addAssign(state_, result);
     }
 
     // Returns a boolean expression that's 'true' if a 'stop' was encountered.
@@ -577,9 +660,7 @@ struct ProductionVisitor
             }
 
             auto call = builder::memberCall(destination(), "__parse_stage1", args);
-            builder()->addAssign(builder::tuple(
-                                     {pb->state().cur, pb->state().lahead, pb->state().lahead_end, pb->state().error}),
-                                 call);
+            assignParseResult(call);
         }
 
         else if ( unit )
@@ -1097,8 +1178,47 @@ struct ProductionVisitor
             }
 
             case LiteralMode::Search: {
+                // If all tokens are byte literals, we can skip ahead to
+                // the next potential match in a single pass instead of
+                // retrying the look-ahead at every input position.
+                std::optional<ID> sync_matcher;
+
+                if ( regexps.empty() ) {
+                    std::vector<Expression> patterns;
+
+                    for ( const auto& p : other ) {
+                        std::optional<std::string> value;
+
+                        if ( auto c = p.tryAs<production::Ctor>() ) {
+                            auto ctor = c->ctor();
+                            if ( auto b = ctor.tryAs<hilti::ctor::Bytes>() )
+                                value = b->value();
+                        }
+
+                        if ( ! value || value->empty() ) {
+                            patterns.clear();
+                            break;
+                        }
+
+                        patterns.push_back(builder::bytes(*value));
+                    }
+
+                    if ( ! patterns.empty() ) {
+                        sync_matcher = cg()->uniquer()->get("__sync_matcher");
+                        pb->cg()->addDeclaration(
+                            builder::global(*sync_matcher,
+                                            builder::call("spicy_rt::createSyncMatcher",
+                                                          {builder::vector(hilti::type::Bytes(), std::move(patterns))}),
+                                            hilti::declaration::Linkage::Private, location));
+                    }
+                }
+
                 // Create a loop for search mode.
                 pushBuilder(builder()->addWhile(builder::bool_(true)), [&]() {
+                    if ( sync_matcher )
+                        pb->advanceInput(
+                            builder::call("spicy_rt::syncAdvance", {builder::id(*sync_matcher), state().cur}));
+
                     parse();
 
                     auto [if_, else_] = builder()->addIfElse(builder::or_(pb->atEod(), state().lahead));
@@ -1221,6 +1341,9 @@ struct ProductionVisitor
             // Sync point found, break from loop.
             builder()->addBreak();
         });
+
+        // The `%synced` hook may have requested to backtrack.
+        checkBacktrackAfterLoop();
     }
 
     // Adds a method, and its implementation, to the current parsing struct
@@ -1283,6 +1406,7 @@ struct ProductionVisitor
         // the loop bpdy needs to execute at least one time.
         auto while_ = builder()->addWhile(builder::bool_(true));
         pushBuilder(while_);
+        pushStateRaisingBacktrack();
 
         // Variable storing whether we actually entered trial mode.
         auto is_trial_mode = builder()->addTmp("is_trial_mode", builder::bool_(false));
@@ -1318,6 +1442,7 @@ struct ProductionVisitor
     /** End sync and trial mode. */
     void finishSynchronize() {
         builder()->addBreak();
+        popState();
         popBuilder(); // body.
         popBuilder(); // while_.
     }
@@ -1342,7 +1467,11 @@ struct ProductionVisitor
         // element fails to parse, we will return `n-1` elements.
         if ( auto f = p.body().meta().field(); f && AttributeSet::find(f->attributes(), "&synchronize") ) {
             auto try_ = builder()->addTry();
-            pushBuilder(try_.first, [&]() { parse(); });
+            pushBuilder(try_.first, [&]() {
+                pushStateRaisingBacktrack();
+                parse();
+                popState();
+            });
 
             pushBuilder(try_.second.addCatch(
                             builder::parameter(ID("e"), builder::typeByID("hilti::RecoverableFailure"))),
@@ -1362,6 +1491,7 @@ struct ProductionVisitor
             parse();
 
         popBuilder();
+        checkBacktrackAfterLoop();
     }
 
     void operator()(const production::Enclosure& p) {
@@ -1386,6 +1516,7 @@ struct ProductionVisitor
         b->addBreak();
         pb->finishLoopBody(cookie, p.location());
         popBuilder();
+        checkBacktrackAfterLoop();
     }
 
     void operator()(const production::Resolved& p) { parseProduction(grammar.resolved(p)); }
@@ -1542,8 +1673,12 @@ struct ProductionVisitor
                 auto try_ = builder()->addTry();
 
                 pushBuilder(try_.first, [&]() {
+                    pushStateRaisingBacktrack();
+
                     for ( auto field : fields )
                         parseField(p.fields()[field]);
+
+                    popState();
                 });
 
                 pushBuilder(try_.second.addCatch(
@@ -1791,7 +1926,11 @@ struct ProductionVisitor
                      field && field->attributes() && AttributeSet::find(field->attributes(), "&synchronize") ) {
                     auto try_ = builder()->addTry();
 
-                    pushBuilder(try_.first, [&]() { parse(); });
+                    pushBuilder(try_.first, [&]() {
+                        pushStateRaisingBacktrack();
+                        parse();
+                        popState();
+                    });
 
                     pushBuilder(try_.second.addCatch(
                                     builder::parameter(ID("e"), builder::typeByID("hilti::RecoverableFailure"))),
@@ -1824,6 +1963,8 @@ struct ProductionVisitor
                     pb->finishLoopBody(cookie, p.location());
                 });
             });
+
+            checkBacktrackAfterLoop();
         };
     }
 }; // namespace spicy::detail::codegen
@@ -1888,10 +2029,15 @@ hilti::type::Struct ParserBuilder::addParserMethods(hilti::type::Struct s, const
         AttributeSet({Attribute("&needed-by-feature", builder::string("is_filter")),
                       Attribute("&needed-by-feature", builder::string("supports_sinks")), Attribute("&static")});
 
+    // The top-level entry points may skip setting up a fiber if their input
+    // is complete already.
+    auto attr_ext_overload_top =
+        AttributeSet::add(attr_ext_overload, Attribute("&run-directly-if-frozen", builder::string("data")));
+
     auto f_ext_overload1_result = type::stream::View();
     auto f_ext_overload1 = builder::function(id_ext_overload1, f_ext_overload1_result, params,
                                              type::function::Flavor::Method, declaration::Linkage::Struct,
-                                             function::CallingConvention::Extern, attr_ext_overload, t.meta());
+                                             function::CallingConvention::Extern, attr_ext_overload_top, t.meta());
 
     auto f_ext_overload2_result = type::stream::View();
     auto f_ext_overload2 =
@@ -1917,7 +2063,7 @@ hilti::type::Struct ParserBuilder::addParserMethods(hilti::type::Struct s, const
                                               builder::optional(type::stream::View())),
                            builder::parameter("context", type::Optional(builder::typeByID("spicy_rt::UnitContext")))},
                           type::function::Flavor::Method, declaration::Linkage::Struct,
-                          function::CallingConvention::Extern, attr_ext_overload, t.meta());
+                          function::CallingConvention::Extern, attr_ext_overload_top, t.meta());
 
     auto f_ext_context_new_result = builder::typeByID("spicy_rt::UnitContext");
     auto f_ext_context_new =
@@ -1972,6 +2118,14 @@ hilti::type::Struct ParserBuilder::addParserMethods(hilti::type::Struct s, const
         HILTI_DEBUG(spicy::logging::debug::ParserBuilder, fmt("creating parser for %s", *t.id()));
         hilti::logging::DebugPushIndent _(spicy::logging::debug::ParserBuilder);
 
+        // With status-based backtracking, parsing starts without a pending
+        // request, even if a previous parse on this thread left one behind
+        // when aborting through an exception.
+        auto reset_backtrack = [&]() {
+            if ( statusBacktracking() )
+                builder()->addCall("spicy_rt::backtrack_reset", {});
+        };
+
         auto grammar = cg()->grammarBuilder()->grammar(t);
         auto visitor = ProductionVisitor(this, grammar);
 
@@ -1981,6 +2135,7 @@ hilti::type::Struct ParserBuilder::addParserMethods(hilti::type::Struct s, const
             // Create parse1() body.
             pushBuilder();
             builder()->setLocation(grammar.root()->location());
+            reset_backtrack();
             builder()->addLocal("unit", builder::value_reference(
                                             builder::default_(builder::typeByID(*t.id()),
                                                               hilti::node::transform(t.parameters(), [](const auto& p) {
@@ -2025,6 +2180,7 @@ hilti::type::Struct ParserBuilder::addParserMethods(hilti::type::Struct s, const
             // Create parse3() body.
             pushBuilder();
             builder()->setLocation(grammar.root()->location());
+            reset_backtrack();
             builder()->addLocal("unit", builder::value_reference(
                                             builder::default_(builder::typeByID(*t.id()),
                                                               hilti::node::transform(parameters, [](const auto& p) {
@@ -2074,6 +2230,7 @@ hilti::type::Struct ParserBuilder::addParserMethods(hilti::type::Struct s, const
         // Create parse2() body.
         pushBuilder();
         builder()->setLocation(grammar.root()->location());
+        reset_backtrack();
         builder()->addLocal("ncur", type::stream::View(),
                             builder::ternary(builder::id("cur"), builder::deref(builder::id("cur")),
                                              builder::cast(builder::deref(builder::id("data")), type::stream::View())));
@@ -2308,7 +2465,7 @@ void ParserBuilder::initializeUnit(const Location& l) {
     afterHook();
 }
 
-void ParserBuilder::finalizeUnit(bool success, const Location& l) {
+void ParserBuilder::finalizeUnit(bool success, const Location& l, const std::optional<Expression>& error) {
     const auto& unit = state().unit.get();
 
     saveParsePosition();
@@ -2330,7 +2487,7 @@ void ParserBuilder::finalizeUnit(bool success, const Location& l) {
         afterHook();
     }
     else {
-        auto what = builder::call("hilti::exception_what", {builder::id("__except")});
+        auto what = error ? *error : builder::call("hilti::exception_what", {builder::id("__except")});
         builder()->addMemberCall(state().self, "__on_0x25_error", {what}, l);
     }
 
@@ -2449,6 +2606,9 @@ void ParserBuilder::afterHook() {
     // TODO(bbannier): Guard this with a feature flag once
     // https://github.com/zeek/spicy/issues/1108 is fixed.
     builder()->addAssign(state().error, builder::member(state().self, ID("__error")));
+
+    // The hook may have requested to backtrack.
+    checkBacktrack();
 }
 
 void ParserBuilder::saveParsePosition() {
@@ -2478,20 +2638,67 @@ void ParserBuilder::initBacktracking() {
     auto try_cur = builder()->addTmp("try_cur", state().cur);
     auto [body, try_] = builder()->addTry();
     auto catch_ = try_.addCatch(builder::parameter(ID("e"), builder::typeByID("spicy_rt::Backtrack")));
-    pushBuilder(catch_, [&]() { builder()->addAssign(state().cur, try_cur); });
+    pushBuilder(catch_, [&]() {
+        if ( statusBacktracking() )
+            builder()->addCall("spicy_rt::backtrack_reset", {});
+
+        builder()->addAssign(state().cur, try_cur);
+    });
+
+    // With status-based backtracking, we still catch `Backtrack` exceptions
+    // for code that cannot propagate status. Everything else leaves a loop
+    // we wrap around the field once it finds a backtrack pending, which we
+    // then carry out just like the exception handler.
+    if ( statusBacktracking() )
+        pushBuilder(builder()->addIf(builder::call("spicy_rt::backtrack_take", {})),
+                    [&]() { builder()->addAssign(state().cur, try_cur); });
 
     auto pstate = state();
     pstate.trim = builder::bool_(false);
-    pushState(std::move(pstate));
     pushBuilder(body);
+
+    if ( statusBacktracking() ) {
+        pstate.backtrack_exit = BacktrackExit::Break;
+        pushBuilder(builder()->addWhile(builder::bool_(true)));
+    }
+
+    pushState(std::move(pstate));
 }
 
 void ParserBuilder::finishBacktracking() {
+    if ( statusBacktracking() ) {
+        builder()->addBreak();
+        popBuilder();
+    }
+
     popBuilder();
     popState();
     trimInput();
 }
 
+bool ParserBuilder::statusBacktracking() const {
+    return options().getAuxOption<bool>("spicy.status_backtracking", false);
+}
+
+void ParserBuilder::checkBacktrack() {
+    if ( ! statusBacktracking() )
+        return;
+
+    switch ( state().backtrack_exit ) {
+        case BacktrackExit::Raise: builder()->addCall("spicy_rt::backtrack_raise", {}); break;
+
+        case BacktrackExit::Return: {
+            auto result = builder::tuple({state().cur, state().lahead, state().lahead_end, state().error});
+            builder()->addIf(builder::call("spicy_rt::backtrack_pending", {}))->addReturn(result);
+            break;
+        }
+
+        case BacktrackExit::Break:
+            builder()->addIf(builder::call("spicy_rt::backtrack_pending", {}))->addBreak();
+            break;
+    }
+}
+
 Expression ParserBuilder::initLoopBody() { return builder()->addTmp("old_begin", builder::begin(state().cur)); }
 
 void ParserBuilder::finishLoopBody(const Expression& cookie, const Location& l) {
@@ -9,22 +9,29 @@ spicy::Options Driver::spicyCompilerOptions() const {
 
     auto hilti_options = hiltiOptions();
     options.track_offsets = hilti_options.getAuxOption<bool>("spicy.track_offsets", false);
+    options.status_backtracking = hilti_options.getAuxOption<bool>("spicy.status_backtracking", false);
     return options;
 }
 
 void Driver::setSpicyCompilerOptions(const spicy::Options& options) {
     auto hilti_options = hiltiOptions();
     hilti_options.setAuxOption("spicy.track_offsets", options.track_offsets);
+    hilti_options.setAuxOption("spicy.status_backtracking", options.status_backtracking);
     setCompilerOptions(std::move(hilti_options));
 }
 
-std::string Driver::hookAddCommandLineOptions() { return "Q"; }
+std::string Driver::hookAddCommandLineOptions() { return "Qb"; }
+
+std::vector<std::pair<std::string, int>> Driver::hookAddLongCommandLineOptions() {
+    return {{"include-offsets", 'Q'}, {"status-backtracking", 'b'}};
+}
 
 bool Driver::hookProcessCommandLineOption(int opt, const char* optarg) {
     auto hilti_options = hiltiOptions();
 
     switch ( opt ) {
         case 'Q': hilti_options.setAuxOption("spicy.track_offsets", true); break;
+        case 'b': hilti_options.setAuxOption("spicy.status_backtracking", true); break;
         default: return false;
     }
 
@@ -33,5 +40,6 @@ bool Driver::hookProcessCommandLineOption(int opt, const char* optarg) {
 }
 
 std::string Driver::hookAugmentUsage() {
-    return "  -Q | --include-offsets          Include stream offsets of parsed data in output.\n";
+    return "  -Q | --include-offsets          Include stream offsets of parsed data in output.\n"
+           "  -b | --status-backtracking      Have generated parsers backtrack without throwing exceptions.\n";
 }